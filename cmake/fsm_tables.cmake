@@ -0,0 +1,39 @@
+# Build-time FSM topology compiler.
+#
+# Runs scripts/generate_fsm_tables.py over the UI descriptions and adds the
+# generated fsm_tables.c / fsm_tables.h to the app target. Graph errors
+# (dangling or unreachable nodes, tap counts above MAX_NAV_SLOTS) fail the build.
+#
+# Usage (after find_package(Zephyr)):
+#   include(${ZBEAM_ROOT}/cmake/fsm_tables.cmake)
+#   zbeam_fsm_tables(src/ui_simple.yaml src/ui_advanced.yaml)
+
+set(ZBEAM_FSM_TABLES_SCRIPT ${CMAKE_CURRENT_LIST_DIR}/../scripts/generate_fsm_tables.py)
+
+function(zbeam_fsm_tables)
+    set(gen_dir ${CMAKE_CURRENT_BINARY_DIR}/generated)
+    set(gen_h ${gen_dir}/fsm_tables.h)
+    set(gen_c ${gen_dir}/fsm_tables.c)
+
+    set(ui_files)
+    foreach(ui ${ARGN})
+        get_filename_component(ui_abs ${ui} ABSOLUTE)
+        list(APPEND ui_files ${ui_abs})
+    endforeach()
+
+    add_custom_command(
+        OUTPUT ${gen_h} ${gen_c}
+        COMMAND ${PYTHON_EXECUTABLE} ${ZBEAM_FSM_TABLES_SCRIPT}
+                --max-slots ${CONFIG_ZBEAM_MAX_NAV_SLOTS}
+                --header ${gen_h}
+                --source ${gen_c}
+                ${ui_files}
+        DEPENDS ${ZBEAM_FSM_TABLES_SCRIPT} ${ui_files}
+        COMMENT "Generating FSM tables"
+    )
+    add_custom_target(zbeam_fsm_tables DEPENDS ${gen_h} ${gen_c})
+    add_dependencies(app zbeam_fsm_tables)
+
+    target_sources(app PRIVATE ${gen_c})
+    target_include_directories(app PRIVATE ${gen_dir})
+endfunction()
@@ -0,0 +1,59 @@
+/**
+ * @file blink_seq.h
+ * @brief Non-blocking blink-code sequencer.
+ *
+ * Plays battcheck/tempcheck style blink codes (N major blinks, a pause,
+ * M minor blinks) and short feedback flashes through the LED pattern
+ * engine instead of k_msleep() loops, so the FSM worker keeps handling
+ * input while a readout is in progress and a new action can abort it.
+ * The output stage is the one set with led_pattern_init().
+ */
+
+#ifndef BLINK_SEQ_H
+#define BLINK_SEQ_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define BLINK_ON_MS   100  /**< Lit time per blink */
+#define BLINK_OFF_MS  300  /**< Dark time after each blink */
+#define BLINK_GAP_MS  800  /**< Extra pause between major and minor groups */
+
+/** @brief Completion callback; not called when aborted. */
+typedef void (*blink_done_t)(void);
+
+/**
+ * @brief Play a two-group blink code, replacing any pattern in progress.
+ *
+ * A group of 0 blinks is skipped (the pause is still observed).
+ *
+ * @param major Blinks in the first group.
+ * @param minor Blinks in the second group.
+ * @param level Brightness of each blink.
+ * @param done Called (on the FSM worker) after the last blink, or NULL.
+ * @return 0 on success, -ENODEV if no output is set.
+ */
+int blink_seq_play_code(uint8_t major, uint8_t minor, uint8_t level, blink_done_t done);
+
+/**
+ * @brief Show @p level for @p duration_ms (max 65535), then call @p done.
+ *
+ * Used for short feedback blinks; @p done typically restores the
+ * previous output level.
+ * @return 0 on success, -ENODEV if no output is set.
+ */
+int blink_seq_flash(uint8_t level, uint32_t duration_ms, blink_done_t done);
+
+/**
+ * @brief Stop the current sequence immediately without calling done.
+ *
+ * No effect if another pattern (e.g. a strobe) is playing.
+ */
+void blink_seq_abort(void);
+
+/**
+ * @brief Check whether a sequence is playing.
+ */
+bool blink_seq_is_active(void);
+
+#endif /* BLINK_SEQ_H */
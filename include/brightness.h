@@ -0,0 +1,64 @@
+/**
+ * @file brightness.h
+ * @brief Fixed-point brightness carried from the UI to the PWM write.
+ *
+ * A brightness_t is a perceptual ramp level in 8.8 fixed point: the
+ * integer part is the 0-255 level the UI and NVS use, the fraction lets
+ * smooth ramps and throttling move between levels. It only becomes a duty
+ * at the output, through the gamma-corrected ramp table, interpolating
+ * between neighbouring entries so sub-level steps use the table's full
+ * (13-bit) resolution.
+ */
+
+#ifndef BRIGHTNESS_H
+#define BRIGHTNESS_H
+
+#include <stdint.h>
+#include "ramp_table.h"
+
+typedef uint16_t brightness_t;
+
+#define BRIGHTNESS_FRAC_BITS 8
+#define BRIGHTNESS_FRAC_MASK ((1U << BRIGHTNESS_FRAC_BITS) - 1)
+
+/** @brief Whole 0-255 level as a brightness. */
+#define BRIGHTNESS_FROM_LEVEL(_level) ((brightness_t)((_level) << BRIGHTNESS_FRAC_BITS))
+
+/** @brief Whole level of a brightness (fraction dropped). */
+#define BRIGHTNESS_LEVEL(_b) ((uint8_t)((_b) >> BRIGHTNESS_FRAC_BITS))
+
+#define BRIGHTNESS_MAX BRIGHTNESS_FROM_LEVEL(255)
+
+/**
+ * @brief Duty for a brightness through a given ramp table.
+ *
+ * Any non-zero brightness gets at least a duty of 1, so the bottom of the
+ * ramp (where the table rounds to 0) still lights the emitter.
+ *
+ * @param table RAMP_TABLE_SIZE entries scaled to RAMP_TABLE_MAX_DUTY
+ * @return Duty in ramp table units (0 to RAMP_TABLE_MAX_DUTY).
+ */
+static inline uint16_t brightness_to_duty_table(const uint16_t *table, brightness_t b)
+{
+    uint8_t i = BRIGHTNESS_LEVEL(b);
+    uint32_t frac = b & BRIGHTNESS_FRAC_MASK;
+    uint32_t duty = table[i];
+
+    if (frac != 0 && i < RAMP_TABLE_SIZE - 1) {
+        duty += ((table[i + 1] - duty) * frac) >> BRIGHTNESS_FRAC_BITS;
+    }
+    if (duty == 0 && b != 0) {
+        duty = 1;
+    }
+    return duty;
+}
+
+/**
+ * @brief Gamma-corrected duty for a brightness (default ramp table).
+ */
+static inline uint16_t brightness_to_duty(brightness_t b)
+{
+    return brightness_to_duty_table(pwm_ramp_table, b);
+}
+
+#endif /* BRIGHTNESS_H */
@@ -2,7 +2,9 @@
 #define CHANNEL_MANAGER_H
 
 #include <stdint.h>
+#include <stdbool.h>
 #include <zephyr/drivers/pwm.h>
+#include "brightness.h"
 
 typedef enum {
     CHANNEL_MODE_SINGLE = 0,    /* One emitter only */
@@ -20,14 +22,115 @@ typedef enum {
 void channel_init(void);
 
 /**
- * @brief Apply brightness level to all mapped channels based on current mode
- * @param master_level 0-255 brightness level
+ * @brief Apply brightness to all mapped channels based on current mode
+ *
+ * Throttles, converts to a gamma-corrected duty (interpolated between
+ * ramp table entries) and splits that duty across the emitters.
+ * Equivalent to channel_stage_mix() followed by channel_commit().
+ *
+ * When every emitter has a max-current-ma, the mix is constant-power:
+ * a level maps to a share of the group's full-scale current, split
+ * across the emitters by mode, and the total is capped by the current
+ * budget (thermal and supply limits) instead of throttling the level.
+ *
+ * @param master_level 8.8 fixed-point brightness
  */
-void channel_apply_mix(uint8_t master_level);
+void channel_apply_mix(brightness_t master_level);
+
+/**
+ * @brief Stage brightness for all emitters without touching the hardware
+ *
+ * Mixes as channel_apply_mix() does. A later stage replaces this one.
+ *
+ * @param master_level 8.8 fixed-point brightness
+ */
+void channel_stage_mix(brightness_t master_level);
+
+/**
+ * @brief Apply the staged duties to all emitters together
+ *
+ * The emitters of each PWM controller are written back-to-back, between
+ * channel_sync_hold() and channel_sync_release() with
+ * CONFIG_ZBEAM_CHANNEL_SYNC_HOLD, so a tint change never shows as one
+ * channel a period ahead of the other. Emitters already at their staged
+ * pulse are not written. Commits are serialized by a mutex and the PWM
+ * drivers are called with interrupts enabled (they may sleep), so call
+ * this from a thread, never an ISR.
+ *
+ * @return 0 on success, or the first PWM driver error.
+ */
+int channel_commit(void);
+
+/**
+ * @brief Whether the mix runs against a current budget
+ *
+ * True when every emitter has a max-current-ma. Only then does
+ * channel_set_supply_mv() use its samples.
+ */
+bool channel_budget_enabled(void);
+
+/**
+ * @brief Feed a battery voltage sample to the current budget
+ *
+ * Below CONFIG_ZBEAM_CHANNEL_DERATE_MV the budget shrinks linearly, to
+ * 1/8 at CONFIG_ZBEAM_VOLTAGE_MIN_MV. It drops at once and recovers a
+ * step per sample, as the reading rises again when the load is cut.
+ * Ignored without emitter currents.
+ *
+ * @param mv Battery voltage in mV
+ */
+void channel_set_supply_mv(uint16_t mv);
 
 /**
  * @brief Switch to next available channel mode
  */
 void channel_cycle_mode(void);
 
+/**
+ * @brief Output stage counters.
+ *
+ * Once a mix is staged, writes + elided == emitters * channel_commit() calls.
+ */
+struct channel_stats {
+    uint32_t applies;     /**< Mixes staged (channel_apply_mix() included) */
+    uint32_t recomputes;  /**< Mixes that recomputed the pulse cache */
+    uint32_t limited;     /**< Recomputed mixes cut down to the current budget */
+    uint32_t commits;     /**< Commits that wrote at least one emitter */
+    uint32_t writes;      /**< PWM driver calls made */
+    uint32_t elided;      /**< PWM driver calls skipped: pulse unchanged */
+};
+
+/**
+ * @brief Read the output stage counters.
+ * @return 0 on success, -EINVAL on bad arguments.
+ */
+int channel_get_stats(struct channel_stats *stats);
+
+/**
+ * @brief Clear the output stage counters.
+ */
+void channel_reset_stats(void);
+
+/*
+ * Shadow register glue (CONFIG_ZBEAM_CHANNEL_SYNC_HOLD), provided by the
+ * SoC support: the PWM API has no notion of a controller-wide update.
+ * The channel manager's weak defaults hold nothing (-ENOTSUP).
+ */
+
+/**
+ * @brief Hold the update event of a PWM controller.
+ *
+ * Called from channel_commit(), in thread context with commits
+ * serialized. Channel writes made until channel_sync_release() latch
+ * together.
+ *
+ * @return 0 if held, negative errno to fall back to plain writes.
+ */
+int channel_sync_hold(const struct device *pwm);
+
+/**
+ * @brief Let the held writes latch at the next period boundary.
+ */
+void channel_sync_release(const struct device *pwm);
+
 #endif
@@ -1,9 +1,13 @@
 /**
  * @file fsm_engine.h
  * @brief Finite State Machine Engine for ZBeam.
- * 
+ *
  * Defines the core node structure and the engine API to process inputs
  * and manage state transitions.
+ *
+ * Nodes are const and live in flash. Transitions are stored as uint8_t
+ * node IDs and callbacks as uint8_t callback IDs, both resolved through an
+ * ID-indexed struct fsm_table registered at fsm_init().
  */
 
 #ifndef FSM_ENGINE_H
@@ -12,18 +16,21 @@
 #include <zephyr/kernel.h>
 #include "zbeam_msg.h"
 
-// Maximum number of taps to index in the transition arrays
+// Upper bound on the click/hold slot tables of a single node.
 // Index 0 = 1 tap, Index 4 = 5 taps.
-#define MAX_NAV_SLOTS CONFIG_ZBEAM_MAX_NAV_SLOTS 
+#define MAX_NAV_SLOTS CONFIG_ZBEAM_MAX_NAV_SLOTS
 
 /**
- * @brief Serialized configuration data for a node (NVS friendly).
+ * @brief Reserved ID meaning "no target node" / "no callback".
+ *
+ * ID 0 is never a real node or callback, so zero-initialised fields in a
+ * node definition read as "not mapped".
  */
-struct node_config_data {
-    uint8_t target_click_ids[MAX_NAV_SLOTS]; ///< Enum IDs of target nodes for clicks
-    uint8_t target_hold_ids[MAX_NAV_SLOTS];  ///< Enum IDs of target nodes for holds
-    uint32_t timeout_ms;                     ///< Inactivity timeout duration
-};
+#define FSM_NONE 0
+
+/* Node flags */
+#define FSM_NODE_TIMEOUT_REVERTS BIT(0) ///< Timeout returns to PREVIOUS node instead of Home
+#define FSM_NODE_MOMENTARY       BIT(1) ///< Output follows the button via the momentary fast path
 
 struct fsm_node; // Forward decl
 
@@ -32,69 +39,233 @@ struct fsm_node; // Forward decl
  * @param self The current node.
  * @return NULL to stay/continue normal processing, or a pointer to a new node to force a transition.
  */
-typedef struct fsm_node* (*fsm_callback_t)(struct fsm_node *self, int count);
+typedef const struct fsm_node *(*fsm_callback_t)(const struct fsm_node *self, int count);
+
+/**
+ * @brief One click/hold slot: callback ID (run first) and target node ID.
+ */
+struct fsm_slot {
+    uint8_t target;   ///< Node ID to transition to (FSM_NONE = ignore)
+    uint8_t callback; ///< Callback ID to run before the lookup (FSM_NONE = none)
+};
+
+/**
+ * @brief Click/hold tables for one extra input source (tail, side...).
+ *
+ * The node's own tables serve INPUT_SRC_MAIN. Other sources only do
+ * what their map says: no map, or no slot, means the event is ignored
+ * (the any_click/any_hold fallbacks are main-button only).
+ */
+struct fsm_input_map {
+    const struct fsm_slot *clicks;
+    const struct fsm_slot *holds;
+    uint8_t source;                    ///< enum zbeam_input_source
+    uint8_t click_count;               ///< Length of clicks[]
+    uint8_t hold_count;                ///< Length of holds[]
+};
 
 /**
- * @brief Runtime FSM Node definition.
+ * @brief Flash-resident FSM Node definition.
+ *
+ * Slot tables are packed: they are only as long as the highest tap count
+ * the node actually maps, so a lookup is a single bounds check + index.
  */
 struct fsm_node {
-    uint8_t id;                        // Unique Enum ID (0 to NODE_COUNT-1)
     const char *name;                  // Name for debugging (e.g., "ON", "OFF")
     void (*action_routine)(void);      // Function to execute when entering this state
-    
+
     // Navigation Tables
     // If the user performs N taps, we look at index [N-1].
-    // If the entry is NULL, the input is ignored (no transition).
-    struct fsm_node *click_map[MAX_NAV_SLOTS]; 
-    struct fsm_node *hold_map[MAX_NAV_SLOTS];
-    
-    // Callbacks (Optional) - Run before map lookup
-    fsm_callback_t click_callbacks[MAX_NAV_SLOTS];
-    fsm_callback_t hold_callbacks[MAX_NAV_SLOTS];
-    
-    // Release Callback: Triggered when a HOLD is released
-    fsm_callback_t release_callback;
-
-    // Generic Callbacks (Called if count > MAX_NAV_SLOTS or no specific map exists)
-    fsm_callback_t any_click_callback;
-    fsm_callback_t any_hold_callback;
-
-    uint32_t timeout_ms;               // Milliseconds of inactivity to return to Home (0 = never)
-    bool timeout_reverts;              // If true, timeout returns to PREVIOUS node instead of Home.
-    struct fsm_node *timeout_node;     // If set, timeout transitions here instead of Home/Previous.
+    // If N exceeds the table length or the slot is empty, the generic callback is tried.
+    const struct fsm_slot *clicks;
+    const struct fsm_slot *holds;
+    const struct fsm_input_map *inputs; // Maps for the other input sources
+
+    uint16_t timeout_ms;               // Milliseconds of inactivity to return to Home (0 = never)
+    uint8_t id;                        // Unique node ID (index into fsm_table.nodes)
+    uint8_t click_count;               // Length of clicks[]
+    uint8_t hold_count;                // Length of holds[]
+    uint8_t input_count;               // Length of inputs[]
+
+    // Callback IDs (FSM_NONE = unused)
+    uint8_t release_callback;          // Triggered when a HOLD is released
+    uint8_t any_click_callback;        // Called if count is out of range or no specific slot exists
+    uint8_t any_hold_callback;
+    uint8_t encoder_callback;          // Called with the encoder delta as count
+
+    uint8_t timeout_node;              // If set, timeout transitions here instead of Home/Previous.
+    uint8_t flags;                     // FSM_NODE_* flags
 };
 
+/**
+ * @brief ID-indexed lookup tables shared by every node of a UI.
+ */
+struct fsm_table {
+    const struct fsm_node *const *nodes;  ///< Indexed by node ID
+    const fsm_callback_t *callbacks;      ///< Indexed by callback ID
+    uint8_t node_count;
+    uint8_t callback_count;
+};
+
+/* ========== Node Definition Helpers ========== */
+
+/** @brief Slot that only transitions to a node. */
+#define FSM_GOTO(node_id)          { .target = (node_id), .callback = FSM_NONE }
+/** @brief Slot that only runs a callback. */
+#define FSM_CALL(cb_id)            { .target = FSM_NONE, .callback = (cb_id) }
+/** @brief Slot that runs a callback, then transitions if the callback returned NULL. */
+#define FSM_SLOT(node_id, cb_id)   { .target = (node_id), .callback = (cb_id) }
+
+/**
+ * @brief Define a node's click table with designated initializers.
+ *
+ * The compound literal is sized by its highest index, so
+ * FSM_CLICKS([0] = ..., [3] = ...) occupies exactly 4 slots in flash.
+ */
+#define FSM_CLICKS(...) \
+    .clicks = (const struct fsm_slot[]){ __VA_ARGS__ }, \
+    .click_count = ARRAY_SIZE(((const struct fsm_slot[]){ __VA_ARGS__ }))
+
+/** @brief Define a node's hold table (see FSM_CLICKS). */
+#define FSM_HOLDS(...) \
+    .holds = (const struct fsm_slot[]){ __VA_ARGS__ }, \
+    .hold_count = ARRAY_SIZE(((const struct fsm_slot[]){ __VA_ARGS__ }))
+
+/**
+ * @brief Define a node's per-source maps.
+ *
+ * FSM_CLICKS()/FSM_HOLDS() work inside each map:
+ * FSM_INPUTS({ .source = INPUT_SRC_TAIL, FSM_CLICKS([0] = ...) }).
+ */
+#define FSM_INPUTS(...) \
+    .inputs = (const struct fsm_input_map[]){ __VA_ARGS__ }, \
+    .input_count = ARRAY_SIZE(((const struct fsm_input_map[]){ __VA_ARGS__ }))
+
 /**
  * @brief Get the current active node.
  */
-struct fsm_node *fsm_get_current_node(void);
+const struct fsm_node *fsm_get_current_node(void);
+
+/**
+ * @brief Resolve a node ID through the registered table.
+ * @return The node, or NULL for FSM_NONE / out-of-range IDs.
+ */
+const struct fsm_node *fsm_get_node(uint8_t id);
+
+/**
+ * @brief Speculative output shown at the first key-down of a sequence.
+ *
+ * The UI lights the emitter before the sequence is known; the engine
+ * calls revert() if the main-button tap or hold then resolves without any
+ * transition (so no node action took over the output). Messages from
+ * other sources in between do not settle it.
+ */
+struct fsm_preview {
+    /** Show the preview for @p node; return false if it does not apply. */
+    bool (*begin)(const struct fsm_node *node);
+    /** Undo the preview; the sequence did nothing on @p node. */
+    void (*revert)(const struct fsm_node *node);
+};
+
+/**
+ * @brief Register (or clear with NULL) the press preview handlers.
+ */
+void fsm_set_preview(const struct fsm_preview *preview);
+
+/**
+ * @brief Start a preview for the current node. Called at the first
+ *        key-down of a sequence, on the FSM worker.
+ */
+void fsm_preview_press(void);
+
+/**
+ * @brief Momentary fast path for nodes flagged FSM_NODE_MOMENTARY.
+ *
+ * While such a node is current, key edges drive the output straight from
+ * the input callback, before the FSM worker sees them. The worker still
+ * receives every edge, so the node's taps and holds work as usual.
+ */
+struct fsm_momentary {
+    /** Entered @p node (on the worker): precompute the output for edge(). */
+    void (*arm)(const struct fsm_node *node);
+    /** Write the precomputed output for a key edge; runs in input context,
+     *  under the engine's momentary lock. */
+    void (*edge)(bool pressed);
+};
+
+/**
+ * @brief Register (or clear with NULL) the momentary fast path handlers.
+ */
+void fsm_set_momentary(const struct fsm_momentary *momentary);
+
+/**
+ * @brief Run the momentary fast path for one raw key edge.
+ *
+ * Safe to call from the input callback in thread context. The output write
+ * is serialized with transitions: an edge racing a node change either
+ * lands before the new node's action or not at all. Does nothing unless
+ * the current node is flagged FSM_NODE_MOMENTARY and a fast path is
+ * registered.
+ *
+ * @param pressed true on key-down, false on key-up.
+ * @return true if the fast path wrote the output.
+ */
+bool fsm_momentary_edge(bool pressed);
+
+/**
+ * @brief Check whether the current node could use a longer tap sequence.
+ *
+ * After @p count completed taps, another press can only become a tap of
+ * count+1 or more, or a hold of count+1 or more. Returns false when the
+ * current node maps none of these for @p source (no slot beyond @p count
+ * and, for the main button, no any_click/any_hold fallback), so the tap
+ * can be committed immediately.
+ *
+ * @param source enum zbeam_input_source of the sequence.
+ * @param count Taps completed so far.
+ * @return true if waiting for more taps can change the outcome.
+ */
+bool fsm_input_can_continue(uint8_t source, int count);
 
 /**
  * @brief Initialize the FSM with a starting node (usually OFF).
+ * @param table ID-indexed node and callback tables.
  * @param start_node Pointer to the initial state.
  */
-void fsm_init(struct fsm_node *start_node);
+void fsm_init(const struct fsm_table *table, const struct fsm_node *start_node);
 
 /**
  * @brief Force a transition to a specific node (e.g. from a timer/callback).
  */
-void fsm_transition_to(struct fsm_node *next_node);
+void fsm_transition_to(const struct fsm_node *next_node);
+
+/**
+ * @brief Restart the current node's inactivity timeout from now.
+ *
+ * For actions that finish asynchronously (e.g. a blink readout), so the
+ * node's timeout counts from the end of the output rather than its start.
+ */
+void fsm_restart_timeout(void);
 
 /**
  * @brief Process an input message from the worker thread.
- * @param msg Input message (TAP, HOLD_START, HOLD_RELEASE).
+ *
+ * Taps and holds are looked up in the map for msg->source. ENCODER runs
+ * the node's encoder callback with the signed delta as its count.
+ *
+ * @param msg Input message (TAP, HOLD_START, HOLD_RELEASE, ENCODER).
  */
 void fsm_process_msg(const struct zbeam_msg *msg);
 
 /**
  * @brief Process a timer message from the worker thread.
- * @param msg Timer message (INACTIVITY, RAMP_TICK).
+ * @param msg Timer message (INACTIVITY).
  */
 void fsm_process_timer(const struct zbeam_msg *msg);
 
 /**
  * @brief Emergency off - immediate LED shutdown.
- * 
+ *
  * Called when safety monitor triggers shutdown.
  * Stops all timers and forces LED to off state.
  */
@@ -0,0 +1,110 @@
+/**
+ * @file fsm_sched.h
+ * @brief Deadline Scheduler API.
+ *
+ * Single sorted list of software deadlines serviced by the FSM worker
+ * thread. Replaces per-module k_timers: expiry callbacks run in thread
+ * context, one at a time, so the FSM and the UI state it drives never
+ * race a timer ISR. Deadlines that fall due together are serviced in a
+ * single worker wakeup.
+ */
+
+#ifndef FSM_SCHED_H
+#define FSM_SCHED_H
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/slist.h>
+
+struct fsm_deadline;
+
+/**
+ * @brief Deadline expiry callback (runs on the FSM worker thread).
+ */
+typedef void (*fsm_deadline_fn)(struct fsm_deadline *dl);
+
+/**
+ * @brief A one-shot or periodic deadline.
+ *
+ * Treat as opaque; define with FSM_DEADLINE_DEFINE() or initialise with
+ * fsm_deadline_init().
+ */
+struct fsm_deadline {
+    sys_snode_t node;
+    int64_t expiry_ms;    /**< Absolute uptime of the next expiry */
+    uint32_t period_ms;   /**< Reload period, 0 = one-shot */
+    fsm_deadline_fn fn;
+    bool armed;
+};
+
+#define FSM_DEADLINE_INITIALIZER(_fn) { .fn = (_fn) }
+
+/**
+ * @brief Statically define a deadline bound to @p _fn.
+ */
+#define FSM_DEADLINE_DEFINE(_name, _fn) \
+    struct fsm_deadline _name = FSM_DEADLINE_INITIALIZER(_fn)
+
+/**
+ * @brief Initialise a deadline. Must not be armed.
+ */
+void fsm_deadline_init(struct fsm_deadline *dl, fsm_deadline_fn fn);
+
+/**
+ * @brief Arm (or re-arm) a deadline.
+ *
+ * Thread-safe. Re-arming an armed deadline moves it.
+ *
+ * @param dl Deadline to arm.
+ * @param delay_ms Time until the first expiry (0 = due immediately).
+ * @param period_ms Reload period, 0 for one-shot.
+ */
+void fsm_deadline_start(struct fsm_deadline *dl, uint32_t delay_ms, uint32_t period_ms);
+
+/**
+ * @brief Arm (or re-arm) a one-shot deadline at an absolute uptime.
+ *
+ * Lets callers chaining one-shots (e.g. pattern playback) schedule from
+ * the previous expiry instead of from now, so handling latency does not
+ * accumulate. An expiry in the past is due immediately.
+ */
+void fsm_deadline_start_at(struct fsm_deadline *dl, int64_t expiry_ms);
+
+/**
+ * @brief Disarm a deadline. Safe to call when not armed.
+ */
+void fsm_deadline_stop(struct fsm_deadline *dl);
+
+/**
+ * @brief Check whether a deadline is armed.
+ */
+bool fsm_deadline_is_armed(const struct fsm_deadline *dl);
+
+/**
+ * @brief Get the earliest armed deadline (e.g. for tickless sleep).
+ *
+ * @param expiry_ms Set to the absolute uptime (ms) of the next expiry.
+ * @return 0 on success, -ENOENT if nothing is armed.
+ */
+int fsm_sched_next_deadline(int64_t *expiry_ms);
+
+/**
+ * @brief Time the worker may sleep before the next deadline is due.
+ * @return K_FOREVER when nothing is armed.
+ */
+k_timeout_t fsm_sched_next_timeout(void);
+
+/**
+ * @brief Run every deadline that is due. Called by the FSM worker.
+ * @return Number of callbacks run.
+ */
+int fsm_sched_run_expired(void);
+
+/**
+ * @brief Set the semaphore given when a new earliest deadline is armed.
+ *
+ * The FSM worker binds its wake semaphore here so that arming from
+ * another thread shortens the worker's current sleep.
+ */
+void fsm_sched_set_wake_sem(struct k_sem *sem);
+
+#endif /* FSM_SCHED_H */
@@ -0,0 +1,86 @@
+/**
+ * @file fsm_trace.h
+ * @brief Binary FSM trace ring buffer.
+ *
+ * Records FSM events as fixed 8-byte entries with no string formatting,
+ * so tracing stays cheap and works with CONFIG_LOG=n. The buffer is
+ * dumped as hex over the console (fsm_trace_dump() or the "fsmtrace"
+ * shell command) and decoded on the host by scripts/decode_fsm_trace.py.
+ *
+ * Compiles to no-ops unless CONFIG_ZBEAM_FSM_TRACE is set.
+ */
+
+#ifndef FSM_TRACE_H
+#define FSM_TRACE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Trace event codes.
+ *
+ * Keep in sync with EVENTS in scripts/decode_fsm_trace.py.
+ */
+enum fsm_trace_event {
+    FSM_TRACE_INIT,           /**< fsm_init(): to = start node */
+    FSM_TRACE_TAP,            /**< Tap dispatched on 'from' (count = taps) */
+    FSM_TRACE_HOLD,           /**< Hold dispatched on 'from' (count = taps) */
+    FSM_TRACE_RELEASE,        /**< Hold release dispatched on 'from' */
+    FSM_TRACE_TRANSITION,     /**< 'from' -> 'to' */
+    FSM_TRACE_TIMEOUT,        /**< Node timeout expired on 'from' */
+    FSM_TRACE_EMERGENCY_OFF,  /**< Emergency off: 'from' -> home ('to') */
+    FSM_TRACE_INPUT,          /**< Raw input: 'from' = source, count = level or detents */
+};
+
+/**
+ * @brief One trace record (8 bytes, little-endian on the wire).
+ */
+struct fsm_trace_entry {
+    uint32_t uptime_ms;  /**< k_uptime_get_32() */
+    uint8_t event;       /**< enum fsm_trace_event */
+    uint8_t from;        /**< Node ID (FSM_NONE if none) */
+    uint8_t to;          /**< Node ID (FSM_NONE if none) */
+    uint8_t count;       /**< Tap count for input events */
+};
+
+#ifdef CONFIG_ZBEAM_FSM_TRACE
+
+/**
+ * @brief Append one entry, overwriting the oldest when full.
+ *
+ * Lock-free and ISR-safe: one atomic increment plus an 8-byte store.
+ */
+void fsm_trace_record(uint8_t event, uint8_t from, uint8_t to, uint8_t count);
+
+/**
+ * @brief Copy buffered entries, oldest first.
+ *
+ * @param buf Destination.
+ * @param max Capacity of @p buf in entries.
+ * @return Number of entries copied.
+ */
+size_t fsm_trace_read(struct fsm_trace_entry *buf, size_t max);
+
+/**
+ * @brief Number of entries lost to wrap-around since the last clear.
+ */
+uint32_t fsm_trace_overwritten(void);
+
+/**
+ * @brief Discard all entries.
+ */
+void fsm_trace_clear(void);
+
+/**
+ * @brief Print the buffer as "FSMTRACE <hex>" lines via printk.
+ */
+void fsm_trace_dump(void);
+
+#else
+
+static inline void fsm_trace_record(uint8_t event, uint8_t from, uint8_t to,
+                                    uint8_t count) { }
+
+#endif /* CONFIG_ZBEAM_FSM_TRACE */
+
+#endif /* FSM_TRACE_H */
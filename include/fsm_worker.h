@@ -2,7 +2,7 @@
  * @file fsm_worker.h
  * @brief FSM Worker Thread API.
  *
- * The FSM worker thread owns the message queue and dispatches
+ * The FSM worker thread owns the message lanes and dispatches
  * all events to the FSM engine in a safe, non-ISR context.
  */
 
@@ -13,20 +13,88 @@
 #include "zbeam_msg.h"
 
 /**
- * @brief Post a message to the FSM worker queue.
+ * @brief Worker message lanes, drained in strict priority order.
+ */
+enum fsm_lane {
+    FSM_LANE_SAFETY,        /**< Safety/system events (highest priority) */
+    FSM_LANE_INPUT,         /**< Button input events */
+    FSM_LANE_EDGE,          /**< Raw key edges (lock-free ring, see spsc_ring.h) */
+    FSM_LANE_HOUSEKEEPING,  /**< Timer events */
+    FSM_LANE_COUNT,
+};
+
+/**
+ * @brief Per-lane queue statistics.
+ */
+struct fsm_lane_stats {
+    uint32_t posted;      /**< Messages accepted since reset */
+    uint32_t dropped;     /**< Messages rejected because the lane was full */
+    uint16_t depth;       /**< Messages currently queued */
+    uint16_t high_water;  /**< Peak depth since reset */
+};
+
+/**
+ * @brief Worker-wide message counters.
  *
- * Thread-safe and ISR-safe (non-blocking).
+ * received == processed + coalesced + (messages still queued).
+ */
+struct fsm_worker_stats {
+    uint32_t received;   /**< Messages accepted by fsm_worker_post_msg() */
+    uint32_t processed;  /**< Messages dispatched after coalescing */
+    uint32_t coalesced;  /**< Messages folded into a neighbour */
+    uint32_t wakeups;    /**< Worker wakeups (each drains all pending work) */
+    uint32_t deadlines;  /**< Deadline callbacks run (see fsm_sched.h) */
+};
+
+/**
+ * @brief Post a message to the FSM worker.
+ *
+ * Thread-safe and ISR-safe (non-blocking). The message is routed to its
+ * lane by type. MSG_SAFETY_SHUTDOWN and MSG_SYSTEM_SHUTDOWN use a reserved
+ * slot and are always accepted.
  *
  * @param msg Pointer to message to post.
- * @return 0 on success, -ENOMSG if queue full.
+ * @return 0 on success, -ENOMSG if the lane is full.
  */
 int fsm_worker_post_msg(const struct zbeam_msg *msg);
 
 /**
- * @brief Get the message queue (for testing/injection).
- * @return Pointer to the k_msgq.
+ * @brief Post a raw key edge through the lock-free edge ring.
+ *
+ * The ring has a single producer: calls must never overlap. The input
+ * engine posts from its input callback only. The worker is only woken
+ * when it had drained the ring; otherwise the post is a slot copy and an
+ * atomic store. Edges are drained after the input lane, so taps already
+ * resolved from earlier edges are dispatched first.
+ *
+ * @param edge MSG_INPUT_EDGE message.
+ * @return 0 on success, -ENOMSG if the ring is full.
+ */
+int fsm_worker_post_edge(const struct zbeam_msg *edge);
+
+/**
+ * @brief Get a lane's message queue (for testing/injection).
+ * @return Pointer to the k_msgq, or NULL for an invalid lane or the
+ *         ring-backed FSM_LANE_EDGE.
+ */
+struct k_msgq *fsm_worker_get_queue(enum fsm_lane lane);
+
+/**
+ * @brief Read a lane's depth/drop counters.
+ * @return 0 on success, -EINVAL on bad arguments.
+ */
+int fsm_worker_get_lane_stats(enum fsm_lane lane, struct fsm_lane_stats *stats);
+
+/**
+ * @brief Read the worker-wide message, wakeup and deadline counters.
+ * @return 0 on success, -EINVAL on bad arguments.
+ */
+int fsm_worker_get_stats(struct fsm_worker_stats *stats);
+
+/**
+ * @brief Clear all counters and restart high-water tracking.
  */
-struct k_msgq *fsm_worker_get_queue(void);
+void fsm_worker_reset_stats(void);
 
 /**
  * @brief Check if worker thread is running.
@@ -0,0 +1,112 @@
+/**
+ * @file latency_stats.h
+ * @brief Input-to-photon latency instrumentation.
+ *
+ * Messages carry the cycle count of their origin (GPIO edge for input,
+ * post time otherwise). The FSM worker brackets each dispatch with
+ * latency_stats_begin()/latency_stats_end() and the output stage calls
+ * latency_stats_mark_output() after writing PWM, so every message type
+ * gets two histograms: origin -> dispatch and origin -> first PWM write.
+ * Writes from the momentary fast path bypass the worker and are kept in
+ * their own histogram under MSG_INPUT_EDGE, stamped from the key edge.
+ *
+ * Compiles to no-ops unless CONFIG_ZBEAM_LATENCY_STATS is set.
+ */
+
+#ifndef LATENCY_STATS_H
+#define LATENCY_STATS_H
+
+#include <zephyr/kernel.h>
+#include "zbeam_msg.h"
+
+/**
+ * @brief Measurement points, relative to the message origin.
+ */
+enum latency_stage {
+    LATENCY_STAGE_DISPATCH,  /**< Worker starts dispatching the message */
+    LATENCY_STAGE_OUTPUT,    /**< First PWM write caused by the message */
+    LATENCY_STAGE_FAST_PATH, /**< Fast-path PWM write in input context (MSG_INPUT_EDGE) */
+    LATENCY_STAGE_COUNT,
+};
+
+/**
+ * @brief Aggregated latency for one message type and stage.
+ *
+ * p99_us is the upper edge of the power-of-two histogram bucket holding
+ * the 99th percentile (clamped to max_us).
+ */
+struct latency_summary {
+    uint32_t count;
+    uint32_t min_us;
+    uint32_t avg_us;
+    uint32_t p99_us;
+    uint32_t max_us;
+};
+
+#ifdef CONFIG_ZBEAM_LATENCY_STATS
+
+static inline void latency_stamp(struct zbeam_msg *msg, uint32_t cycles)
+{
+    msg->timestamp = cycles;
+}
+
+static inline uint32_t latency_stamp_of(const struct zbeam_msg *msg)
+{
+    return msg->timestamp;
+}
+
+/**
+ * @brief Start attributing output to @p msg (FSM worker only).
+ */
+void latency_stats_begin(const struct zbeam_msg *msg);
+
+/**
+ * @brief Stop attributing output (FSM worker only).
+ */
+void latency_stats_end(void);
+
+/**
+ * @brief Record the output stage for the message being dispatched.
+ *
+ * Only the first call per dispatch is recorded; calls outside a dispatch
+ * (deadline callbacks, init) or from other threads than the worker (the
+ * momentary fast path) are ignored.
+ */
+void latency_stats_mark_output(void);
+
+/**
+ * @brief Record a momentary fast-path write for the key edge at @p cycles.
+ *
+ * Safe from the input thread and the worker alike.
+ */
+void latency_stats_mark_fast_path(uint32_t cycles);
+
+/**
+ * @brief Read the summary for one message type and stage.
+ * @return 0 on success, -EINVAL on bad arguments.
+ */
+int latency_stats_get(uint8_t type, enum latency_stage stage,
+                      struct latency_summary *out);
+
+/**
+ * @brief Clear all histograms.
+ */
+void latency_stats_reset(void);
+
+/**
+ * @brief Log every non-empty summary at INF level.
+ */
+void latency_stats_log(void);
+
+#else
+
+static inline void latency_stamp(struct zbeam_msg *msg, uint32_t cycles) { }
+static inline uint32_t latency_stamp_of(const struct zbeam_msg *msg) { return 0; }
+static inline void latency_stats_begin(const struct zbeam_msg *msg) { }
+static inline void latency_stats_end(void) { }
+static inline void latency_stats_mark_output(void) { }
+static inline void latency_stats_mark_fast_path(uint32_t cycles) { }
+
+#endif /* CONFIG_ZBEAM_LATENCY_STATS */
+
+#endif /* LATENCY_STATS_H */
@@ -0,0 +1,129 @@
+/**
+ * @file led_pattern.h
+ * @brief Bytecode LED pattern engine.
+ *
+ * Strobes, beacons, SOS and blink codes are described as compact opcode
+ * streams in flash and played by a single deadline-driven executor on
+ * the FSM worker. A new pattern costs a few bytes of const data instead
+ * of a new tick handler.
+ *
+ * Patterns are built with the PAT_* macros:
+ * @code
+ * static LED_PATTERN_DEFINE(pat_beacon,
+ *     PAT_LEVEL_ARG(1), PAT_HOLD(100),
+ *     PAT_LEVEL(0), PAT_HOLD_ARG(0),
+ *     PAT_RESTART());
+ * @endcode
+ *
+ * Arguments (LED_PATTERN_ARGS 16-bit registers) are supplied at start and
+ * may be changed while playing, e.g. to retune a strobe period live.
+ */
+
+#ifndef LED_PATTERN_H
+#define LED_PATTERN_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define LED_PATTERN_ARGS        4  /**< Argument registers per pattern */
+#define LED_PATTERN_LOOP_DEPTH  3  /**< Maximum nesting of PAT_REPEAT */
+
+/** @brief Opcodes (one byte, followed by the listed operands). */
+enum led_pattern_op {
+    PAT_OP_END,         /**< Stop and report completion */
+    PAT_OP_RESTART,     /**< Jump back to the first opcode */
+    PAT_OP_LEVEL,       /**< u8 level: set output */
+    PAT_OP_LEVEL_ARG,   /**< u8 arg: set output to args[arg] */
+    PAT_OP_HOLD,        /**< u16 ms: wait */
+    PAT_OP_HOLD_ARG,    /**< u8 arg: wait args[arg] ms */
+    PAT_OP_RAMP,        /**< u8 level, u16 ms: linear fade from current level */
+    PAT_OP_RAND_LEVEL,  /**< u8 min, u8 max: set output to a random level */
+    PAT_OP_RAND_HOLD,   /**< u16 min, u16 max: wait a random time */
+    PAT_OP_REPEAT,      /**< u8 n: run the block up to PAT_NEXT n times */
+    PAT_OP_REPEAT_ARG,  /**< u8 arg: as PAT_REPEAT with n = args[arg] */
+    PAT_OP_NEXT,        /**< End of a PAT_REPEAT block */
+};
+
+#define PAT_U16(v) ((v) & 0xff), (((v) >> 8) & 0xff)
+
+#define PAT_END()                  PAT_OP_END
+#define PAT_RESTART()              PAT_OP_RESTART
+#define PAT_LEVEL(l)               PAT_OP_LEVEL, (l)
+#define PAT_LEVEL_ARG(i)           PAT_OP_LEVEL_ARG, (i)
+#define PAT_HOLD(ms)               PAT_OP_HOLD, PAT_U16(ms)
+#define PAT_HOLD_ARG(i)            PAT_OP_HOLD_ARG, (i)
+#define PAT_RAMP(l, ms)            PAT_OP_RAMP, (l), PAT_U16(ms)
+#define PAT_RAND_LEVEL(lo, hi)     PAT_OP_RAND_LEVEL, (lo), (hi)
+#define PAT_RAND_HOLD(lo, hi)      PAT_OP_RAND_HOLD, PAT_U16(lo), PAT_U16(hi)
+#define PAT_REPEAT(n)              PAT_OP_REPEAT, (n)
+#define PAT_REPEAT_ARG(i)          PAT_OP_REPEAT_ARG, (i)
+#define PAT_NEXT()                 PAT_OP_NEXT
+
+/**
+ * @brief A pattern program in flash.
+ */
+struct led_pattern {
+    const char *name;
+    const uint8_t *code;
+    uint16_t len;
+};
+
+/**
+ * @brief Define a const pattern @p _name from a list of PAT_* opcodes.
+ */
+#define LED_PATTERN_DEFINE(_name, ...) \
+    const struct led_pattern _name = { \
+        .name = #_name, \
+        .code = (const uint8_t[]){ __VA_ARGS__ }, \
+        .len = sizeof((const uint8_t[]){ __VA_ARGS__ }), \
+    }
+
+/** @brief Output stage (e.g. channel_apply_mix). */
+typedef void (*led_pattern_output_t)(uint8_t level);
+
+/** @brief Completion callback for patterns ending in PAT_END(). */
+typedef void (*led_pattern_done_t)(void);
+
+/**
+ * @brief Set the output stage. Must be called before playing.
+ */
+void led_pattern_init(led_pattern_output_t output);
+
+/**
+ * @brief Start a pattern, replacing whatever is playing.
+ *
+ * Runs up to the first hold immediately, so the first level is on the
+ * output when this returns. Must be called from the FSM worker (actions,
+ * callbacks, deadlines).
+ *
+ * @param pat Pattern to play.
+ * @param args Initial argument registers (may be NULL if @p nargs is 0).
+ * @param nargs Number of entries in @p args (at most LED_PATTERN_ARGS).
+ * @param done Called when the pattern reaches PAT_END(), or NULL.
+ * @return 0 on success, -ENODEV if no output is set, -EINVAL on bad args.
+ */
+int led_pattern_play(const struct led_pattern *pat, const uint16_t *args, size_t nargs,
+                     led_pattern_done_t done);
+
+/**
+ * @brief Update an argument register of the playing pattern.
+ *
+ * Takes effect the next time the pattern reads it.
+ */
+void led_pattern_set_arg(uint8_t idx, uint16_t value);
+
+/**
+ * @brief Stop playback immediately without calling done.
+ *
+ * The output is left at its last level.
+ */
+void led_pattern_stop(void);
+
+/**
+ * @brief Get the pattern being played.
+ * @return The pattern, or NULL when idle.
+ */
+const struct led_pattern *led_pattern_current(void);
+
+#endif /* LED_PATTERN_H */
@@ -2,13 +2,15 @@
  * @file multi_tap_input.h
  * @brief Multi-Tap Input Detection API.
  *
- * Posts input events (tap, hold) to FSM worker via message queue.
+ * Posts input events (tap, hold, encoder) to FSM worker via message
+ * queue, tagged with their source (enum zbeam_input_source).
  */
 
 #ifndef MULTI_TAP_INPUT_H
 #define MULTI_TAP_INPUT_H
 
 #include <zephyr/kernel.h>
+#include "zbeam_msg.h"
 
 /**
  * @brief Initialize the Multi-Tap Input engine.
@@ -22,6 +24,73 @@ void multi_tap_input_init(void);
  */
 void multi_tap_configure(uint32_t click_ms, uint32_t hold_ms);
 
+/**
+ * @brief Query deciding whether a tap sequence may still grow.
+ * @param source enum zbeam_input_source of the sequence.
+ * @param count Taps completed so far.
+ * @return false to commit the tap now instead of waiting for the click timeout.
+ */
+typedef bool (*multi_tap_continue_fn)(uint8_t source, int count);
+
+/**
+ * @brief Set the continuation query consulted on each tap release.
+ *
+ * With no query (the default) every tap waits the full click timeout.
+ * The application binds fsm_input_can_continue() so taps on nodes that
+ * map nothing longer are dispatched immediately.
+ */
+void multi_tap_set_continue_query(multi_tap_continue_fn fn);
+
+/**
+ * @brief Hook run at the first key-down of a main-button sequence (on the
+ *        FSM worker).
+ */
+typedef void (*multi_tap_press_fn)(void);
+
+/**
+ * @brief Set (or clear with NULL) the first key-down hook.
+ *
+ * The application binds fsm_preview_press() so the emitter can light
+ * before the sequence resolves.
+ */
+void multi_tap_set_press_hook(multi_tap_press_fn fn);
+
+/**
+ * @brief Hook run for every raw main-button edge in the input callback.
+ * @param pressed true on key-down, false on key-up.
+ * @return true if the hook wrote the output (recorded as fast-path latency).
+ */
+typedef bool (*multi_tap_edge_fn)(bool pressed);
+
+/**
+ * @brief Set (or clear with NULL) the input-context edge hook.
+ *
+ * The hook runs before the edge is posted to the FSM worker, so it must
+ * be short and must not block. The application binds fsm_momentary_edge()
+ * so momentary nodes light without waiting for the worker.
+ */
+void multi_tap_set_edge_hook(multi_tap_edge_fn fn);
+
+/**
+ * @brief Feed one raw key edge into the detector of its source.
+ *
+ * Called by the FSM worker for each MSG_INPUT_EDGE.
+ * @param edge Edge message (count: 1 = pressed, 0 = released).
+ */
+void multi_tap_input_process_edge(const struct zbeam_msg *edge);
+
+/**
+ * @brief Take the encoder detents summed since the last take.
+ *
+ * Called by the FSM worker for each MSG_INPUT_ENCODER. Detents arriving
+ * while one is pending are folded into it rather than posted again.
+ *
+ * @param msg The MSG_INPUT_ENCODER; count is set to the delta as int8_t
+ *            (clamped to +/-127 detents).
+ * @return false if the detents were already taken (nothing to dispatch).
+ */
+bool multi_tap_input_take_encoder(struct zbeam_msg *msg);
+
 /* Internal state reset for testing */
 void multi_tap_input_reset(void);
 
@@ -26,6 +26,8 @@
 #define NVS_ID_TEMP_CALIB_OFFSET 9
 #define NVS_ID_BATT_CALIB_OFFSET 10
 #define NVS_ID_RAMP_STYLE 11
+#define NVS_ID_TAP_GAP_MEAN 12
+#define NVS_ID_TAP_GAP_DEV  13
 
 
 #ifdef CONFIG_ZBEAM_NVS_ENABLED
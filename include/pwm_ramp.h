@@ -2,10 +2,11 @@
  * PWM Ramp API - Common Interface
  * 
  * Platform-agnostic API for perception-corrected LED brightness ramping.
- * Implementation varies by platform:
- *   - ESP32: LEDC hardware fade with table interpolation
- *   - CH32X035: DMA+Timer (future)
- *   - Generic: CPU loop fallback
+ * Fades are non-blocking and stepped by an FSM worker deadline; the
+ * output write varies by platform:
+ *   - ESP32: LEDC, stepping CONFIG_PWM_RAMP_INTERPOLATION_STEP table entries
+ *   - DMA+Timer: the whole fade streamed by DMA (CONFIG_PWM_RAMP_DMA)
+ *   - Generic: pwm_set_dt() per table entry
  */
 
 #ifndef PWM_RAMP_H
@@ -23,28 +24,55 @@
 int pwm_ramp_init(const struct pwm_dt_spec *pwm_spec);
 
 /**
- * @brief Set brightness level (0-255)
- * Uses the gamma-corrected ramp table internally.
+ * @brief Fade completion callback (runs on the FSM worker).
+ * @param brightness Level on the output when the fade ended.
+ * @param completed true if the target was reached, false if the fade was
+ *        stopped, overridden by pwm_ramp_set_brightness() or replaced by
+ *        a new pwm_ramp_start().
+ */
+typedef void (*pwm_ramp_done_fn)(uint8_t brightness, bool completed);
+
+/**
+ * @brief Set brightness level (0-255) immediately
+ * Uses the gamma-corrected ramp table internally. Stops an active fade.
  * @param brightness 0 (off) to 255 (full)
  */
 void pwm_ramp_set_brightness(uint8_t brightness);
 
 /**
- * @brief Start a ramp from current brightness to target
+ * @brief Start a fade from the current brightness to a target
+ *
+ * Non-blocking: returns at once and the fade is stepped by an FSM worker
+ * deadline. Call from the FSM worker. A fade already running is replaced
+ * (its callback reports completed = false) and the new one starts from
+ * the level it had reached.
+ *
  * @param target_brightness Target brightness (0-255)
- * @param duration_ms Time to complete the ramp
- * @return 0 on success, negative errno on failure
+ * @param duration_ms Time to complete the fade (0 = jump)
+ * @param done Called once when the fade ends, or NULL
+ * @return 0 on success, -ENODEV if not initialized
  */
-int pwm_ramp_start(uint8_t target_brightness, uint32_t duration_ms);
+int pwm_ramp_start(uint8_t target_brightness, uint32_t duration_ms, pwm_ramp_done_fn done);
 
 /**
- * @brief Check if a ramp is currently in progress
+ * @brief Move the target of the running fade
+ *
+ * Continues from the current level, without a jump, reaching the new
+ * target @p duration_ms from now. The completion callback is kept. With
+ * no fade running this is pwm_ramp_start() without a callback.
+ *
+ * @return 0 on success, -ENODEV if not initialized
+ */
+int pwm_ramp_retarget(uint8_t target_brightness, uint32_t duration_ms);
+
+/**
+ * @brief Check if a fade is currently in progress
  * @return true if ramping, false if idle
  */
 bool pwm_ramp_is_active(void);
 
 /**
- * @brief Stop any active ramp and hold current brightness
+ * @brief Stop any active fade and hold the current brightness
  */
 void pwm_ramp_stop(void);
 
@@ -54,4 +82,67 @@ void pwm_ramp_stop(void);
  */
 uint8_t pwm_ramp_get_brightness(void);
 
+/*
+ * Platform backend (src/pwm_ramp_<platform>.c): pwm_ramp_init() and the
+ * output write below. Fades are common code (src/pwm_ramp.c).
+ */
+
+/**
+ * @brief Write a table-corrected level to the output.
+ * @return 0 on success, -ENODEV if the backend is not initialized.
+ */
+int pwm_ramp_backend_write(uint8_t brightness);
+
+/*
+ * Hardware fades (DMA backend only). src/pwm_ramp.c hands a fade to the
+ * backend when it accepts it and steps the fade itself otherwise.
+ */
+
+/**
+ * @brief Run a whole fade in hardware.
+ *
+ * Outputs the levels after @p from up to @p to, spread over
+ * @p duration_ms, without further CPU involvement.
+ *
+ * @return 0 if started, negative errno if the fade must be stepped instead.
+ */
+int pwm_ramp_backend_fade(uint8_t from, uint8_t to, uint32_t duration_ms);
+
+/**
+ * @brief Check on a hardware fade.
+ * @param level Set to the level on the output now.
+ * @return true while the fade is still running.
+ */
+bool pwm_ramp_backend_fade_poll(uint8_t *level);
+
+/**
+ * @brief Halt a hardware fade, holding the level it reached.
+ * @return Level on the output.
+ */
+uint8_t pwm_ramp_backend_fade_stop(void);
+
+/*
+ * Timer glue for the DMA backend (MCU-specific: the DMA API knows the
+ * request line, not the timer behind it). Provided by the SoC support;
+ * src/pwm_ramp_dma.c has weak defaults for SoCs without it.
+ */
+
+/**
+ * @brief Address of the PWM channel's Capture/Compare Register.
+ * @return The register, or NULL (weak default) if there is no glue, in
+ *         which case pwm_ramp_init() fails with -ENOTSUP.
+ */
+volatile uint16_t *pwm_ramp_dma_compare_reg(void);
+
+/**
+ * @brief Raise the ramp DMA request every @p periods timer updates.
+ *
+ * Sets the timer's update repetition, so each streamed compare value
+ * is held for @p periods PWM periods.
+ *
+ * @return 0 on success, negative errno on failure (-ENOTSUP from the weak
+ *         default); the fade is then stepped instead.
+ */
+int pwm_ramp_dma_set_pacing(uint32_t periods);
+
 #endif /* PWM_RAMP_H */
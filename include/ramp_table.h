@@ -19,6 +19,11 @@
 #define RAMP_TABLE_SIZE     PWM_RAMP_13BIT_G28_SIZE
 #define RAMP_TABLE_MAX_DUTY PWM_RAMP_13BIT_G28_MAX_DUTY
 
+/* Per-emitter gamma tables, same size and scale: RAMP_TABLE_GAMMA(g22) */
+#include "ramp_table_13bit_g22.h"
+#define RAMP_TABLE_GAMMA(_g) RAMP_TABLE_GAMMA_(_g)
+#define RAMP_TABLE_GAMMA_(_g) pwm_ramp_table_13bit_##_g
+
 /* Sine wave table */
 #include "ramp_sine_13bit_g28.h"
 #define pwm_sine_table      pwm_sine_table_13bit_g28
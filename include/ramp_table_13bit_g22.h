@@ -0,0 +1,46 @@
+/*
+ * Auto-generated PWM ramp table for perception-corrected LED brightness.
+ * Generated by: scripts/generate_ramp_table.py --bits 13 --gamma 2.2 
+ *
+ * Configuration:
+ *   Mode: ramp
+ *   Resolution: 13-bit (max duty = 8191)
+ *   Table size: 256 entries
+ *   Gamma: 2.2
+ *
+ * Suitable for: White, warm white, red LEDs
+ *
+ * Gamma reference:
+ *   2.0-2.2: Standard (white/red LEDs)
+ *   2.3-2.5: Mid-range (green/amber LEDs)
+ *   2.6-3.0: High (blue LEDs, human eye less sensitive to blue)
+ */
+
+#ifndef PWM_RAMP_13BIT_G22_H
+#define PWM_RAMP_13BIT_G22_H
+
+#include <stdint.h>
+
+#define PWM_RAMP_13BIT_G22_SIZE 256
+#define PWM_RAMP_13BIT_G22_MAX_DUTY 8191
+
+static const uint16_t pwm_ramp_table_13bit_g22[256] = {
+        0,     0,     0,     0,     1,     1,     2,     3,     4,     5,     7,     8,    10,    12,    14,    16,
+       19,    21,    24,    27,    30,    34,    37,    41,    45,    49,    54,    59,    63,    69,    74,    79,
+       85,    91,    97,   104,   110,   117,   124,   132,   139,   147,   155,   163,   172,   180,   189,   198,
+      208,   217,   227,   237,   248,   258,   269,   280,   292,   303,   315,   327,   340,   352,   365,   378,
+      391,   405,   419,   433,   447,   462,   477,   492,   507,   523,   539,   555,   571,   588,   605,   622,
+      639,   657,   675,   693,   712,   731,   750,   769,   789,   808,   828,   849,   870,   890,   912,   933,
+      955,   977,   999,  1022,  1045,  1068,  1091,  1115,  1139,  1163,  1187,  1212,  1237,  1263,  1288,  1314,
+     1340,  1367,  1394,  1421,  1448,  1476,  1503,  1532,  1560,  1589,  1618,  1647,  1677,  1707,  1737,  1767,
+     1798,  1829,  1860,  1892,  1924,  1956,  1989,  2022,  2055,  2088,  2122,  2156,  2190,  2224,  2259,  2294,
+     2330,  2366,  2402,  2438,  2475,  2512,  2549,  2586,  2624,  2662,  2701,  2740,  2779,  2818,  2858,  2897,
+     2938,  2978,  3019,  3060,  3102,  3143,  3186,  3228,  3271,  3314,  3357,  3400,  3444,  3489,  3533,  3578,
+     3623,  3669,  3714,  3760,  3807,  3853,  3900,  3948,  3995,  4043,  4091,  4140,  4189,  4238,  4288,  4337,
+     4387,  4438,  4489,  4540,  4591,  4643,  4695,  4747,  4800,  4853,  4906,  4960,  5013,  5068,  5122,  5177,
+     5232,  5288,  5344,  5400,  5456,  5513,  5570,  5627,  5685,  5743,  5802,  5860,  5919,  5979,  6038,  6098,
+     6159,  6219,  6280,  6342,  6403,  6465,  6528,  6590,  6653,  6716,  6780,  6844,  6908,  6973,  7037,  7103,
+     7168,  7234,  7300,  7367,  7434,  7501,  7568,  7636,  7704,  7773,  7842,  7911,  7980,  8050,  8120,  8191
+};
+
+#endif /* PWM_RAMP_13BIT_G22_H */
@@ -0,0 +1,82 @@
+/**
+ * @file spsc_ring.h
+ * @brief Lock-free single-producer/single-consumer message ring.
+ *
+ * A power-of-two array of struct zbeam_msg with free-running head and
+ * tail indices. The producer only writes head and the consumer only
+ * writes tail, so a put or get is one slot copy plus one atomic store,
+ * with no kernel lock. Safe for exactly one producer context and one
+ * consumer context at a time; callers must serialise anything more.
+ *
+ * Both indices are published with sequentially consistent atomics, so a
+ * producer that sees the ring drained after its put (return value 1) can
+ * rely on the consumer having looked for work before the put landed.
+ */
+
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/util.h>
+#include "zbeam_msg.h"
+
+struct spsc_ring {
+    struct zbeam_msg *buf;
+    uint32_t mask;   ///< Depth - 1
+    atomic_t head;   ///< Next slot to fill (producer)
+    atomic_t tail;   ///< Next slot to drain (consumer)
+};
+
+/**
+ * @brief Statically define a ring of @p _depth messages (a power of two).
+ */
+#define SPSC_RING_DEFINE(_name, _depth)                                       \
+    BUILD_ASSERT(IS_POWER_OF_TWO(_depth), "SPSC ring depth must be a power of two"); \
+    static struct zbeam_msg _name##_buf[_depth];                              \
+    static struct spsc_ring _name = { .buf = _name##_buf, .mask = (_depth) - 1 }
+
+/**
+ * @brief Number of messages waiting.
+ */
+static inline uint32_t spsc_ring_count(struct spsc_ring *r)
+{
+    return (uint32_t)atomic_get(&r->head) - (uint32_t)atomic_get(&r->tail);
+}
+
+/**
+ * @brief Append a message (producer only).
+ * @return Messages waiting after the put (1 = the consumer had drained
+ *         everything and may need a wakeup, 0 = already taken), or
+ *         -ENOMSG if the ring is full.
+ */
+static inline int spsc_ring_put(struct spsc_ring *r, const struct zbeam_msg *msg)
+{
+    uint32_t head = (uint32_t)atomic_get(&r->head);
+
+    if (head - (uint32_t)atomic_get(&r->tail) > r->mask) {
+        return -ENOMSG;
+    }
+    r->buf[head & r->mask] = *msg;
+    atomic_set(&r->head, (atomic_val_t)(head + 1));
+
+    return (int)(head + 1 - (uint32_t)atomic_get(&r->tail));
+}
+
+/**
+ * @brief Take the oldest message (consumer only).
+ * @return 0 on success, -ENOMSG if the ring is empty.
+ */
+static inline int spsc_ring_get(struct spsc_ring *r, struct zbeam_msg *msg)
+{
+    uint32_t tail = (uint32_t)atomic_get(&r->tail);
+
+    if (tail == (uint32_t)atomic_get(&r->head)) {
+        return -ENOMSG;
+    }
+    *msg = r->buf[tail & r->mask];
+    atomic_set(&r->tail, (atomic_val_t)(tail + 1));
+    return 0;
+}
+
+#endif /* SPSC_RING_H */
@@ -0,0 +1,66 @@
+/**
+ * @file tap_cadence.h
+ * @brief Click-timeout estimator learned from the user's tap cadence.
+ *
+ * Each gap between a release and the next press of the same sequence is
+ * fed into a smoothed mean / mean-deviation estimator (as used for TCP
+ * retransmit timers). The click timeout is the mean plus four deviations
+ * plus a fixed margin, clamped to caller-supplied bounds, so it tracks a
+ * fast user's rhythm while leaving room for their slowest usual gap.
+ *
+ * Values are 12.4 fixed point milliseconds. The module keeps no global
+ * state; the input engine owns the instance (CONFIG_ZBEAM_ADAPTIVE_TAP).
+ */
+
+#ifndef TAP_CADENCE_H
+#define TAP_CADENCE_H
+
+#include <zephyr/kernel.h>
+
+/* Gaps needed before the learned timeout replaces the configured one */
+#define TAP_CADENCE_MIN_SAMPLES 8
+/* Added on top of mean + 4 * deviation */
+#define TAP_CADENCE_MARGIN_MS 50
+/* Longer gaps are clamped so the 12.4 values fit in 16 bits */
+#define TAP_CADENCE_MAX_GAP_MS 4000
+/* Resolution of the persisted bytes */
+#define TAP_CADENCE_PACK_MS 4
+
+struct tap_cadence {
+    uint16_t mean_q4;  ///< Smoothed gap, 1/16 ms
+    uint16_t dev_q4;   ///< Smoothed mean deviation, 1/16 ms
+    uint16_t samples;  ///< Gaps seen (saturating)
+};
+
+/**
+ * @brief Forget everything learned.
+ */
+void tap_cadence_init(struct tap_cadence *tc);
+
+/**
+ * @brief Add one observed inter-tap gap.
+ * @param gap_ms Release-to-press time within a sequence.
+ */
+void tap_cadence_sample(struct tap_cadence *tc, uint32_t gap_ms);
+
+/**
+ * @brief Click timeout to use for the next gap.
+ *
+ * Returns @p max_ms until TAP_CADENCE_MIN_SAMPLES gaps have been seen.
+ *
+ * @param min_ms Lower bound (wins over @p max_ms if they cross).
+ * @param max_ms Upper bound, normally the configured click timeout.
+ */
+uint32_t tap_cadence_timeout(const struct tap_cadence *tc, uint32_t min_ms, uint32_t max_ms);
+
+/**
+ * @brief Pack the estimate into two bytes for NVS (TAP_CADENCE_PACK_MS units).
+ */
+void tap_cadence_pack(const struct tap_cadence *tc, uint8_t *mean, uint8_t *dev);
+
+/**
+ * @brief Restore a packed estimate. It counts as fully trained.
+ */
+void tap_cadence_restore(struct tap_cadence *tc, uint8_t mean, uint8_t dev);
+
+#endif /* TAP_CADENCE_H */
@@ -6,10 +6,22 @@
 #define THERMAL_MANAGER_H
 
 #include <stdint.h>
+#include "brightness.h"
 
 void thermal_init(void);
 void thermal_update(uint8_t current_brightness);
-uint8_t thermal_apply_throttle(uint8_t requested_brightness);
+brightness_t thermal_apply_throttle(brightness_t requested_brightness);
+
+/**
+ * @brief Scale a current budget by the thermal throttle.
+ *
+ * The same factor thermal_apply_throttle() applies to a level, applied
+ * to the current the output stage may draw instead.
+ *
+ * @param budget_ua Budget when cool, in uA.
+ * @return The budget allowed at the current temperature, in uA.
+ */
+uint32_t thermal_apply_budget(uint32_t budget_ua);
 int32_t thermal_get_temp_mc(void);
 
 /**
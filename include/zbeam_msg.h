@@ -14,14 +14,16 @@
  * @brief Message types for the FSM message queue.
  */
 enum zbeam_msg_type {
-    /* Input Events (from multi_tap_input) */
+    /* Input Events (from multi_tap_input / input callback) */
     MSG_INPUT_TAP,           /**< Multi-tap complete (count = number of taps) */
     MSG_INPUT_HOLD_START,    /**< Hold threshold reached */
     MSG_INPUT_HOLD_RELEASE,  /**< Button released after hold */
+    MSG_INPUT_EDGE,          /**< Raw button edge (count = 1 press, 0 release) */
+    MSG_INPUT_ENCODER,       /**< Encoder detents (count = int8_t delta) */
 
     /* Timer Events */
     MSG_TIMEOUT_INACTIVITY,  /**< FSM inactivity timeout */
-    MSG_TIMEOUT_RAMP_TICK,   /**< Ramping step timer */
+    MSG_TIMEOUT_RAMP_TICK,   /**< Unused: ramps are worker deadlines. Kept so type numbers stay put */
 
     /* Safety Events (from safety_monitor) */
     MSG_SAFETY_SHUTDOWN,     /**< Emergency shutdown - LED off immediately */
@@ -29,18 +31,42 @@ enum zbeam_msg_type {
 
     /* System Events */
     MSG_SYSTEM_SHUTDOWN,     /**< Clean shutdown request */
+
+    MSG_TYPE_COUNT,
+};
+
+/**
+ * @brief Input sources, carried in zbeam_msg.source.
+ *
+ * Each key source has its own tap detector; the FSM looks up a separate
+ * click/hold map per source (see struct fsm_input_map).
+ */
+enum zbeam_input_source {
+    INPUT_SRC_MAIN,          /**< Main e-switch (INPUT_KEY_0) */
+    INPUT_SRC_TAIL,          /**< Tail e-switch (INPUT_KEY_1) */
+    INPUT_SRC_SIDE,          /**< Side button (INPUT_KEY_2) */
+    INPUT_SRC_ENCODER,       /**< Rotary encoder (INPUT_REL_WHEEL) */
+
+    INPUT_SRC_COUNT,
 };
 
+/* Sources below this one are keys with a tap detector */
+#define INPUT_SRC_KEY_COUNT INPUT_SRC_ENCODER
+
 /**
  * @brief Message structure for k_msgq.
  * 
- * Kept minimal (4 bytes) for efficient queue operations.
+ * Kept minimal (4 bytes) for efficient queue operations; 8 bytes with
+ * CONFIG_ZBEAM_LATENCY_STATS.
  */
 struct zbeam_msg {
     uint8_t type;      /**< enum zbeam_msg_type */
-    uint8_t count;     /**< Click/hold count (for input events) */
+    uint8_t count;     /**< Click/hold count (input) */
     uint8_t severity;  /**< For safety events: 0=info, 255=critical */
-    uint8_t reserved;  /**< Alignment padding */
+    uint8_t source;    /**< Input events: enum zbeam_input_source */
+#ifdef CONFIG_ZBEAM_LATENCY_STATS
+    uint32_t timestamp; /**< k_cycle_get_32() at origin (see latency_stats.h) */
+#endif
 };
 
 #endif /* ZBEAM_MSG_H */
@@ -7,6 +7,7 @@
 #include <zephyr/logging/log.h>
 #include <zephyr/drivers/pwm.h>
 #include "aux_manager.h"
+#include "fsm_sched.h"
 #include "../include/ramp_sine_13bit_g28.h"
 
 LOG_MODULE_REGISTER(aux_manager, LOG_LEVEL_INF);
@@ -31,8 +32,8 @@ static aux_mode_t current_mode = AUX_OFF;
 static const struct pwm_dt_spec aux_pwm = PWM_DT_SPEC_GET(DT_NODELABEL(aux_led));
 
 /* For patterns */
-static struct k_timer aux_timer;
-static struct k_work aux_work;
+static void aux_tick(struct fsm_deadline *dl);
+static FSM_DEADLINE_DEFINE(aux_deadline, aux_tick);
 static uint32_t ticks = 0;
 static uint8_t sine_index = 0;
 
@@ -42,8 +43,8 @@ static uint8_t sine_index = 0;
 // Actually overlay says <&ledc0 1 10000 PWM_POLARITY_NORMAL>; 10000ns = 100kHz.
 // We will rely on pwm_set_pulse_dt using the dt-spec period.
 
-/* Work handler - updates PWM */
-static void aux_work_handler(struct k_work *work)
+/* Deadline handler (FSM worker thread) - updates PWM */
+static void aux_tick(struct fsm_deadline *dl)
 {
     ticks++;
     uint32_t pulse_ns = 0;
@@ -95,12 +96,6 @@ static void aux_work_handler(struct k_work *work)
     }
 }
 
-/* Timer ISR - just submits work */
-static void aux_timer_handler(struct k_timer *dummy)
-{
-    k_work_submit(&aux_work);
-}
-
 void aux_init(void)
 {
     LOG_INF("Aux Init: Start");
@@ -112,9 +107,7 @@ void aux_init(void)
 
     LOG_INF("Aux Init: PWM Device Ready. Period=%d ns", aux_pwm.period);
     
-    k_work_init(&aux_work, aux_work_handler);
-    k_timer_init(&aux_timer, aux_timer_handler, NULL);
-    k_timer_start(&aux_timer, K_MSEC(10), K_MSEC(10)); // 100Hz Update Rate
+    fsm_deadline_start(&aux_deadline, 10, 10); // 100Hz Update Rate
 
     LOG_INF("AUX Manager Initialized (PWM Mode).");
     current_mode = AUX_OFF;
@@ -136,6 +129,6 @@ void aux_cycle_mode(void)
 
 void aux_update(void)
 {
-    // Implementation handled by periodic timer/workqueue
+    // Implementation handled by periodic deadline (aux_tick)
 }
 
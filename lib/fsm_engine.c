@@ -3,38 +3,77 @@
  * @brief Finite State Machine Engine.
  *
  * Processes messages from the worker thread and manages state transitions.
+ * Node timeouts are worker deadlines, so transitions only ever happen on
+ * the worker thread.
+ *
+ * Per-event logging is at DBG level; use the binary trace (fsm_trace.h)
+ * to follow the FSM on size-optimised builds.
  */
 
 #include <zephyr/kernel.h>
 #include <zephyr/logging/log.h>
 #include "fsm_engine.h"
+#include "fsm_sched.h"
+#include "fsm_trace.h"
 #include "zbeam_msg.h"
 
 LOG_MODULE_REGISTER(FSM_Engine, LOG_LEVEL_INF);
 
 /* FSM State */
-static struct fsm_node *current_node = NULL;
-static struct fsm_node *home_node = NULL;
-static struct fsm_node *previous_node = NULL;
-static struct k_timer inactivity_timer;
+static const struct fsm_table *fsm_table = NULL;
+static const struct fsm_node *current_node = NULL;
+static const struct fsm_node *home_node = NULL;
+static const struct fsm_node *previous_node = NULL;
+static void inactivity_expired(struct fsm_deadline *dl);
+static FSM_DEADLINE_DEFINE(inactivity_deadline, inactivity_expired);
 static volatile bool emergency_shutdown_active = false;
 
+/* Speculative press preview */
+static const struct fsm_preview *preview;
+static const struct fsm_node *preview_node;  /* Node being previewed, NULL if none */
+static uint32_t transition_count;
+static uint32_t preview_mark;                /* transition_count at preview start */
+
+/*
+ * Momentary fast path: armed only while a FSM_NODE_MOMENTARY node is current.
+ * The armed check and the edge's output write happen under momentary_lock,
+ * so once a transition has disarmed it no stale edge can land after the
+ * next node's action.
+ */
+static const struct fsm_momentary *momentary;
+static bool momentary_armed;
+static K_MUTEX_DEFINE(momentary_lock);
+
 /* External node from key_map.c */
 /* External node dependency removed. Uses home_node. */
 
+#define NODE_ID(n) ((n) ? (n)->id : FSM_NONE)
+
+/* Waits out an edge that is mid-write */
+static void momentary_disarm(void)
+{
+    k_mutex_lock(&momentary_lock, K_FOREVER);
+    momentary_armed = false;
+    k_mutex_unlock(&momentary_lock);
+}
+
 static void reset_inactivity_timer(void)
 {
     if (current_node && current_node->timeout_ms > 0) {
-        k_timer_start(&inactivity_timer, K_MSEC(current_node->timeout_ms), K_NO_WAIT);
+        fsm_deadline_start(&inactivity_deadline, current_node->timeout_ms, 0);
     }
 }
 
-static void inactivity_timer_handler(struct k_timer *timer_id)
+static void handle_timeout(void)
 {
-    if (current_node && current_node->timeout_node) {
-        LOG_INF("FSM: Timeout -> Next [%s]", current_node->timeout_node->name);
-        fsm_transition_to(current_node->timeout_node);
-    } else if (current_node && current_node->timeout_reverts && previous_node) {
+    const struct fsm_node *timeout_node = current_node ? fsm_get_node(current_node->timeout_node) : NULL;
+
+    fsm_trace_record(FSM_TRACE_TIMEOUT, NODE_ID(current_node), FSM_NONE, 0);
+
+    if (timeout_node) {
+        LOG_INF("FSM: Timeout -> Next [%s]", timeout_node->name);
+        fsm_transition_to(timeout_node);
+    } else if (current_node && (current_node->flags & FSM_NODE_TIMEOUT_REVERTS) && previous_node) {
         LOG_INF("FSM: Timeout -> Previous [%s]", previous_node->name);
         fsm_transition_to(previous_node);
     } else {
@@ -43,120 +82,295 @@ static void inactivity_timer_handler(struct k_timer *timer_id)
     }
 }
 
-void fsm_transition_to(struct fsm_node *next_node)
+static void inactivity_expired(struct fsm_deadline *dl)
+{
+    handle_timeout();
+}
+
+void fsm_transition_to(const struct fsm_node *next_node)
 {
     if (!next_node) return;
 
-    k_timer_stop(&inactivity_timer);
+    fsm_deadline_stop(&inactivity_deadline);
+    momentary_disarm();
+    transition_count++;
     
-    if (!next_node->timeout_reverts) {
+    if (!(next_node->flags & FSM_NODE_TIMEOUT_REVERTS)) {
         previous_node = current_node;
     }
 
+    fsm_trace_record(FSM_TRACE_TRANSITION, NODE_ID(current_node), next_node->id, 0);
     current_node = next_node;
-    LOG_INF("FSM: -> [%s]", current_node->name ? current_node->name : "?");
+    LOG_DBG("FSM: -> [%s]", current_node->name ? current_node->name : "?");
 
     if (current_node->action_routine) {
         current_node->action_routine();
     }
 
+    /* Arm after the entry action so it cannot overwrite a fast-path edge */
+    if (momentary && (current_node->flags & FSM_NODE_MOMENTARY)) {
+        k_mutex_lock(&momentary_lock, K_FOREVER);
+        momentary->arm(current_node);
+        momentary_armed = true;
+        k_mutex_unlock(&momentary_lock);
+    }
+
     if (current_node->timeout_ms > 0) {
-        k_timer_start(&inactivity_timer, K_MSEC(current_node->timeout_ms), K_NO_WAIT);
+        fsm_deadline_start(&inactivity_deadline, current_node->timeout_ms, 0);
     }
 }
 
-void fsm_init(struct fsm_node *start_node)
+void fsm_restart_timeout(void)
 {
-    LOG_INF("FSM: Init");
+    reset_inactivity_timer();
+}
+
+void fsm_init(const struct fsm_table *table, const struct fsm_node *start_node)
+{
+    LOG_INF("FSM: Init (%d nodes, %d callbacks)", table->node_count, table->callback_count);
+    fsm_table = table;
     home_node = start_node;
-    k_timer_init(&inactivity_timer, inactivity_timer_handler, NULL);
+    fsm_trace_record(FSM_TRACE_INIT, FSM_NONE, NODE_ID(start_node), 0);
     fsm_transition_to(start_node);
 }
 
-struct fsm_node *fsm_get_current_node(void)
+const struct fsm_node *fsm_get_current_node(void)
 {
     return current_node;
 }
 
+const struct fsm_node *fsm_get_node(uint8_t id)
+{
+    if (!fsm_table || id == FSM_NONE || id >= fsm_table->node_count) {
+        return NULL;
+    }
+    return fsm_table->nodes[id];
+}
+
+/* True if any slot past the first @p count is mapped */
+static bool slots_beyond(const struct fsm_slot *slots, uint8_t slot_count, int count)
+{
+    for (int i = count; i < slot_count; i++) {
+        if (slots[i].target != FSM_NONE || slots[i].callback != FSM_NONE) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Map for a non-main @p source on @p node, NULL if it maps nothing */
+static const struct fsm_input_map *find_input_map(const struct fsm_node *node, uint8_t source)
+{
+    for (int i = 0; i < node->input_count; i++) {
+        if (node->inputs[i].source == source) {
+            return &node->inputs[i];
+        }
+    }
+    return NULL;
+}
+
+bool fsm_input_can_continue(uint8_t source, int count)
+{
+    if (!current_node || count < 1) {
+        return true;
+    }
+
+    if (source != INPUT_SRC_MAIN) {
+        const struct fsm_input_map *map = find_input_map(current_node, source);
+
+        return map && (slots_beyond(map->clicks, map->click_count, count) ||
+                       slots_beyond(map->holds, map->hold_count, count));
+    }
+
+    if (current_node->any_click_callback != FSM_NONE ||
+        current_node->any_hold_callback != FSM_NONE) {
+        return true;
+    }
+
+    /* clicks[count] is the next tap count; a next press held is holds[count] */
+    return slots_beyond(current_node->clicks, current_node->click_count, count) ||
+           slots_beyond(current_node->holds, current_node->hold_count, count);
+}
+
+/**
+ * @brief Run a callback by ID against the current node.
+ * @return Node requested by the callback, or NULL to stay.
+ */
+static const struct fsm_node *run_callback(uint8_t cb_id, int count)
+{
+    if (cb_id == FSM_NONE || cb_id >= fsm_table->callback_count) {
+        return NULL;
+    }
+
+    fsm_callback_t cb = fsm_table->callbacks[cb_id];
+    return cb ? cb(current_node, count) : NULL;
+}
+
+/**
+ * @brief Look up slot [count-1]: callback first, then the mapped target.
+ * @return true if a transition was taken.
+ */
+static bool dispatch_slot(const struct fsm_slot *slots, uint8_t slot_count, int count)
+{
+    if (count > slot_count) {
+        return false;
+    }
+
+    const struct fsm_slot *slot = &slots[count - 1];
+    const struct fsm_node *next_node = run_callback(slot->callback, count);
+
+    if (!next_node) {
+        next_node = fsm_get_node(slot->target);
+    }
+    if (next_node) {
+        fsm_transition_to(next_node);
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Taps and holds from a non-main source: only its own map applies.
+ */
+static void dispatch_source(uint8_t type, uint8_t source, int count)
+{
+    const struct fsm_input_map *map = find_input_map(current_node, source);
+
+    if (!map) {
+        LOG_DBG("No map for source %d on %s", source, current_node->name);
+        return;
+    }
+    if (type == MSG_INPUT_TAP) {
+        dispatch_slot(map->clicks, map->click_count, count);
+    } else {
+        dispatch_slot(map->holds, map->hold_count, count);
+    }
+}
+
 /**
  * @brief Internal dispatch for input events.
  */
-static void dispatch_input(uint8_t type, int count)
+static void dispatch_input(uint8_t type, uint8_t source, int count)
 {
     if (!current_node) return;
 
-    LOG_INF("Dispatch: type=%d, count=%d (Node: %s)", type, count, current_node->name);
-    reset_inactivity_timer();
+    static const uint8_t trace_event[] = {
+        [MSG_INPUT_TAP] = FSM_TRACE_TAP,
+        [MSG_INPUT_HOLD_START] = FSM_TRACE_HOLD,
+        [MSG_INPUT_HOLD_RELEASE] = FSM_TRACE_RELEASE,
+    };
+    if (type < ARRAY_SIZE(trace_event)) {
+        fsm_trace_record(trace_event[type], current_node->id, FSM_NONE, (uint8_t)count);
+    }
 
+    LOG_DBG("Dispatch: type=%d, src=%d, count=%d (Node: %s)", type, source, count, current_node->name);
+    reset_inactivity_timer();
 
-    int index = count - 1;
+    /* Encoder: signed detent count straight to the node's callback */
+    if (type == MSG_INPUT_ENCODER) {
+        fsm_transition_to(run_callback(current_node->encoder_callback, count));
+        return;
+    }
 
-    /* Handle HOLD_RELEASE */
+    /* Handle HOLD_RELEASE (ends a hold from any source) */
     if (type == MSG_INPUT_HOLD_RELEASE) {
-        if (current_node->release_callback) {
-            struct fsm_node *next = current_node->release_callback(current_node, 0);
-            if (next) fsm_transition_to(next);
-        }
+        fsm_transition_to(run_callback(current_node->release_callback, 0));
         return;
     }
 
     /* Bounds check */
-    if (count < 1 || count > MAX_NAV_SLOTS) {
+    if (count < 1) {
         LOG_WRN("Invalid count: %d", count);
         return;
     }
 
-    struct fsm_node *next_node = NULL;
-    fsm_callback_t cb = NULL;
+    if (source != INPUT_SRC_MAIN) {
+        dispatch_source(type, source, count);
+        return;
+    }
 
     if (type == MSG_INPUT_TAP) {
-        if (count >= 1 && count <= MAX_NAV_SLOTS) {
-            cb = current_node->click_callbacks[index];
-            if (cb) {
-                next_node = cb(current_node, count);
-                if (next_node) { fsm_transition_to(next_node); return; }
-            }
-            next_node = current_node->click_map[index];
-            if (next_node) {
-                LOG_INF("Click[%d]: -> %s", count, next_node->name);
-                fsm_transition_to(next_node);
-                return;
-            }
+        if (dispatch_slot(current_node->clicks, current_node->click_count, count)) {
+            return;
         }
-        
+
         /* Fallback to generic click callback */
-        if (current_node->any_click_callback) {
-            next_node = current_node->any_click_callback(current_node, count);
-            if (next_node) { fsm_transition_to(next_node); return; }
-        }
+        fsm_transition_to(run_callback(current_node->any_click_callback, count));
     }
     else if (type == MSG_INPUT_HOLD_START) {
-        if (count >= 1 && count <= MAX_NAV_SLOTS) {
-            cb = current_node->hold_callbacks[index];
-            if (cb) {
-                next_node = cb(current_node, count);
-                if (next_node) { fsm_transition_to(next_node); return; }
-            }
-            next_node = current_node->hold_map[index];
-            if (next_node) {
-                LOG_INF("Hold[%d]: -> %s", count, next_node->name);
-                fsm_transition_to(next_node);
-                return;
-            }
+        if (dispatch_slot(current_node->holds, current_node->hold_count, count)) {
+            return;
         }
 
         /* Fallback to generic hold callback */
-        if (current_node->any_hold_callback) {
-            next_node = current_node->any_hold_callback(current_node, count);
-            if (next_node) { fsm_transition_to(next_node); return; }
-        }
+        fsm_transition_to(run_callback(current_node->any_hold_callback, count));
+    }
+}
+
+void fsm_set_preview(const struct fsm_preview *p)
+{
+    preview = p;
+    preview_node = NULL;
+}
+
+void fsm_preview_press(void)
+{
+    if (!preview || !current_node) {
+        return;
+    }
+    if (preview->begin(current_node)) {
+        preview_node = current_node;
+        preview_mark = transition_count;
+    }
+}
+
+void fsm_set_momentary(const struct fsm_momentary *m)
+{
+    k_mutex_lock(&momentary_lock, K_FOREVER);
+    momentary_armed = false;
+    momentary = m;
+    k_mutex_unlock(&momentary_lock);
+}
+
+bool fsm_momentary_edge(bool pressed)
+{
+    bool armed;
+
+    k_mutex_lock(&momentary_lock, K_FOREVER);
+    armed = momentary_armed;
+    if (armed) {
+        momentary->edge(pressed);
+    }
+    k_mutex_unlock(&momentary_lock);
+    return armed;
+}
+
+/* The main sequence resolved: keep the preview only if a node took over */
+static void settle_preview(void)
+{
+    if (!preview_node) {
+        return;
+    }
+    if (transition_count == preview_mark) {
+        LOG_DBG("FSM: Preview reverted on [%s]", preview_node->name);
+        preview->revert(preview_node);
     }
+    preview_node = NULL;
 }
 
 void fsm_process_msg(const struct zbeam_msg *msg)
 {
     if (!msg) return;
-    dispatch_input(msg->type, msg->count);
+
+    int count = msg->type == MSG_INPUT_ENCODER ? (int8_t)msg->count : msg->count;
+
+    dispatch_input(msg->type, msg->source, count);
+
+    /* Encoder detents and other buttons leave the main sequence pending */
+    if (msg->source == INPUT_SRC_MAIN &&
+        (msg->type == MSG_INPUT_TAP || msg->type == MSG_INPUT_HOLD_START)) {
+        settle_preview();
+    }
 }
 
 void fsm_process_timer(const struct zbeam_msg *msg)
@@ -165,17 +379,7 @@ void fsm_process_timer(const struct zbeam_msg *msg)
 
     switch (msg->type) {
     case MSG_TIMEOUT_INACTIVITY:
-        if (current_node && current_node->timeout_node) {
-             fsm_transition_to(current_node->timeout_node);
-        } else if (current_node && current_node->timeout_reverts && previous_node) {
-            fsm_transition_to(previous_node);
-        } else {
-            fsm_transition_to(home_node);
-        }
-        break;
-
-    case MSG_TIMEOUT_RAMP_TICK:
-        /* TODO: handle ramp tick */
+        handle_timeout();
         break;
 
     default:
@@ -187,7 +391,10 @@ void fsm_emergency_off(void)
 {
     LOG_WRN("FSM: EMERGENCY OFF!");
     emergency_shutdown_active = true;
-    k_timer_stop(&inactivity_timer);
+    fsm_trace_record(FSM_TRACE_EMERGENCY_OFF, NODE_ID(current_node), NODE_ID(home_node), 0);
+    fsm_deadline_stop(&inactivity_deadline);
+    momentary_disarm();
+    preview_node = NULL;
     current_node = home_node;
     if (current_node->action_routine) {
         current_node->action_routine();
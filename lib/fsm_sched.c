@@ -0,0 +1,170 @@
+/**
+ * @file fsm_sched.c
+ * @brief Deadline Scheduler Implementation.
+ *
+ * Deadlines are kept in a singly-linked list sorted by expiry, so the
+ * next global deadline is always the list head. The FSM worker sleeps on
+ * its wake semaphore with a timeout derived from the head and runs expired
+ * callbacks in its own context.
+ *
+ * Deadlines due within CONFIG_ZBEAM_FSM_SCHED_SLACK_MS of now are run in
+ * the same pass, merging near-coincident wakeups (e.g. a 20 ms buzz and a
+ * 10 ms AUX tick).
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/slist.h>
+#include <zephyr/spinlock.h>
+#include "fsm_sched.h"
+
+static sys_slist_t deadline_list = SYS_SLIST_STATIC_INIT(&deadline_list);
+static struct k_spinlock sched_lock;
+static struct k_sem *wake_sem;
+
+/* Caller must hold sched_lock. Returns true if dl became the new head. */
+static bool insert_sorted(struct fsm_deadline *dl)
+{
+    struct fsm_deadline *prev = NULL;
+    struct fsm_deadline *it;
+
+    SYS_SLIST_FOR_EACH_CONTAINER(&deadline_list, it, node) {
+        if (it->expiry_ms > dl->expiry_ms) {
+            break;
+        }
+        prev = it;
+    }
+
+    if (prev) {
+        sys_slist_insert(&deadline_list, &prev->node, &dl->node);
+    } else {
+        sys_slist_prepend(&deadline_list, &dl->node);
+    }
+    dl->armed = true;
+    return prev == NULL;
+}
+
+/* Caller must hold sched_lock. */
+static void unlink(struct fsm_deadline *dl)
+{
+    if (dl->armed) {
+        sys_slist_find_and_remove(&deadline_list, &dl->node);
+        dl->armed = false;
+    }
+}
+
+void fsm_deadline_init(struct fsm_deadline *dl, fsm_deadline_fn fn)
+{
+    *dl = (struct fsm_deadline)FSM_DEADLINE_INITIALIZER(fn);
+}
+
+static void arm(struct fsm_deadline *dl, int64_t expiry_ms, uint32_t period_ms)
+{
+    k_spinlock_key_t key = k_spin_lock(&sched_lock);
+
+    unlink(dl);
+    dl->expiry_ms = expiry_ms;
+    dl->period_ms = period_ms;
+    bool new_head = insert_sorted(dl);
+
+    k_spin_unlock(&sched_lock, key);
+
+    /* Worker may be sleeping towards a later deadline */
+    if (new_head && wake_sem) {
+        k_sem_give(wake_sem);
+    }
+}
+
+void fsm_deadline_start(struct fsm_deadline *dl, uint32_t delay_ms, uint32_t period_ms)
+{
+    arm(dl, k_uptime_get() + delay_ms, period_ms);
+}
+
+void fsm_deadline_start_at(struct fsm_deadline *dl, int64_t expiry_ms)
+{
+    arm(dl, expiry_ms, 0);
+}
+
+void fsm_deadline_stop(struct fsm_deadline *dl)
+{
+    k_spinlock_key_t key = k_spin_lock(&sched_lock);
+    unlink(dl);
+    k_spin_unlock(&sched_lock, key);
+}
+
+bool fsm_deadline_is_armed(const struct fsm_deadline *dl)
+{
+    return dl->armed;
+}
+
+int fsm_sched_next_deadline(int64_t *expiry_ms)
+{
+    int ret = -ENOENT;
+    k_spinlock_key_t key = k_spin_lock(&sched_lock);
+
+    struct fsm_deadline *head =
+        SYS_SLIST_PEEK_HEAD_CONTAINER(&deadline_list, head, node);
+    if (head) {
+        *expiry_ms = head->expiry_ms;
+        ret = 0;
+    }
+
+    k_spin_unlock(&sched_lock, key);
+    return ret;
+}
+
+k_timeout_t fsm_sched_next_timeout(void)
+{
+    int64_t expiry;
+
+    if (fsm_sched_next_deadline(&expiry) != 0) {
+        return K_FOREVER;
+    }
+
+    int64_t remaining = expiry - k_uptime_get();
+    return (remaining > 0) ? K_MSEC(remaining) : K_NO_WAIT;
+}
+
+int fsm_sched_run_expired(void)
+{
+    int64_t horizon = k_uptime_get() + CONFIG_ZBEAM_FSM_SCHED_SLACK_MS;
+    int ran = 0;
+
+    while (1) {
+        k_spinlock_key_t key = k_spin_lock(&sched_lock);
+
+        struct fsm_deadline *dl =
+            SYS_SLIST_PEEK_HEAD_CONTAINER(&deadline_list, dl, node);
+        if (!dl || dl->expiry_ms > horizon) {
+            k_spin_unlock(&sched_lock, key);
+            break;
+        }
+
+        sys_slist_get_not_empty(&deadline_list);
+        dl->armed = false;
+
+        if (dl->period_ms > 0) {
+            /* Re-arm before the callback so it may stop or restart itself */
+            dl->expiry_ms += dl->period_ms;
+            if (dl->expiry_ms <= horizon) {
+                /* Fell behind: skip missed periods rather than bursting */
+                dl->expiry_ms = horizon + dl->period_ms;
+            }
+            insert_sorted(dl);
+        }
+
+        fsm_deadline_fn fn = dl->fn;
+        k_spin_unlock(&sched_lock, key);
+
+        if (fn) {
+            fn(dl);
+        }
+        ran++;
+    }
+
+    return ran;
+}
+
+void fsm_sched_set_wake_sem(struct k_sem *sem)
+{
+    wake_sem = sem;
+}
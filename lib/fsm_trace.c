@@ -0,0 +1,120 @@
+/**
+ * @file fsm_trace.c
+ * @brief Binary FSM trace ring buffer.
+ *
+ * A power-of-two array of 8-byte entries indexed by a free-running
+ * atomic counter: recording is one atomic_inc() and a struct store, with
+ * no locks and no formatting. Readers snapshot the counter and walk the
+ * last CONFIG_ZBEAM_FSM_TRACE_DEPTH entries; an entry being overwritten
+ * concurrently may read torn, which is acceptable for a debug trace.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/util.h>
+#include "fsm_trace.h"
+
+#ifdef CONFIG_SHELL
+#include <zephyr/shell/shell.h>
+#endif
+
+#define TRACE_DEPTH CONFIG_ZBEAM_FSM_TRACE_DEPTH
+#define TRACE_MASK  (TRACE_DEPTH - 1)
+
+BUILD_ASSERT(IS_POWER_OF_TWO(TRACE_DEPTH), "FSM trace depth must be a power of two");
+BUILD_ASSERT(sizeof(struct fsm_trace_entry) == 8, "FSM trace entry must stay 8 bytes");
+
+static struct fsm_trace_entry ring[TRACE_DEPTH];
+static atomic_t head = ATOMIC_INIT(0);  /* Total entries ever recorded */
+
+void fsm_trace_record(uint8_t event, uint8_t from, uint8_t to, uint8_t count)
+{
+    uint32_t slot = (uint32_t)atomic_inc(&head) & TRACE_MASK;
+
+    ring[slot] = (struct fsm_trace_entry){
+        .uptime_ms = k_uptime_get_32(),
+        .event = event,
+        .from = from,
+        .to = to,
+        .count = count,
+    };
+}
+
+/* First index and length of the readable window */
+static uint32_t window(uint32_t *first)
+{
+    uint32_t total = (uint32_t)atomic_get(&head);
+    uint32_t n = MIN(total, TRACE_DEPTH);
+
+    *first = total - n;
+    return n;
+}
+
+size_t fsm_trace_read(struct fsm_trace_entry *buf, size_t max)
+{
+    uint32_t first;
+    uint32_t n = window(&first);
+
+    /* Keep the newest entries if the caller's buffer is short */
+    if (n > max) {
+        first += n - max;
+        n = max;
+    }
+    for (uint32_t i = 0; i < n; i++) {
+        buf[i] = ring[(first + i) & TRACE_MASK];
+    }
+    return n;
+}
+
+uint32_t fsm_trace_overwritten(void)
+{
+    uint32_t total = (uint32_t)atomic_get(&head);
+
+    return (total > TRACE_DEPTH) ? total - TRACE_DEPTH : 0;
+}
+
+void fsm_trace_clear(void)
+{
+    atomic_set(&head, 0);
+}
+
+void fsm_trace_dump(void)
+{
+    uint32_t first;
+    uint32_t n = window(&first);
+
+    printk("FSMTRACE BEGIN %u %u\n", n, fsm_trace_overwritten());
+    for (uint32_t i = 0; i < n; i++) {
+        const struct fsm_trace_entry *e = &ring[(first + i) & TRACE_MASK];
+        uint32_t t = e->uptime_ms;
+
+        /* Explicit little-endian so the host decoder is target-agnostic */
+        printk("FSMTRACE %02x%02x%02x%02x%02x%02x%02x%02x\n",
+               t & 0xff, (t >> 8) & 0xff, (t >> 16) & 0xff, t >> 24,
+               e->event, e->from, e->to, e->count);
+    }
+    printk("FSMTRACE END\n");
+}
+
+#ifdef CONFIG_SHELL
+static int cmd_fsmtrace_dump(const struct shell *sh, size_t argc, char **argv)
+{
+    fsm_trace_dump();
+    return 0;
+}
+
+static int cmd_fsmtrace_clear(const struct shell *sh, size_t argc, char **argv)
+{
+    fsm_trace_clear();
+    shell_print(sh, "FSM trace cleared");
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_fsmtrace,
+    SHELL_CMD(dump, NULL, "Print trace for scripts/decode_fsm_trace.py", cmd_fsmtrace_dump),
+    SHELL_CMD(clear, NULL, "Discard trace entries", cmd_fsmtrace_clear),
+    SHELL_SUBCMD_SET_END
+);
+
+SHELL_CMD_REGISTER(fsmtrace, &sub_fsmtrace, "Binary FSM event trace", NULL);
+#endif /* CONFIG_SHELL */
@@ -4,97 +4,378 @@
  *
  * Single worker thread that processes all FSM-related messages
  * in a safe, non-ISR context.
+ *
+ * Messages are split into priority lanes (safety > input > edge >
+ * housekeeping), each with its own k_msgq, except raw key edges: they
+ * come from a single producer (the input callback) and use a lock-free
+ * SPSC ring, so posting one takes no kernel lock. A binary semaphore kicks the worker, which then
+ * drains everything pending, always taking from the highest non-empty lane,
+ * so a safety event never waits behind an input backlog. Shutdown requests
+ * bypass the lanes entirely via a reserved atomic slot and can never be
+ * dropped.
+ *
+ * Redundant messages are coalesced at dequeue time: consecutive thermal
+ * warnings keep only the highest severity.
+ *
+ * The worker also owns the deadline scheduler (fsm_sched.c): it sleeps
+ * until either a message is posted or the next deadline is due, so all
+ * FSM/UI timing runs on this one thread.
  */
 
 #include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
 #include <zephyr/logging/log.h>
 #include "fsm_worker.h"
 #include "fsm_engine.h"
+#include "fsm_sched.h"
+#include "multi_tap_input.h"
+#include "latency_stats.h"
+#include "spsc_ring.h"
 #include "zbeam_msg.h"
 
 LOG_MODULE_REGISTER(fsm_worker, LOG_LEVEL_INF);
 
-/* Message queue - statically allocated */
-K_MSGQ_DEFINE(fsm_msgq, sizeof(struct zbeam_msg), 
+/* Lane queues - statically allocated */
+K_MSGQ_DEFINE(fsm_safety_msgq, sizeof(struct zbeam_msg),
+              CONFIG_ZBEAM_FSM_SAFETY_MSGQ_DEPTH, 4);
+K_MSGQ_DEFINE(fsm_input_msgq, sizeof(struct zbeam_msg),
               CONFIG_ZBEAM_FSM_MSGQ_DEPTH, 4);
+K_MSGQ_DEFINE(fsm_housekeeping_msgq, sizeof(struct zbeam_msg),
+              CONFIG_ZBEAM_FSM_HOUSEKEEPING_MSGQ_DEPTH, 4);
+SPSC_RING_DEFINE(fsm_edge_ring, CONFIG_ZBEAM_FSM_EDGE_RING_DEPTH);
+
+/* Binary kick: any number of posts between wakeups cost one context switch */
+K_SEM_DEFINE(fsm_wake_sem, 0, 1);
+
+/* Reserved shutdown slots (bit set = pending) */
+#define RESERVED_SAFETY_SHUTDOWN 0
+#define RESERVED_SYSTEM_SHUTDOWN 1
+static atomic_t reserved_pending = ATOMIC_INIT(0);
+
+struct lane_ctx {
+    struct k_msgq *q;           /* NULL for the ring-backed edge lane */
+    atomic_t posted;
+    atomic_t dropped;
+    atomic_t high_water;
+};
+
+static struct lane_ctx lanes[FSM_LANE_COUNT] = {
+    [FSM_LANE_SAFETY]       = { .q = &fsm_safety_msgq },
+    [FSM_LANE_INPUT]        = { .q = &fsm_input_msgq },
+    [FSM_LANE_EDGE]         = { .q = NULL },
+    [FSM_LANE_HOUSEKEEPING] = { .q = &fsm_housekeeping_msgq },
+};
+
+/* Worker-wide counters (received == processed + coalesced + pending) */
+static atomic_t stat_received;
+static atomic_t stat_processed;
+static atomic_t stat_coalesced;
+static atomic_t stat_wakeups;
+static atomic_t stat_deadlines;
 
 static volatile bool worker_running = false;
 
+static enum fsm_lane lane_for_type(uint8_t type)
+{
+    switch (type) {
+    case MSG_SAFETY_SHUTDOWN:
+    case MSG_SAFETY_THERMAL_WARN:
+    case MSG_SYSTEM_SHUTDOWN:
+        return FSM_LANE_SAFETY;
+    case MSG_INPUT_TAP:
+    case MSG_INPUT_HOLD_START:
+    case MSG_INPUT_HOLD_RELEASE:
+    case MSG_INPUT_EDGE:
+    case MSG_INPUT_ENCODER:
+        return FSM_LANE_INPUT;
+    default:
+        return FSM_LANE_HOUSEKEEPING;
+    }
+}
+
+static uint32_t lane_depth(const struct lane_ctx *lane)
+{
+    return lane->q ? k_msgq_num_used_get(lane->q) : spsc_ring_count(&fsm_edge_ring);
+}
+
+static void update_high_water(struct lane_ctx *lane)
+{
+    atomic_val_t used = (atomic_val_t)lane_depth(lane);
+    atomic_val_t peak;
+
+    do {
+        peak = atomic_get(&lane->high_water);
+        if (used <= peak) {
+            return;
+        }
+    } while (!atomic_cas(&lane->high_water, peak, used));
+}
+
+/**
+ * @brief Dispatch one message to the FSM engine.
+ */
+static void dispatch_msg(const struct zbeam_msg *msg)
+{
+    LOG_DBG("Processing msg type=%d count=%d", msg->type, msg->count);
+
+    switch (msg->type) {
+    /* Safety Events - highest priority handling */
+    case MSG_SAFETY_SHUTDOWN:
+        LOG_WRN("SAFETY SHUTDOWN received!");
+        fsm_emergency_off();
+        break;
+
+    case MSG_SAFETY_THERMAL_WARN:
+        LOG_WRN("Thermal warning: severity=%d", msg->severity);
+        /* TODO: Implement gradual power reduction */
+        break;
+
+    /* Input Events */
+    case MSG_INPUT_TAP:
+    case MSG_INPUT_HOLD_START:
+    case MSG_INPUT_HOLD_RELEASE:
+        fsm_process_msg(msg);
+        break;
+
+    case MSG_INPUT_EDGE:
+        multi_tap_input_process_edge(msg);
+        break;
+
+    case MSG_INPUT_ENCODER: {
+        struct zbeam_msg detents = *msg;
+
+        if (multi_tap_input_take_encoder(&detents)) {
+            fsm_process_msg(&detents);
+        }
+        break;
+    }
+
+    /* Timer Events */
+    case MSG_TIMEOUT_INACTIVITY:
+        fsm_process_timer(msg);
+        break;
+
+    /* System Events */
+    case MSG_SYSTEM_SHUTDOWN:
+        LOG_INF("System shutdown requested");
+        fsm_emergency_off();
+        break;
+
+    default:
+        LOG_WRN("Unknown message type: %d", msg->type);
+        break;
+    }
+}
+
+static bool is_coalescible(uint8_t type)
+{
+    return type == MSG_SAFETY_THERMAL_WARN;
+}
+
+/**
+ * @brief Fold same-type messages waiting at the head of @p q into @p msg.
+ *
+ * Only the worker consumes from a lane, so the peeked head is still the
+ * head when it is taken.
+ */
+static void coalesce_msg(struct k_msgq *q, struct zbeam_msg *msg)
+{
+    struct zbeam_msg next;
+
+    while (k_msgq_peek(q, &next) == 0 && next.type == msg->type) {
+        k_msgq_get(q, &next, K_NO_WAIT);
+        atomic_inc(&stat_coalesced);
+        msg->severity = MAX(msg->severity, next.severity);
+    }
+}
+
+/**
+ * @brief Take the next message in strict priority order.
+ * @return true if a message was dequeued.
+ */
+static bool take_next_msg(struct zbeam_msg *msg)
+{
+    if (atomic_test_and_clear_bit(&reserved_pending, RESERVED_SAFETY_SHUTDOWN)) {
+        *msg = (struct zbeam_msg){ .type = MSG_SAFETY_SHUTDOWN, .severity = 255 };
+        return true;
+    }
+    if (atomic_test_and_clear_bit(&reserved_pending, RESERVED_SYSTEM_SHUTDOWN)) {
+        *msg = (struct zbeam_msg){ .type = MSG_SYSTEM_SHUTDOWN };
+        return true;
+    }
+
+    for (int i = 0; i < FSM_LANE_COUNT; i++) {
+        if (!lanes[i].q) {
+            if (spsc_ring_get(&fsm_edge_ring, msg) == 0) {
+                return true;
+            }
+            continue;
+        }
+        if (k_msgq_get(lanes[i].q, msg, K_NO_WAIT) == 0) {
+            if (is_coalescible(msg->type)) {
+                coalesce_msg(lanes[i].q, msg);
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
 /**
  * @brief FSM worker thread entry point.
  *
- * Blocks on message queue and dispatches to FSM engine.
+ * Blocks on the wake semaphore until kicked or the next deadline is due,
+ * then drains every pending message and runs expired deadlines. Messages
+ * go first so a pending shutdown beats any timer callback; priority is
+ * re-evaluated before each message, so a shutdown posted mid-batch is
+ * handled next.
  */
 static void fsm_worker_entry(void *p1, void *p2, void *p3)
 {
     struct zbeam_msg msg;
+    int ran;
 
     LOG_INF("FSM worker thread started");
+    fsm_sched_set_wake_sem(&fsm_wake_sem);
     worker_running = true;
 
     while (1) {
-        /* Block waiting for message */
-        int ret = k_msgq_get(&fsm_msgq, &msg, K_FOREVER);
-        if (ret != 0) {
-            continue;
-        }
+        k_sem_take(&fsm_wake_sem, fsm_sched_next_timeout());
+        atomic_inc(&stat_wakeups);
 
-        LOG_DBG("Processing msg type=%d count=%d", msg.type, msg.count);
-
-        switch (msg.type) {
-        /* Safety Events - highest priority handling */
-        case MSG_SAFETY_SHUTDOWN:
-            LOG_WRN("SAFETY SHUTDOWN received!");
-            fsm_emergency_off();
-            break;
-
-        case MSG_SAFETY_THERMAL_WARN:
-            LOG_WRN("Thermal warning: severity=%d", msg.severity);
-            /* TODO: Implement gradual power reduction */
-            break;
-
-        /* Input Events */
-        case MSG_INPUT_TAP:
-        case MSG_INPUT_HOLD_START:
-        case MSG_INPUT_HOLD_RELEASE:
-            fsm_process_msg(&msg);
-            break;
-
-        /* Timer Events */
-        case MSG_TIMEOUT_INACTIVITY:
-        case MSG_TIMEOUT_RAMP_TICK:
-            fsm_process_timer(&msg);
-            break;
-
-        /* System Events */
-        case MSG_SYSTEM_SHUTDOWN:
-            LOG_INF("System shutdown requested");
-            fsm_emergency_off();
-            break;
-
-        default:
-            LOG_WRN("Unknown message type: %d", msg.type);
-            break;
-        }
+        do {
+            while (take_next_msg(&msg)) {
+                atomic_inc(&stat_processed);
+                latency_stats_begin(&msg);
+                dispatch_msg(&msg);
+                latency_stats_end();
+            }
+            /* Callbacks may post messages (e.g. a resolved tap) */
+            ran = fsm_sched_run_expired();
+            atomic_add(&stat_deadlines, ran);
+        } while (ran > 0);
     }
 }
 
+static int post_reserved(int bit)
+{
+    /* Re-posting an already pending shutdown is a no-op, not a drop */
+    if (!atomic_test_and_set_bit(&reserved_pending, bit)) {
+        atomic_inc(&lanes[FSM_LANE_SAFETY].posted);
+        atomic_inc(&stat_received);
+        k_sem_give(&fsm_wake_sem);
+    }
+    return 0;
+}
+
 int fsm_worker_post_msg(const struct zbeam_msg *msg)
 {
     if (msg == NULL) {
         return -EINVAL;
     }
-    
-    int ret = k_msgq_put(&fsm_msgq, msg, K_NO_WAIT);
+
+    if (msg->type == MSG_SAFETY_SHUTDOWN) {
+        return post_reserved(RESERVED_SAFETY_SHUTDOWN);
+    }
+    if (msg->type == MSG_SYSTEM_SHUTDOWN) {
+        return post_reserved(RESERVED_SYSTEM_SHUTDOWN);
+    }
+
+    enum fsm_lane lane_id = lane_for_type(msg->type);
+    struct lane_ctx *lane = &lanes[lane_id];
+
+#ifdef CONFIG_ZBEAM_LATENCY_STATS
+    /* Messages without an origin stamp (timers, safety) start here */
+    struct zbeam_msg stamped = *msg;
+    if (latency_stamp_of(&stamped) == 0) {
+        latency_stamp(&stamped, k_cycle_get_32());
+    }
+    msg = &stamped;
+#endif
+
+    int ret = k_msgq_put(lane->q, msg, K_NO_WAIT);
     if (ret != 0) {
-        LOG_WRN("FSM queue full, dropping msg type=%d", msg->type);
+        atomic_inc(&lane->dropped);
+        LOG_WRN("FSM lane %d full, dropping msg type=%d", lane_id, msg->type);
+        return ret;
+    }
+
+    atomic_inc(&lane->posted);
+    atomic_inc(&stat_received);
+    update_high_water(lane);
+    k_sem_give(&fsm_wake_sem);
+    return 0;
+}
+
+int fsm_worker_post_edge(const struct zbeam_msg *edge)
+{
+    struct lane_ctx *lane = &lanes[FSM_LANE_EDGE];
+    int waiting = spsc_ring_put(&fsm_edge_ring, edge);
+
+    if (waiting < 0) {
+        atomic_inc(&lane->dropped);
+        LOG_WRN("FSM edge ring full, dropping edge");
+        return waiting;
+    }
+
+    atomic_inc(&lane->posted);
+    atomic_inc(&stat_received);
+    update_high_water(lane);
+    /* A non-empty ring means the worker has not finished draining yet */
+    if (waiting == 1) {
+        k_sem_give(&fsm_wake_sem);
     }
-    return ret;
+    return 0;
 }
 
-struct k_msgq *fsm_worker_get_queue(void)
+struct k_msgq *fsm_worker_get_queue(enum fsm_lane lane)
 {
-    return &fsm_msgq;
+    if (lane >= FSM_LANE_COUNT) {
+        return NULL;
+    }
+    return lanes[lane].q;
+}
+
+int fsm_worker_get_lane_stats(enum fsm_lane lane, struct fsm_lane_stats *stats)
+{
+    if (lane >= FSM_LANE_COUNT || stats == NULL) {
+        return -EINVAL;
+    }
+
+    stats->posted = (uint32_t)atomic_get(&lanes[lane].posted);
+    stats->dropped = (uint32_t)atomic_get(&lanes[lane].dropped);
+    stats->depth = (uint16_t)lane_depth(&lanes[lane]);
+    stats->high_water = (uint16_t)atomic_get(&lanes[lane].high_water);
+    return 0;
+}
+
+int fsm_worker_get_stats(struct fsm_worker_stats *stats)
+{
+    if (stats == NULL) {
+        return -EINVAL;
+    }
+
+    stats->received = (uint32_t)atomic_get(&stat_received);
+    stats->processed = (uint32_t)atomic_get(&stat_processed);
+    stats->coalesced = (uint32_t)atomic_get(&stat_coalesced);
+    stats->wakeups = (uint32_t)atomic_get(&stat_wakeups);
+    stats->deadlines = (uint32_t)atomic_get(&stat_deadlines);
+    return 0;
+}
+
+void fsm_worker_reset_stats(void)
+{
+    atomic_clear(&stat_received);
+    atomic_clear(&stat_processed);
+    atomic_clear(&stat_coalesced);
+    atomic_clear(&stat_wakeups);
+    atomic_clear(&stat_deadlines);
+
+    for (int i = 0; i < FSM_LANE_COUNT; i++) {
+        atomic_clear(&lanes[i].posted);
+        atomic_clear(&lanes[i].dropped);
+        atomic_set(&lanes[i].high_water, (atomic_val_t)lane_depth(&lanes[i]));
+    }
 }
 
 bool fsm_worker_is_running(void)
@@ -0,0 +1,212 @@
+/**
+ * @file latency_stats.c
+ * @brief Input-to-photon latency histograms.
+ *
+ * One histogram per (message type, stage). Buckets are powers of two in
+ * microseconds: bucket b holds [2^(b-1), 2^b) us, bucket 0 holds 0 us.
+ * 24 buckets cover ~8 s, enough for a tap (which includes the click
+ * timeout) as well as a hold.
+ *
+ * Dispatch and output samples are recorded only on the FSM worker
+ * thread. Fast-path samples come from the input thread too and take
+ * fast_lock. Readers may see a torn summary while a sample is being
+ * added, which is acceptable for diagnostics.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/util.h>
+#include <string.h>
+#include "latency_stats.h"
+#include "zbeam_msg.h"
+
+#ifdef CONFIG_SHELL
+#include <zephyr/shell/shell.h>
+#endif
+
+LOG_MODULE_REGISTER(latency_stats, LOG_LEVEL_INF);
+
+#define LATENCY_BUCKETS 24
+
+struct latency_hist {
+    uint32_t count;
+    uint32_t min_us;
+    uint32_t max_us;
+    uint64_t sum_us;
+    uint16_t buckets[LATENCY_BUCKETS];
+};
+
+static struct latency_hist hists[MSG_TYPE_COUNT][LATENCY_STAGE_COUNT];
+
+/* Message currently being dispatched by the worker */
+static bool in_flight;
+static bool output_seen;
+static uint8_t in_flight_type;
+static uint32_t in_flight_stamp;
+static k_tid_t in_flight_thread;
+
+static struct k_spinlock fast_lock;
+
+static const char *const stage_names[LATENCY_STAGE_COUNT] = {
+    [LATENCY_STAGE_DISPATCH]  = "dispatch",
+    [LATENCY_STAGE_OUTPUT]    = "output",
+    [LATENCY_STAGE_FAST_PATH] = "fastpath",
+};
+
+static int bucket_for(uint32_t us)
+{
+    int b = (us == 0) ? 0 : 32 - __builtin_clz(us);
+    return MIN(b, LATENCY_BUCKETS - 1);
+}
+
+static void record(uint8_t type, enum latency_stage stage, uint32_t stamp)
+{
+    if (type >= MSG_TYPE_COUNT) {
+        return;
+    }
+
+    struct latency_hist *h = &hists[type][stage];
+    uint32_t us = k_cyc_to_us_floor32(k_cycle_get_32() - stamp);
+    uint16_t *bucket = &h->buckets[bucket_for(us)];
+
+    if (h->count == 0 || us < h->min_us) {
+        h->min_us = us;
+    }
+    if (us > h->max_us) {
+        h->max_us = us;
+    }
+    h->sum_us += us;
+    h->count++;
+    if (*bucket < UINT16_MAX) {
+        (*bucket)++;
+    }
+}
+
+void latency_stats_begin(const struct zbeam_msg *msg)
+{
+    in_flight_type = msg->type;
+    in_flight_stamp = msg->timestamp;
+    in_flight_thread = k_current_get();
+    output_seen = false;
+    in_flight = true;
+    record(msg->type, LATENCY_STAGE_DISPATCH, msg->timestamp);
+}
+
+void latency_stats_end(void)
+{
+    in_flight = false;
+}
+
+void latency_stats_mark_output(void)
+{
+    /* Writes from other threads are not the dispatched message's doing */
+    if (!in_flight || output_seen || k_current_get() != in_flight_thread) {
+        return;
+    }
+    output_seen = true;
+    record(in_flight_type, LATENCY_STAGE_OUTPUT, in_flight_stamp);
+}
+
+void latency_stats_mark_fast_path(uint32_t cycles)
+{
+    k_spinlock_key_t key = k_spin_lock(&fast_lock);
+
+    record(MSG_INPUT_EDGE, LATENCY_STAGE_FAST_PATH, cycles);
+    k_spin_unlock(&fast_lock, key);
+}
+
+int latency_stats_get(uint8_t type, enum latency_stage stage,
+                      struct latency_summary *out)
+{
+    if (type >= MSG_TYPE_COUNT || stage >= LATENCY_STAGE_COUNT || out == NULL) {
+        return -EINVAL;
+    }
+
+    const struct latency_hist *h = &hists[type][stage];
+
+    *out = (struct latency_summary){ 0 };
+    if (h->count == 0) {
+        return 0;
+    }
+
+    out->count = h->count;
+    out->min_us = h->min_us;
+    out->max_us = h->max_us;
+    out->avg_us = (uint32_t)(h->sum_us / h->count);
+
+    /* Bucket counts saturate, so rank against their own total */
+    uint32_t total = 0;
+    for (int b = 0; b < LATENCY_BUCKETS; b++) {
+        total += h->buckets[b];
+    }
+
+    uint32_t rank = DIV_ROUND_UP(total * 99U, 100U);
+    uint32_t seen = 0;
+    for (int b = 0; b < LATENCY_BUCKETS; b++) {
+        seen += h->buckets[b];
+        if (seen >= rank) {
+            uint32_t upper = (b == 0) ? 0 : (BIT(b) - 1);
+            out->p99_us = MIN(upper, h->max_us);
+            break;
+        }
+    }
+    return 0;
+}
+
+void latency_stats_reset(void)
+{
+    memset(hists, 0, sizeof(hists));
+}
+
+void latency_stats_log(void)
+{
+    struct latency_summary s;
+
+    for (int type = 0; type < MSG_TYPE_COUNT; type++) {
+        for (int stage = 0; stage < LATENCY_STAGE_COUNT; stage++) {
+            latency_stats_get(type, stage, &s);
+            if (s.count == 0) {
+                continue;
+            }
+            LOG_INF("type=%d %-8s n=%u min=%u avg=%u p99=%u max=%u us",
+                    type, stage_names[stage], s.count,
+                    s.min_us, s.avg_us, s.p99_us, s.max_us);
+        }
+    }
+}
+
+#ifdef CONFIG_SHELL
+static int cmd_latency_show(const struct shell *sh, size_t argc, char **argv)
+{
+    struct latency_summary s;
+
+    shell_print(sh, "type stage    count    min    avg    p99    max (us)");
+    for (int type = 0; type < MSG_TYPE_COUNT; type++) {
+        for (int stage = 0; stage < LATENCY_STAGE_COUNT; stage++) {
+            latency_stats_get(type, stage, &s);
+            if (s.count == 0) {
+                continue;
+            }
+            shell_print(sh, "%4d %-8s %5u %6u %6u %6u %6u",
+                        type, stage_names[stage], s.count,
+                        s.min_us, s.avg_us, s.p99_us, s.max_us);
+        }
+    }
+    return 0;
+}
+
+static int cmd_latency_reset(const struct shell *sh, size_t argc, char **argv)
+{
+    latency_stats_reset();
+    shell_print(sh, "Latency histograms cleared");
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_latency,
+    SHELL_CMD(show, NULL, "Show per-type latency summary", cmd_latency_show),
+    SHELL_CMD(reset, NULL, "Clear histograms", cmd_latency_reset),
+    SHELL_SUBCMD_SET_END
+);
+
+SHELL_CMD_REGISTER(latency, &sub_latency, "Input-to-photon latency", NULL);
+#endif /* CONFIG_SHELL */
@@ -0,0 +1,376 @@
+/**
+ * @file led_pattern.c
+ * @brief Bytecode LED pattern executor.
+ *
+ * One deadline drives the playing pattern. Each expiry interprets opcodes
+ * until the next hold, then re-arms at the exact time the output must
+ * change next: holds are chained from the previous expiry (not from now)
+ * so worker latency does not accumulate, and ramps wake only when the
+ * interpolated level actually moves. All entry points run on the FSM
+ * worker, so the state needs no locking.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/random/random.h>
+#include <zephyr/sys/util.h>
+#include <stdlib.h>
+#include <string.h>
+#include "led_pattern.h"
+#include "fsm_sched.h"
+
+LOG_MODULE_REGISTER(led_pattern, LOG_LEVEL_INF);
+
+/* Guard against patterns that loop without ever holding */
+#define MAX_OPS_PER_STEP 64
+
+static void pattern_step(struct fsm_deadline *dl);
+static FSM_DEADLINE_DEFINE(pattern_deadline, pattern_step);
+
+static led_pattern_output_t output;
+static led_pattern_done_t on_done;
+
+static const struct led_pattern *cur;
+static uint16_t pc;
+static uint16_t args[LED_PATTERN_ARGS];
+static uint8_t level;
+static int64_t next_ms;  /* Scheduled time of the current step */
+
+static struct {
+    uint16_t pc;    /* First opcode of the block */
+    uint16_t left;  /* Passes remaining, including the current one */
+} loops[LED_PATTERN_LOOP_DEPTH];
+static uint8_t depth;
+
+static struct {
+    uint8_t from;
+    uint8_t to;
+    uint16_t ms;
+    uint16_t t;     /* Elapsed ramp time at the current step */
+} ramp;
+static bool ramping;
+
+/* Operand bytes following each opcode */
+static const uint8_t operand_len[] = {
+    [PAT_OP_END] = 0,
+    [PAT_OP_RESTART] = 0,
+    [PAT_OP_LEVEL] = 1,
+    [PAT_OP_LEVEL_ARG] = 1,
+    [PAT_OP_HOLD] = 2,
+    [PAT_OP_HOLD_ARG] = 1,
+    [PAT_OP_RAMP] = 3,
+    [PAT_OP_RAND_LEVEL] = 2,
+    [PAT_OP_RAND_HOLD] = 4,
+    [PAT_OP_REPEAT] = 1,
+    [PAT_OP_REPEAT_ARG] = 1,
+    [PAT_OP_NEXT] = 0,
+};
+
+static void set_level(uint8_t l)
+{
+    level = l;
+    output(l);
+}
+
+/* Running off the end of the code reads as PAT_OP_END */
+static uint8_t fetch(void)
+{
+    return (pc < cur->len) ? cur->code[pc++] : PAT_OP_END;
+}
+
+static uint16_t fetch16(void)
+{
+    uint16_t lo = fetch();
+
+    return lo | ((uint16_t)fetch() << 8);
+}
+
+static uint16_t get_arg(uint8_t idx)
+{
+    return (idx < LED_PATTERN_ARGS) ? args[idx] : 0;
+}
+
+static uint32_t rand_range(uint32_t lo, uint32_t hi)
+{
+    if (hi <= lo) {
+        return lo;
+    }
+    return lo + (sys_rand32_get() % (hi - lo + 1));
+}
+
+/* Arm the next step @p ms after the current one */
+static void wait(uint32_t ms)
+{
+    int64_t now = k_uptime_get();
+
+    next_ms += ms;
+    if (next_ms < now) {
+        /* Fell behind: resync rather than replaying missed steps */
+        next_ms = now;
+    }
+    fsm_deadline_start_at(&pattern_deadline, next_ms);
+}
+
+static bool hold(uint32_t ms)
+{
+    if (ms == 0) {
+        return false;
+    }
+    wait(ms);
+    return true;
+}
+
+/*
+ * Output the ramp level for ramp.t and arm the step at which the level
+ * next changes. Returns false once the ramp is complete.
+ */
+static bool ramp_advance(void)
+{
+    uint32_t span = abs((int)ramp.to - (int)ramp.from);
+    uint32_t moved = span * ramp.t / ramp.ms;
+
+    set_level(ramp.to > ramp.from ? ramp.from + moved : ramp.from - moved);
+    if (ramp.t >= ramp.ms) {
+        ramping = false;
+        return false;
+    }
+
+    /* First elapsed time at which one more level is reached */
+    uint32_t t_next = ((moved + 1) * ramp.ms + span - 1) / span;
+
+    wait(t_next - ramp.t);
+    ramp.t = t_next;
+    return true;
+}
+
+static bool start_ramp(uint8_t to, uint16_t ms)
+{
+    if (ms == 0) {
+        set_level(to);
+        return false;
+    }
+    if (to == level) {
+        return hold(ms);
+    }
+
+    ramp.from = level;
+    ramp.to = to;
+    ramp.ms = ms;
+    ramp.t = 0;
+    ramping = true;
+    return ramp_advance();
+}
+
+/* Skip a zero-count REPEAT block, past its matching NEXT */
+static bool skip_block(void)
+{
+    int nest = 0;
+
+    while (pc < cur->len) {
+        uint8_t op = cur->code[pc++];
+
+        if (op >= ARRAY_SIZE(operand_len)) {
+            return false;
+        }
+        if (op == PAT_OP_REPEAT || op == PAT_OP_REPEAT_ARG) {
+            nest++;
+        } else if (op == PAT_OP_NEXT && nest-- == 0) {
+            return true;
+        }
+        pc += operand_len[op];
+    }
+    return false;
+}
+
+static bool push_loop(uint16_t n)
+{
+    if (n == 0) {
+        return skip_block();
+    }
+    if (depth >= LED_PATTERN_LOOP_DEPTH) {
+        return false;
+    }
+    loops[depth].pc = pc;
+    loops[depth].left = n;
+    depth++;
+    return true;
+}
+
+static bool next_loop(void)
+{
+    if (depth == 0) {
+        return false;
+    }
+    if (--loops[depth - 1].left > 0) {
+        pc = loops[depth - 1].pc;
+    } else {
+        depth--;
+    }
+    return true;
+}
+
+static void finish(void)
+{
+    led_pattern_done_t done = on_done;
+
+    LOG_DBG("Pattern %s done", cur->name);
+    cur = NULL;
+    on_done = NULL;
+    if (done) {
+        done();
+    }
+}
+
+static void fail(uint8_t op, uint16_t at)
+{
+    LOG_ERR("Pattern %s: bad opcode %d at %d", cur->name, op, at);
+    led_pattern_stop();
+}
+
+/* Interpret opcodes until the next hold or the end */
+static void run(void)
+{
+    for (int ops = 0; ops < MAX_OPS_PER_STEP; ops++) {
+        uint16_t at = pc;
+        uint8_t op = fetch();
+        uint16_t lo, hi;
+
+        switch (op) {
+        case PAT_OP_END:
+            finish();
+            return;
+
+        case PAT_OP_RESTART:
+            pc = 0;
+            depth = 0;
+            break;
+
+        case PAT_OP_LEVEL:
+            set_level(fetch());
+            break;
+
+        case PAT_OP_LEVEL_ARG:
+            set_level(MIN(get_arg(fetch()), UINT8_MAX));
+            break;
+
+        case PAT_OP_HOLD:
+            if (hold(fetch16())) {
+                return;
+            }
+            break;
+
+        case PAT_OP_HOLD_ARG:
+            if (hold(get_arg(fetch()))) {
+                return;
+            }
+            break;
+
+        case PAT_OP_RAMP:
+            lo = fetch();
+            if (start_ramp(lo, fetch16())) {
+                return;
+            }
+            break;
+
+        case PAT_OP_RAND_LEVEL:
+            lo = fetch();
+            hi = fetch();
+            set_level(rand_range(lo, hi));
+            break;
+
+        case PAT_OP_RAND_HOLD:
+            lo = fetch16();
+            hi = fetch16();
+            if (hold(rand_range(lo, hi))) {
+                return;
+            }
+            break;
+
+        case PAT_OP_REPEAT:
+        case PAT_OP_REPEAT_ARG:
+            lo = (op == PAT_OP_REPEAT) ? fetch() : get_arg(fetch());
+            if (!push_loop(lo)) {
+                fail(op, at);
+                return;
+            }
+            break;
+
+        case PAT_OP_NEXT:
+            if (!next_loop()) {
+                fail(op, at);
+                return;
+            }
+            break;
+
+        default:
+            fail(op, at);
+            return;
+        }
+    }
+
+    LOG_ERR("Pattern %s: no hold within %d opcodes", cur->name, MAX_OPS_PER_STEP);
+    led_pattern_stop();
+}
+
+static void pattern_step(struct fsm_deadline *dl)
+{
+    if (!cur) {
+        return;
+    }
+    if (ramping && ramp_advance()) {
+        return;
+    }
+    run();
+}
+
+void led_pattern_init(led_pattern_output_t out)
+{
+    output = out;
+}
+
+int led_pattern_play(const struct led_pattern *pat, const uint16_t *init_args, size_t nargs,
+                     led_pattern_done_t done)
+{
+    if (!output) {
+        return -ENODEV;
+    }
+    if (!pat || nargs > LED_PATTERN_ARGS || (nargs > 0 && !init_args)) {
+        return -EINVAL;
+    }
+
+    led_pattern_stop();
+    LOG_DBG("Pattern %s start", pat->name);
+
+    memset(args, 0, sizeof(args));
+    if (nargs > 0) {
+        memcpy(args, init_args, nargs * sizeof(args[0]));
+    }
+    cur = pat;
+    pc = 0;
+    depth = 0;
+    on_done = done;
+    next_ms = k_uptime_get();
+
+    run();
+    return 0;
+}
+
+void led_pattern_set_arg(uint8_t idx, uint16_t value)
+{
+    if (idx < LED_PATTERN_ARGS) {
+        args[idx] = value;
+    }
+}
+
+void led_pattern_stop(void)
+{
+    fsm_deadline_stop(&pattern_deadline);
+    cur = NULL;
+    on_done = NULL;
+    ramping = false;
+}
+
+const struct led_pattern *led_pattern_current(void)
+{
+    return cur;
+}
@@ -4,16 +4,53 @@
  *
  * Detects clicks, holds, and multi-tap sequences.
  * Posts events to FSM worker via message queue.
+ *
+ * Every key source (main e-switch, tail switch, side button) has its own
+ * detector, so sequences on different buttons never mix; events carry the
+ * source in zbeam_msg.source. Keys are told apart by their input code
+ * (source_codes[]).
+ *
+ * Raw key edges are forwarded to the FSM worker as MSG_INPUT_EDGE through
+ * its lock-free edge ring (the input callback is the ring's only producer,
+ * so all key sources must report from one context) and processed there;
+ * the click/hold timeouts are worker deadlines, so the whole state machine
+ * runs on one thread. The only exception is the optional edge hook, which
+ * runs in the input callback itself.
+ *
+ * Contact bounce is filtered here rather than by gpio_keys: the first edge
+ * of a change is forwarded at once, stamped when the callback saw it, and
+ * further edges within CONFIG_ZBEAM_INPUT_DEBOUNCE_MS are treated as
+ * chatter. When the window closes, a worker deadline re-checks the level
+ * so a press shorter than the window is not lost; that edge is processed
+ * in place, as the worker cannot produce into the ring.
+ *
+ * Rotary encoder detents are summed in the input callback and announced
+ * by a single MSG_INPUT_ENCODER; more detents arriving before the worker
+ * takes the sum only add to it, so fast rotation cannot flood the lane.
+ *
+ * With CONFIG_ZBEAM_ADAPTIVE_TAP the click timeout is learned from the
+ * gaps between taps (tap_cadence.h). A press that lands after a learned
+ * timeout but within the configured one probably belonged to the previous
+ * sequence, so its gap is learned too and the timeout grows back.
  */
 
 #include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
 #include <zephyr/logging/log.h>
 #include <zephyr/input/input.h>
 #include <zephyr/dt-bindings/input/input-event-codes.h>
 
 #include "multi_tap_input.h"
 #include "fsm_worker.h"
+#include "fsm_sched.h"
+#include "fsm_trace.h"
+#include "latency_stats.h"
 #include "zbeam_msg.h"
+#ifdef CONFIG_ZBEAM_ADAPTIVE_TAP
+#include <stdlib.h>
+#include "tap_cadence.h"
+#include "nvs_manager.h"
+#endif
 
 LOG_MODULE_REGISTER(MultiTap, LOG_LEVEL_INF);
 
@@ -21,6 +58,13 @@ LOG_MODULE_REGISTER(MultiTap, LOG_LEVEL_INF);
 static uint32_t click_timeout_ms = CONFIG_ZBEAM_CLICK_TIMEOUT_MS;
 static uint32_t hold_duration_ms = CONFIG_ZBEAM_HOLD_DURATION_MS;
 
+/* Input code reported by each key source (gpio_keys zephyr,code) */
+static const uint16_t source_codes[INPUT_SRC_KEY_COUNT] = {
+    [INPUT_SRC_MAIN] = INPUT_KEY_0,
+    [INPUT_SRC_TAIL] = INPUT_KEY_1,
+    [INPUT_SRC_SIDE] = INPUT_KEY_2,
+};
+
 /* FSM States */
 enum multi_tap_state {
     STATE_IDLE,
@@ -28,60 +72,191 @@ enum multi_tap_state {
     STATE_WAIT_TIMEOUT,
 };
 
-/* State Variables */
-static enum multi_tap_state current_state = STATE_IDLE;
-static int click_count = 0;
-static bool is_holding = false;
+/* Per-source tap detector */
+struct tap_detector {
+    enum multi_tap_state state;
+    int click_count;
+    bool is_holding;
+    uint32_t last_edge_cycles;  /* Origin stamp for posted events */
+    struct fsm_deadline click_deadline;
+    struct fsm_deadline hold_deadline;
+#ifdef CONFIG_ZBEAM_ADAPTIVE_TAP
+    uint32_t release_ms;        /* Uptime of the last tap release */
+    bool timed_out;             /* Last sequence was committed by the click timeout */
+#endif
+
+    /* Software debounce (input_cb and the settle deadline, under debounce_lock) */
+    bool raw_pressed;           /* Last level reported by the driver */
+    bool stable_pressed;        /* Last level forwarded */
+    uint32_t raw_cycles;        /* When the driver reported raw_pressed */
+    uint32_t accepted_cycles;   /* When stable_pressed was forwarded */
+    struct fsm_deadline debounce_deadline;
+};
+
+/* Deadlines (run on the FSM worker thread) */
+static void click_timeout(struct fsm_deadline *dl);
+static void hold_timeout(struct fsm_deadline *dl);
+static void debounce_settle(struct fsm_deadline *dl);
+
+#define TAP_DETECTOR_INITIALIZER {                                  \
+    .click_deadline = FSM_DEADLINE_INITIALIZER(click_timeout),       \
+    .hold_deadline = FSM_DEADLINE_INITIALIZER(hold_timeout),         \
+    .debounce_deadline = FSM_DEADLINE_INITIALIZER(debounce_settle),  \
+}
+
+static struct tap_detector detectors[INPUT_SRC_KEY_COUNT] = {
+    [0 ... INPUT_SRC_KEY_COUNT - 1] = TAP_DETECTOR_INITIALIZER,
+};
+static struct k_spinlock debounce_lock;
+
+static multi_tap_continue_fn can_continue;
+static multi_tap_press_fn press_hook;
+static multi_tap_edge_fn edge_hook;  /* Runs in the input callback */
+
+/* Encoder (summed in the input callback, taken by the worker) */
+static atomic_t encoder_delta;       /* Detents not yet taken */
+static atomic_t encoder_pending;     /* A MSG_INPUT_ENCODER is in flight */
 
-/* Timers */
-static struct k_timer click_timer;
-static struct k_timer hold_timer;
+#ifdef CONFIG_ZBEAM_ADAPTIVE_TAP
+/* Learned timeouts are only saved after drifting this far */
+#define CADENCE_SAVE_STEP_MS 16
 
-static void post_event(uint8_t type, uint8_t count)
+/* One cadence per user: every key source feeds it */
+static struct tap_cadence cadence;
+static uint32_t saved_timeout_ms;  /* Learned timeout last written to NVS */
+#endif
+
+static uint8_t detector_source(const struct tap_detector *det)
+{
+    return (uint8_t)(det - detectors);
+}
+
+static void post_event(struct tap_detector *det, uint8_t type, uint8_t count)
 {
     struct zbeam_msg msg = {
         .type = type,
         .count = count,
+        .source = detector_source(det),
     };
+    latency_stamp(&msg, det->last_edge_cycles);
     fsm_worker_post_msg(&msg);
 }
 
-static void click_timer_handler(struct k_timer *timer_id)
+/* Click timeout for the next gap: learned, or the configured one */
+static uint32_t commit_timeout_ms(void)
+{
+#ifdef CONFIG_ZBEAM_ADAPTIVE_TAP
+    return tap_cadence_timeout(&cadence, CONFIG_ZBEAM_ADAPTIVE_TAP_MIN_MS, click_timeout_ms);
+#else
+    return click_timeout_ms;
+#endif
+}
+
+#ifdef CONFIG_ZBEAM_ADAPTIVE_TAP
+static void cadence_load(void)
+{
+    uint8_t mean, dev;
+
+    tap_cadence_init(&cadence);
+    if (nvs_read_byte(NVS_ID_TAP_GAP_MEAN, &mean) == 0 &&
+        nvs_read_byte(NVS_ID_TAP_GAP_DEV, &dev) == 0) {
+        tap_cadence_restore(&cadence, mean, dev);
+    }
+    saved_timeout_ms = commit_timeout_ms();
+    LOG_INF("Adaptive click timeout: %dms", saved_timeout_ms);
+}
+
+static void cadence_learn(uint32_t gap_ms)
 {
-    if (current_state == STATE_WAIT_TIMEOUT) {
-        post_event(MSG_INPUT_TAP, click_count);
-        click_count = 0;
-        is_holding = false;
-        current_state = STATE_IDLE;
+    tap_cadence_sample(&cadence, gap_ms);
+
+    uint32_t timeout = commit_timeout_ms();
+
+    /* Spare the flash: only persist meaningful drift */
+    if (abs((int)timeout - (int)saved_timeout_ms) >= CADENCE_SAVE_STEP_MS) {
+        uint8_t mean, dev;
+
+        tap_cadence_pack(&cadence, &mean, &dev);
+        nvs_write_byte(NVS_ID_TAP_GAP_MEAN, mean);
+        nvs_write_byte(NVS_ID_TAP_GAP_DEV, dev);
+        saved_timeout_ms = timeout;
+        LOG_DBG("Click timeout learned: %dms", timeout);
+    }
+}
+#endif
+
+static void commit_tap(struct tap_detector *det)
+{
+    post_event(det, MSG_INPUT_TAP, det->click_count);
+    det->click_count = 0;
+    det->is_holding = false;
+    det->state = STATE_IDLE;
+}
+
+static void click_timeout(struct fsm_deadline *dl)
+{
+    struct tap_detector *det = CONTAINER_OF(dl, struct tap_detector, click_deadline);
+
+    if (det->state == STATE_WAIT_TIMEOUT) {
+        commit_tap(det);
+#ifdef CONFIG_ZBEAM_ADAPTIVE_TAP
+        det->timed_out = true;
+#endif
     }
 }
 
-static void hold_timer_handler(struct k_timer *timer_id)
+static void hold_timeout(struct fsm_deadline *dl)
 {
-    if (current_state == STATE_PRESSED) {
-        is_holding = true;
-        post_event(MSG_INPUT_HOLD_START, click_count);
+    struct tap_detector *det = CONTAINER_OF(dl, struct tap_detector, hold_deadline);
+
+    if (det->state == STATE_PRESSED) {
+        det->is_holding = true;
+        post_event(det, MSG_INPUT_HOLD_START, det->click_count);
     }
 }
 
-static void process_key_event(int value)
+void multi_tap_input_process_edge(const struct zbeam_msg *edge)
 {
+    int value = edge->count;
+
+    if (edge->source >= INPUT_SRC_KEY_COUNT) {
+        return;
+    }
+
+    struct tap_detector *det = &detectors[edge->source];
+
+    det->last_edge_cycles = latency_stamp_of(edge);
+
     // LOG_INF("Input raw: %d", value);
     if (value == 1) {  /* Key Down */
-        switch (current_state) {
+        switch (det->state) {
         case STATE_IDLE:
-            click_count = 1;
-            current_state = STATE_PRESSED;
-            k_timer_start(&hold_timer, K_MSEC(hold_duration_ms), K_NO_WAIT);
+#ifdef CONFIG_ZBEAM_ADAPTIVE_TAP
+            if (det->timed_out && k_uptime_get_32() - det->release_ms < click_timeout_ms) {
+                /* Likely cut short by the learned timeout: learn the slow gap */
+                cadence_learn(k_uptime_get_32() - det->release_ms);
+            }
+            det->timed_out = false;
+#endif
+            det->click_count = 1;
+            det->state = STATE_PRESSED;
+            fsm_deadline_start(&det->hold_deadline, hold_duration_ms, 0);
+            /* The preview belongs to the main button's sequences */
+            if (press_hook && edge->source == INPUT_SRC_MAIN) {
+                press_hook();
+            }
             // LOG_INF("State: IDLE -> PRESSED");
             break;
 
         case STATE_WAIT_TIMEOUT:
-            k_timer_stop(&click_timer);
-            click_count++;
-            current_state = STATE_PRESSED;
-            k_timer_start(&hold_timer, K_MSEC(hold_duration_ms), K_NO_WAIT);
-            // LOG_INF("State: WAIT -> PRESSED (count=%d)", click_count);
+            fsm_deadline_stop(&det->click_deadline);
+#ifdef CONFIG_ZBEAM_ADAPTIVE_TAP
+            cadence_learn(k_uptime_get_32() - det->release_ms);
+#endif
+            det->click_count++;
+            det->state = STATE_PRESSED;
+            fsm_deadline_start(&det->hold_deadline, hold_duration_ms, 0);
+            // LOG_INF("State: WAIT -> PRESSED (count=%d)", det->click_count);
             break;
 
         case STATE_PRESSED:
@@ -90,26 +265,162 @@ static void process_key_event(int value)
         }
     }
     else {  /* Key Up */
-        if (current_state == STATE_PRESSED) {
-            k_timer_stop(&hold_timer);
-
-            if (is_holding) {
-                post_event(MSG_INPUT_HOLD_RELEASE, click_count);
-                click_count = 0;
-                is_holding = false;
-                current_state = STATE_IDLE;
+        if (det->state == STATE_PRESSED) {
+            fsm_deadline_stop(&det->hold_deadline);
+
+            if (det->is_holding) {
+                post_event(det, MSG_INPUT_HOLD_RELEASE, det->click_count);
+                det->click_count = 0;
+                det->is_holding = false;
+                det->state = STATE_IDLE;
                 // LOG_INF("State: PRESSED -> IDLE (Hold Release)");
+            } else if (can_continue && !can_continue(edge->source, det->click_count)) {
+                /* Nothing longer is mapped: no need to wait for more taps */
+                commit_tap(det);
             } else {
-                current_state = STATE_WAIT_TIMEOUT;
-                k_timer_start(&click_timer, K_MSEC(click_timeout_ms), K_NO_WAIT);
+                det->state = STATE_WAIT_TIMEOUT;
+#ifdef CONFIG_ZBEAM_ADAPTIVE_TAP
+                det->release_ms = k_uptime_get_32();
+#endif
+                fsm_deadline_start(&det->click_deadline, commit_timeout_ms(), 0);
                 // LOG_INF("State: PRESSED -> WAIT");
             }
         } else {
-            LOG_WRN("Ignored release in state %d", current_state);
+            LOG_WRN("Ignored release in state %d", det->state);
         }
     }
 }
 
+bool multi_tap_input_take_encoder(struct zbeam_msg *msg)
+{
+    /* Re-open the doorbell before taking the sum: later detents post again */
+    atomic_clear(&encoder_pending);
+
+    int32_t delta = (int32_t)atomic_set(&encoder_delta, 0);
+
+    if (delta == 0) {
+        return false;
+    }
+    msg->count = (uint8_t)(int8_t)CLAMP(delta, INT8_MIN, INT8_MAX);
+    return true;
+}
+
+/* Build a debounced edge and run the fast path on it */
+static struct zbeam_msg accept_edge(uint8_t source, bool pressed, uint32_t cycles)
+{
+    struct zbeam_msg edge = {
+        .type = MSG_INPUT_EDGE,
+        .count = pressed ? 1 : 0,
+        .source = source,
+    };
+    multi_tap_edge_fn hook = edge_hook;
+
+    latency_stamp(&edge, cycles);
+    if (hook && source == INPUT_SRC_MAIN) {
+        /* Fast path first: the worker only hears about it afterwards */
+        if (hook(pressed)) {
+            latency_stats_mark_fast_path(cycles);
+        }
+    }
+    return edge;
+}
+
+/* Accept a level change unless it lands in the window of the last one */
+static bool debounce_accept(struct tap_detector *det, uint32_t now)
+{
+    if (det->raw_pressed == det->stable_pressed) {
+        return false;
+    }
+    if (now - det->accepted_cycles < k_ms_to_cyc_ceil32(CONFIG_ZBEAM_INPUT_DEBOUNCE_MS)) {
+        return false;
+    }
+    det->stable_pressed = det->raw_pressed;
+    det->accepted_cycles = now;
+    return true;
+}
+
+/* Window closed (on the worker): apply the level the chatter settled on */
+static void debounce_settle(struct fsm_deadline *dl)
+{
+    struct tap_detector *det = CONTAINER_OF(dl, struct tap_detector, debounce_deadline);
+    uint32_t now = k_cycle_get_32();
+    k_spinlock_key_t key = k_spin_lock(&debounce_lock);
+    bool accept = debounce_accept(det, now);
+    bool early = !accept && det->raw_pressed != det->stable_pressed;
+    bool pressed = det->stable_pressed;
+    uint32_t cycles = det->raw_cycles;
+    uint32_t waited = now - det->accepted_cycles;
+
+    k_spin_unlock(&debounce_lock, key);
+
+    if (accept) {
+        struct zbeam_msg edge = accept_edge(detector_source(det), pressed, cycles);
+
+        multi_tap_input_process_edge(&edge);
+    } else if (early) {
+        /*
+         * Armed in whole ms from the last bounce and run up to the
+         * scheduler slack early: wait out the rest of the window.
+         */
+        uint32_t left = k_ms_to_cyc_ceil32(CONFIG_ZBEAM_INPUT_DEBOUNCE_MS) - waited;
+
+        fsm_deadline_start(dl, MAX(k_cyc_to_ms_ceil32(left), 1), 0);
+    }
+}
+
+static void key_event(uint8_t source, bool value)
+{
+    struct tap_detector *det = &detectors[source];
+    uint32_t now = k_cycle_get_32();
+    k_spinlock_key_t key = k_spin_lock(&debounce_lock);
+
+    det->raw_pressed = value;
+    det->raw_cycles = now;
+    bool accept = debounce_accept(det, now);
+    bool chatter = !accept && det->raw_pressed != det->stable_pressed;
+    bool pressed = det->stable_pressed;
+
+    k_spin_unlock(&debounce_lock, key);
+
+    if (accept) {
+        struct zbeam_msg edge = accept_edge(source, pressed, now);
+
+        fsm_worker_post_edge(&edge);
+    } else if (chatter) {
+        /* Each bounce pushes the re-check out to a quiet window */
+        fsm_deadline_start(&det->debounce_deadline, CONFIG_ZBEAM_INPUT_DEBOUNCE_MS, 0);
+    }
+}
+
+static void encoder_event(int32_t detents)
+{
+    atomic_add(&encoder_delta, detents);
+
+    /* Only the first detent since the worker's last take posts */
+    if (!atomic_cas(&encoder_pending, 0, 1)) {
+        return;
+    }
+
+    struct zbeam_msg msg = {
+        .type = MSG_INPUT_ENCODER,
+        .source = INPUT_SRC_ENCODER,
+    };
+
+    latency_stamp(&msg, k_cycle_get_32());
+    if (fsm_worker_post_msg(&msg) != 0) {
+        /* Lane full: let the next detent try again */
+        atomic_clear(&encoder_pending);
+    }
+}
+
+/* Raw input as received, so a field capture can be replayed in tests */
+static inline void trace_input(uint8_t source, int32_t value)
+{
+#ifdef CONFIG_ZBEAM_FSM_TRACE_INPUT
+    fsm_trace_record(FSM_TRACE_INPUT, source, 0, (uint8_t)(int8_t)CLAMP(value, INT8_MIN, INT8_MAX));
+#endif
+}
+
 /* Zephyr Input Subsystem Callback */
 static void input_cb(struct input_event *evt, void *user_data)
 {
@@ -117,8 +428,17 @@ static void input_cb(struct input_event *evt, void *user_data)
     //    LOG_WRN("Evt: type=%d code=%d val=%d", evt->type, evt->code, evt->value);
     // }
 
-    if (evt->type == INPUT_EV_KEY && evt->code == INPUT_KEY_0) {
-        process_key_event(evt->value);
+    if (evt->type == INPUT_EV_KEY) {
+        for (uint8_t src = 0; src < INPUT_SRC_KEY_COUNT; src++) {
+            if (evt->code == source_codes[src]) {
+                trace_input(src, evt->value != 0);
+                key_event(src, evt->value != 0);
+                return;
+            }
+        }
+    } else if (evt->type == INPUT_EV_REL && evt->code == INPUT_REL_WHEEL && evt->value != 0) {
+        trace_input(INPUT_SRC_ENCODER, evt->value);
+        encoder_event(evt->value);
     }
 }
 
@@ -130,20 +450,49 @@ void multi_tap_configure(uint32_t click_ms, uint32_t hold_ms)
     hold_duration_ms = hold_ms;
 }
 
+void multi_tap_set_continue_query(multi_tap_continue_fn fn)
+{
+    can_continue = fn;
+}
+
+void multi_tap_set_press_hook(multi_tap_press_fn fn)
+{
+    press_hook = fn;
+}
+
+void multi_tap_set_edge_hook(multi_tap_edge_fn fn)
+{
+    edge_hook = fn;
+}
+
 void multi_tap_input_init(void)
 {
-    k_timer_init(&click_timer, click_timer_handler, NULL);
-    k_timer_init(&hold_timer, hold_timer_handler, NULL);
-    LOG_INF("Multi-Tap init: click=%dms hold=%dms", 
+    LOG_INF("Multi-Tap init: click=%dms hold=%dms",
             click_timeout_ms, hold_duration_ms);
+#ifdef CONFIG_ZBEAM_ADAPTIVE_TAP
+    cadence_load();
+#endif
 }
 
 void multi_tap_input_reset(void)
 {
-    k_timer_stop(&click_timer);
-    k_timer_stop(&hold_timer);
-    click_count = 0;
-    current_state = STATE_IDLE;
-    is_holding = false;
+    for (int i = 0; i < INPUT_SRC_KEY_COUNT; i++) {
+        struct tap_detector *det = &detectors[i];
+
+        fsm_deadline_stop(&det->debounce_deadline);
+        k_spinlock_key_t key = k_spin_lock(&debounce_lock);
+
+        det->raw_pressed = false;
+        det->stable_pressed = false;
+        k_spin_unlock(&debounce_lock, key);
+
+        fsm_deadline_stop(&det->click_deadline);
+        fsm_deadline_stop(&det->hold_deadline);
+        det->click_count = 0;
+        det->state = STATE_IDLE;
+        det->is_holding = false;
+    }
+    atomic_clear(&encoder_delta);
+    atomic_clear(&encoder_pending);
     LOG_INF("MultiTap Reset");
-}
\ No newline at end of file
+}
@@ -0,0 +1,63 @@
+/**
+ * @file tap_cadence.c
+ * @brief Click-timeout estimator learned from the user's tap cadence.
+ *
+ * mean += (gap - mean) / 8, dev += (|gap - mean| - dev) / 4, both in
+ * 12.4 fixed point. The first sample seeds mean = gap, dev = gap / 2.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/util.h>
+#include <stdlib.h>
+#include <string.h>
+#include "tap_cadence.h"
+
+#define Q4(ms) ((int32_t)(ms) << 4)
+
+void tap_cadence_init(struct tap_cadence *tc)
+{
+    memset(tc, 0, sizeof(*tc));
+}
+
+void tap_cadence_sample(struct tap_cadence *tc, uint32_t gap_ms)
+{
+    int32_t gap = Q4(MIN(gap_ms, TAP_CADENCE_MAX_GAP_MS));
+
+    if (tc->samples == 0) {
+        tc->mean_q4 = gap;
+        tc->dev_q4 = gap / 2;
+    } else {
+        int32_t err = gap - tc->mean_q4;
+
+        tc->mean_q4 += err / 8;
+        tc->dev_q4 += (abs(err) - (int32_t)tc->dev_q4) / 4;
+    }
+
+    if (tc->samples < UINT16_MAX) {
+        tc->samples++;
+    }
+}
+
+uint32_t tap_cadence_timeout(const struct tap_cadence *tc, uint32_t min_ms, uint32_t max_ms)
+{
+    if (tc->samples < TAP_CADENCE_MIN_SAMPLES) {
+        return MAX(max_ms, min_ms);
+    }
+
+    uint32_t t = ((tc->mean_q4 + 4 * (uint32_t)tc->dev_q4) >> 4) + TAP_CADENCE_MARGIN_MS;
+
+    return MAX(MIN(t, max_ms), min_ms);
+}
+
+void tap_cadence_pack(const struct tap_cadence *tc, uint8_t *mean, uint8_t *dev)
+{
+    *mean = MIN((tc->mean_q4 >> 4) / TAP_CADENCE_PACK_MS, UINT8_MAX);
+    *dev = MIN((tc->dev_q4 >> 4) / TAP_CADENCE_PACK_MS, UINT8_MAX);
+}
+
+void tap_cadence_restore(struct tap_cadence *tc, uint8_t mean, uint8_t dev)
+{
+    tc->mean_q4 = Q4(mean * TAP_CADENCE_PACK_MS);
+    tc->dev_q4 = Q4(dev * TAP_CADENCE_PACK_MS);
+    tc->samples = TAP_CADENCE_MIN_SAMPLES;
+}
@@ -190,9 +190,14 @@ void thermal_update(uint8_t current_brightness)
     }
 }
 
-uint8_t thermal_apply_throttle(uint8_t requested_brightness)
+brightness_t thermal_apply_throttle(brightness_t requested_brightness)
 {
-    return (requested_brightness * throttle_factor) / 255;
+    return ((uint32_t)requested_brightness * throttle_factor) / 255;
+}
+
+uint32_t thermal_apply_budget(uint32_t budget_ua)
+{
+    return ((uint64_t)budget_ua * throttle_factor) / 255;
 }
 
 int32_t thermal_get_temp_mc(void)
@@ -0,0 +1,180 @@
+#!/usr/bin/env python3
+"""
+Decode a binary FSM trace dump into a readable timeline.
+
+The firmware prints its trace ring (CONFIG_ZBEAM_FSM_TRACE) as:
+    FSMTRACE BEGIN <entries> <overwritten>
+    FSMTRACE <16 hex digits>      # one 8-byte little-endian entry
+    FSMTRACE END
+Any other console/log text around these lines is ignored, so a raw
+serial capture can be fed in directly.
+
+Node IDs are mapped back to names from the same UI descriptions the
+firmware was built from, using the generator's ID assignment.
+
+With --replay, the raw input entries (CONFIG_ZBEAM_FSM_TRACE_INPUT) are
+printed instead, as REPLAY_KEY/REPLAY_ENCODER initializers for the replay
+driver in tests/input_replay. Times are relative to the first input.
+Several dumps of one session may be concatenated; entries repeated
+across overlapping dumps are dropped.
+
+Usage:
+    python decode_fsm_trace.py capture.txt
+    python decode_fsm_trace.py --replay capture.txt > tests/input_replay/src/traces/field.inc
+    west espressif monitor | python decode_fsm_trace.py -
+    python decode_fsm_trace.py --ui src/ui_simple.yaml src/ui_advanced.yaml capture.txt
+"""
+
+import argparse
+import os
+import re
+import struct
+import sys
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+import generate_fsm_tables  # noqa: E402
+
+REPO_ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+DEFAULT_UI = [
+    os.path.join(REPO_ROOT, 'src', 'ui_simple.yaml'),
+    os.path.join(REPO_ROOT, 'src', 'ui_advanced.yaml'),
+]
+
+# Keep in sync with enum fsm_trace_event (include/fsm_trace.h)
+EVENTS = ['INIT', 'TAP', 'HOLD', 'RELEASE', 'TRANSITION', 'TIMEOUT', 'EMERGENCY_OFF', 'INPUT']
+INPUT_EVENT = EVENTS.index('INPUT')
+
+# Keep in sync with enum zbeam_input_source (include/zbeam_msg.h)
+SOURCES = ['MAIN', 'TAIL', 'SIDE', 'ENCODER']
+ENCODER = SOURCES.index('ENCODER')
+
+ENTRY = struct.Struct('<IBBBB')  # uptime_ms, event, from, to, count
+LINE_RE = re.compile(r'FSMTRACE\s+(BEGIN\s+(\d+)\s+(\d+)|END|([0-9a-fA-F]{16}))')
+
+
+def load_node_names(ui_paths):
+    """Node ID -> debug name, numbered exactly as generate_fsm_tables.py does."""
+    names = {0: '-'}
+    next_id = 1
+    for path in ui_paths:
+        tree = generate_fsm_tables.load_tree(path, generate_fsm_tables.MAX_ID)
+        for node in tree.nodes.values():
+            names[next_id] = node.name
+            next_id += 1
+    return names
+
+
+def parse_dumps(lines):
+    """Yield (overwritten, [entries]) for each BEGIN..END block."""
+    entries = None
+    overwritten = 0
+    for line in lines:
+        m = LINE_RE.search(line)
+        if not m:
+            continue
+        if m.group(1).startswith('BEGIN'):
+            entries = []
+            overwritten = int(m.group(3))
+        elif m.group(1) == 'END':
+            if entries is not None:
+                yield overwritten, entries
+            entries = None
+        elif entries is not None:
+            entries.append(ENTRY.unpack(bytes.fromhex(m.group(4))))
+
+
+def signed(byte):
+    return byte - 256 if byte > 127 else byte
+
+
+def replay_lines(dumps):
+    """Yield replay initializers for the input entries of all dumps."""
+    start = None
+    last_ms = None
+    seen = set()  # Entries at last_ms, to skip overlap between dumps
+    for _, entries in dumps:
+        for entry in entries:
+            ms, event, src, _, count = entry
+            if event != INPUT_EVENT or src >= len(SOURCES):
+                continue
+            if last_ms is not None and (ms < last_ms or (ms == last_ms and entry in seen)):
+                continue
+            if ms != last_ms:
+                seen.clear()
+            seen.add(entry)
+            last_ms = ms
+            if start is None:
+                start = ms
+            if src == ENCODER:
+                yield f'REPLAY_ENCODER({ms - start}, {signed(count)}),'
+            else:
+                yield f'REPLAY_KEY({ms - start}, INPUT_SRC_{SOURCES[src]}, {1 if count else 0}),'
+
+
+def describe(entry, names):
+    _, event, src, dst, count = entry
+    node = lambda i: names.get(i, f'#{i}')
+    name = EVENTS[event] if event < len(EVENTS) else f'EVENT_{event}'
+
+    if name in ('TAP', 'HOLD'):
+        return f'{name} x{count} on [{node(src)}]'
+    if name in ('RELEASE', 'TIMEOUT'):
+        return f'{name} on [{node(src)}]'
+    if name == 'INIT':
+        return f'INIT start [{node(dst)}]'
+    if name == 'INPUT':
+        source = SOURCES[src] if src < len(SOURCES) else f'#{src}'
+        if src == ENCODER:
+            return f'INPUT {source} {signed(count):+d}'
+        return f'INPUT {source} {"down" if count else "up"}'
+    return f'{name} [{node(src)}] -> [{node(dst)}]'
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Decode an FSM trace dump')
+    parser.add_argument('--ui', nargs='+', default=DEFAULT_UI,
+                        help='UI description YAML files, in build order')
+    parser.add_argument('--replay', action='store_true',
+                        help='Print the raw inputs as a tests/input_replay trace')
+    parser.add_argument('capture', help="Console capture file ('-' for stdin)")
+    args = parser.parse_args()
+
+    if args.replay:
+        stream = sys.stdin if args.capture == '-' else open(args.capture, errors='replace')
+        with stream:
+            lines = list(replay_lines(parse_dumps(stream)))
+        if not lines:
+            print('error: no input entries (CONFIG_ZBEAM_FSM_TRACE_INPUT) found', file=sys.stderr)
+            return 1
+        print(f'/* {len(lines)} inputs, decoded by scripts/decode_fsm_trace.py --replay */')
+        print('\n'.join(lines))
+        return 0
+
+    try:
+        names = load_node_names(args.ui)
+    except (generate_fsm_tables.GraphError, OSError) as e:
+        print(f'error: {e}', file=sys.stderr)
+        return 1
+
+    stream = sys.stdin if args.capture == '-' else open(args.capture, errors='replace')
+    found = False
+    with stream:
+        for overwritten, entries in parse_dumps(stream):
+            found = True
+            print(f'--- {len(entries)} entries'
+                  + (f', {overwritten} older entries lost' if overwritten else '') + ' ---')
+            prev_ms = None
+            for entry in entries:
+                ms = entry[0]
+                delta = f'+{ms - prev_ms:>6} ms' if prev_ms is not None else ' ' * 10
+                print(f'{ms / 1000:10.3f} s  {delta}  {describe(entry, names)}')
+                prev_ms = ms
+
+    if not found:
+        print('error: no FSMTRACE BEGIN/END block found', file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,521 @@
+#!/usr/bin/env python3
+"""
+Generate const FSM dispatch tables from declarative UI descriptions.
+
+Each YAML file describes one UI tree (e.g. src/ui_simple.yaml). All trees
+share one node ID space and one callback ID space, emitted as:
+  - a header with enum fsm_node_id / enum fsm_callback_id, node externs
+    and callback prototypes
+  - a source with the packed slot pool, the const nodes and ui_fsm_table
+
+The graph is validated at build time: unknown keys, dangling targets,
+tap counts above --max-slots and nodes unreachable from the tree's entry
+node are all errors.
+
+Usage:
+    python generate_fsm_tables.py --max-slots 10 \\
+        --header build/generated/fsm_tables.h \\
+        --source build/generated/fsm_tables.c \\
+        src/ui_simple.yaml src/ui_advanced.yaml
+
+YAML format (see src/ui_simple.yaml):
+    prefix: SMP          # Node ID prefix   -> NODE_SMP_OFF
+    symbol: simple       # C symbol prefix  -> simple_off
+    entry: off           # Root for the reachability check
+    nodes:
+      off:
+        action: action_off
+        clicks:
+          1: on                                       # 1C -> on
+        holds:
+          1: {goto: ramp, call: cb_simple_hold_from_off}
+          10: {call: cb_toggle_ui_mode}
+      battcheck:
+        name: SMP_BATT     # Debug name (default: <prefix>_<KEY>)
+        timeout_ms: 4000
+        timeout_goto: off  # Default: home node (or previous with timeout_reverts)
+        release: cb_x      # Callback on HOLD_RELEASE
+        any_click: cb_y    # Callback when no slot matches
+        any_hold: cb_z
+        timeout_reverts: true
+        momentary: true    # Output follows the button via the momentary fast path
+        external: true     # Entered from C code only (skips reachability)
+        encoder: cb_w      # Callback for encoder detents (count = delta)
+        inputs:            # Maps for the other input sources
+          tail:
+            clicks:
+              1: off
+"""
+
+import argparse
+import io
+import os
+import re
+import sys
+
+import yaml
+
+NODE_KEYS = {
+    'name', 'action', 'clicks', 'holds', 'timeout_ms', 'timeout_goto',
+    'timeout_reverts', 'release', 'any_click', 'any_hold', 'momentary',
+    'external', 'encoder', 'inputs',
+}
+SLOT_KEYS = {'goto', 'call'}
+INPUT_KEYS = {'clicks', 'holds'}
+# Non-main key sources (enum zbeam_input_source)
+SOURCES = {'tail': 'INPUT_SRC_TAIL', 'side': 'INPUT_SRC_SIDE'}
+MAX_ID = 255  # IDs are uint8_t, 0 is FSM_NONE
+
+
+class UiLoader(yaml.SafeLoader):
+    """SafeLoader that keeps on/off/yes/no as strings (node names)."""
+
+
+UiLoader.yaml_implicit_resolvers = {
+    k: [(tag, regexp) for tag, regexp in v if tag != 'tag:yaml.org,2002:bool']
+    for k, v in yaml.SafeLoader.yaml_implicit_resolvers.items()
+}
+UiLoader.add_implicit_resolver(
+    'tag:yaml.org,2002:bool',
+    re.compile(r'^(?:true|True|TRUE|false|False|FALSE)$'),
+    list('tTfF'))
+
+
+class GraphError(Exception):
+    pass
+
+
+class Slot:
+    def __init__(self, target=None, callback=None):
+        self.target = target      # Node key in the same tree
+        self.callback = callback  # C function name
+
+
+class Node:
+    def __init__(self, tree, key):
+        self.tree = tree
+        self.key = key
+        self.name = f"{tree.prefix}_{key.upper()}"
+        self.action = None
+        self.clicks = []  # Dense list, index 0 = 1 tap, None = empty
+        self.holds = []
+        self.timeout_ms = 0
+        self.timeout_goto = None
+        self.timeout_reverts = False
+        self.release = None
+        self.any_click = None
+        self.any_hold = None
+        self.momentary = False
+        self.external = False
+        self.encoder = None
+        self.inputs = {}  # Source name -> InputMap, in file order
+
+    @property
+    def enum(self):
+        return f"NODE_{self.tree.prefix}_{self.key.upper()}"
+
+    @property
+    def symbol(self):
+        return f"{self.tree.symbol}_{self.key}"
+
+
+class InputMap:
+    def __init__(self, source):
+        self.source = source
+        self.clicks = []
+        self.holds = []
+
+
+class Tree:
+    def __init__(self, path):
+        self.path = path
+        self.prefix = None
+        self.symbol = None
+        self.entry = None
+        self.nodes = {}  # key -> Node, in file order
+
+    def err(self, msg):
+        raise GraphError(f"{self.path}: {msg}")
+
+
+def parse_slot(tree, where, value):
+    if isinstance(value, str):
+        return Slot(target=value)
+    if not isinstance(value, dict):
+        tree.err(f"{where}: slot must be a node name or {{goto, call}}")
+    unknown = set(value) - SLOT_KEYS
+    if unknown:
+        tree.err(f"{where}: unknown slot key(s) {sorted(unknown)}")
+    if not value:
+        tree.err(f"{where}: empty slot")
+    return Slot(target=value.get('goto'), callback=value.get('call'))
+
+
+def parse_slots(tree, node, kind, table, max_slots):
+    if table is None:
+        return []
+    if not isinstance(table, dict):
+        tree.err(f"node '{node.key}' {kind}: expected a map of tap count -> slot")
+    slots = []
+    for count, value in table.items():
+        where = f"node '{node.key}' {kind} {count}"
+        if not isinstance(count, int) or count < 1:
+            tree.err(f"{where}: tap count must be an integer >= 1")
+        if count > max_slots:
+            tree.err(f"{where}: exceeds CONFIG_ZBEAM_MAX_NAV_SLOTS ({max_slots})")
+        while len(slots) < count:
+            slots.append(None)
+        slots[count - 1] = parse_slot(tree, where, value)
+    return slots
+
+
+def parse_inputs(tree, node, table, max_slots):
+    if table is None:
+        return {}
+    if not isinstance(table, dict):
+        tree.err(f"node '{node.key}' inputs: expected a map of source -> clicks/holds")
+    inputs = {}
+    for source, body in table.items():
+        source = str(source)
+        if source not in SOURCES:
+            tree.err(f"node '{node.key}' inputs: unknown source '{source}' "
+                     f"(expected one of {sorted(SOURCES)})")
+        body = body or {}
+        unknown = set(body) - INPUT_KEYS
+        if unknown:
+            tree.err(f"node '{node.key}' inputs {source}: unknown key(s) {sorted(unknown)}")
+        imap = InputMap(source)
+        imap.clicks = parse_slots(tree, node, f"{source} clicks", body.get('clicks'), max_slots)
+        imap.holds = parse_slots(tree, node, f"{source} holds", body.get('holds'), max_slots)
+        inputs[source] = imap
+    return inputs
+
+
+def load_tree(path, max_slots):
+    tree = Tree(path)
+    with open(path) as f:
+        doc = yaml.load(f, Loader=UiLoader)
+    if not isinstance(doc, dict):
+        tree.err("top level must be a map")
+
+    for key in ('prefix', 'symbol', 'entry', 'nodes'):
+        if key not in doc:
+            tree.err(f"missing '{key}'")
+    tree.prefix = str(doc['prefix'])
+    tree.symbol = str(doc['symbol'])
+    tree.entry = str(doc['entry'])
+
+    for key, body in doc['nodes'].items():
+        key = str(key)
+        body = body or {}
+        unknown = set(body) - NODE_KEYS
+        if unknown:
+            tree.err(f"node '{key}': unknown key(s) {sorted(unknown)}")
+        node = Node(tree, key)
+        node.name = str(body.get('name', node.name))
+        node.action = body.get('action')
+        node.clicks = parse_slots(tree, node, 'clicks', body.get('clicks'), max_slots)
+        node.holds = parse_slots(tree, node, 'holds', body.get('holds'), max_slots)
+        node.timeout_ms = int(body.get('timeout_ms', 0))
+        node.timeout_goto = body.get('timeout_goto')
+        node.timeout_reverts = bool(body.get('timeout_reverts', False))
+        node.release = body.get('release')
+        node.any_click = body.get('any_click')
+        node.any_hold = body.get('any_hold')
+        node.momentary = bool(body.get('momentary', False))
+        node.external = bool(body.get('external', False))
+        node.encoder = body.get('encoder')
+        node.inputs = parse_inputs(tree, node, body.get('inputs'), max_slots)
+        if not 0 <= node.timeout_ms <= 0xFFFF:
+            tree.err(f"node '{key}': timeout_ms out of range")
+        tree.nodes[key] = node
+
+    return tree
+
+
+def node_slots(node):
+    slots = node.clicks + node.holds
+    for imap in node.inputs.values():
+        slots += imap.clicks + imap.holds
+    return slots
+
+
+def node_edges(node):
+    for slot in node_slots(node):
+        if slot and slot.target:
+            yield slot.target
+    if node.timeout_goto:
+        yield node.timeout_goto
+
+
+def validate_tree(tree):
+    if tree.entry not in tree.nodes:
+        tree.err(f"entry node '{tree.entry}' is not defined")
+
+    for node in tree.nodes.values():
+        for target in node_edges(node):
+            if target not in tree.nodes:
+                tree.err(f"node '{node.key}': dangling target '{target}'")
+
+    reached = set()
+    pending = [tree.entry] + [n.key for n in tree.nodes.values() if n.external]
+    while pending:
+        key = pending.pop()
+        if key in reached:
+            continue
+        reached.add(key)
+        pending.extend(node_edges(tree.nodes[key]))
+
+    unreachable = [k for k in tree.nodes if k not in reached]
+    if unreachable:
+        tree.err(f"unreachable node(s) from '{tree.entry}': {', '.join(unreachable)} "
+                 "(mark with 'external: true' if entered from C code)")
+
+
+def callback_enum(func):
+    name = func[3:] if func.startswith('cb_') else func
+    return f"CB_{name.upper()}"
+
+
+def collect_callbacks(trees):
+    callbacks = []
+    for tree in trees:
+        for node in tree.nodes.values():
+            refs = [node.release, node.any_click, node.any_hold, node.encoder]
+            refs += [s.callback for s in node_slots(node) if s]
+            for cb in refs:
+                if cb and cb not in callbacks:
+                    callbacks.append(cb)
+    return callbacks
+
+
+def write_header(f, trees, callbacks, sources):
+    f.write(f"""/*
+ * Auto-generated FSM node and callback IDs. Do not edit.
+ * Generated by: scripts/generate_fsm_tables.py
+ * Sources: {', '.join(sources)}
+ */
+
+#ifndef FSM_TABLES_H
+#define FSM_TABLES_H
+
+#include "fsm_engine.h"
+
+/**
+ * @brief FSM Node IDs (index into ui_fsm_table.nodes).
+ *
+ * ID 0 is reserved (FSM_NONE) so empty slots read as "not mapped".
+ */
+enum fsm_node_id {{
+    NODE_NONE = FSM_NONE,
+""")
+    for tree, src in zip(trees, sources):
+        f.write(f"\n    /* {src} */\n")
+        for node in tree.nodes.values():
+            f.write(f"    {node.enum},\n")
+    f.write("""
+    NODE_COUNT
+};
+
+/**
+ * @brief FSM Callback IDs (index into ui_fsm_table.callbacks).
+ */
+enum fsm_callback_id {
+    CB_NONE = FSM_NONE,
+""")
+    for cb in callbacks:
+        f.write(f"    {callback_enum(cb)},\n")
+    f.write("""
+    CB_COUNT
+};
+
+/**
+ * @brief Node/callback lookup tables for all UI trees (flash-resident).
+ */
+extern const struct fsm_table ui_fsm_table;
+
+/* Nodes */
+""")
+    for tree in trees:
+        for node in tree.nodes.values():
+            f.write(f"extern const struct fsm_node {node.symbol};\n")
+    f.write("\n/* Callbacks referenced by the UI descriptions */\n")
+    for cb in callbacks:
+        f.write(f"const struct fsm_node *{cb}(const struct fsm_node *self, int count);\n")
+    f.write("\n#endif /* FSM_TABLES_H */\n")
+
+
+def slot_init(tree, slot):
+    if slot is None:
+        return "{ 0 }"
+    target = tree.nodes[slot.target].enum if slot.target else None
+    callback = callback_enum(slot.callback) if slot.callback else None
+    if target and callback:
+        return f"FSM_SLOT({target}, {callback})"
+    if target:
+        return f"FSM_GOTO({target})"
+    return f"FSM_CALL({callback})"
+
+
+def write_source(f, trees, callbacks, sources, header):
+    f.write(f"""/*
+ * Auto-generated FSM dispatch tables. Do not edit.
+ * Generated by: scripts/generate_fsm_tables.py
+ * Sources: {', '.join(sources)}
+ */
+
+#include "ui_actions.h"
+#include "{header}"
+
+""")
+    # One packed slot pool shared by every node
+    pool = []
+    offsets = {}
+    for tree in trees:
+        for node in tree.nodes.values():
+            for kind in ('clicks', 'holds'):
+                slots = getattr(node, kind)
+                offsets[(node.enum, kind)] = len(pool)
+                for i, slot in enumerate(slots):
+                    pool.append((f"{node.name} {i + 1}{kind[0].upper()}", slot_init(tree, slot)))
+            for imap in node.inputs.values():
+                for kind in ('clicks', 'holds'):
+                    slots = getattr(imap, kind)
+                    offsets[(node.enum, imap.source, kind)] = len(pool)
+                    for i, slot in enumerate(slots):
+                        pool.append((f"{node.name} {imap.source} {i + 1}{kind[0].upper()}",
+                                     slot_init(tree, slot)))
+
+    f.write(f"static const struct fsm_slot ui_fsm_slots[{max(len(pool), 1)}] = {{\n")
+    for i, (comment, init) in enumerate(pool):
+        f.write(f"    [{i}] = {init}, // {comment}\n")
+    f.write("};\n")
+
+    # Per-source maps, also pooled; each node points at its run
+    maps = []
+    for tree in trees:
+        for node in tree.nodes.values():
+            offsets[(node.enum, 'inputs')] = len(maps)
+            for imap in node.inputs.values():
+                fields = [f".source = {SOURCES[imap.source]}"]
+                for kind, count_field in (('clicks', 'click_count'), ('holds', 'hold_count')):
+                    slots = getattr(imap, kind)
+                    if slots:
+                        fields.append(f".{kind} = &ui_fsm_slots[{offsets[(node.enum, imap.source, kind)]}], "
+                                      f".{count_field} = {len(slots)}")
+                maps.append((f"{node.name} {imap.source}", ", ".join(fields)))
+    if maps:
+        f.write(f"\nstatic const struct fsm_input_map ui_fsm_inputs[{len(maps)}] = {{\n")
+        for i, (comment, init) in enumerate(maps):
+            f.write(f"    [{i}] = {{ {init} }}, // {comment}\n")
+        f.write("};\n")
+
+    for tree in trees:
+        for node in tree.nodes.values():
+            f.write(f"\nconst struct fsm_node {node.symbol} = {{\n")
+            f.write(f"    .id = {node.enum}, .name = \"{node.name}\",\n")
+            if node.action:
+                f.write(f"    .action_routine = {node.action},\n")
+            for kind, count_field in (('clicks', 'click_count'), ('holds', 'hold_count')):
+                slots = getattr(node, kind)
+                if slots:
+                    f.write(f"    .{kind} = &ui_fsm_slots[{offsets[(node.enum, kind)]}], "
+                            f".{count_field} = {len(slots)},\n")
+            if node.inputs:
+                f.write(f"    .inputs = &ui_fsm_inputs[{offsets[(node.enum, 'inputs')]}], "
+                        f".input_count = {len(node.inputs)},\n")
+            for field, cb in (('release_callback', node.release),
+                              ('any_click_callback', node.any_click),
+                              ('any_hold_callback', node.any_hold),
+                              ('encoder_callback', node.encoder)):
+                if cb:
+                    f.write(f"    .{field} = {callback_enum(cb)},\n")
+            if node.timeout_ms:
+                f.write(f"    .timeout_ms = {node.timeout_ms},\n")
+            if node.timeout_goto:
+                f.write(f"    .timeout_node = {tree.nodes[node.timeout_goto].enum},\n")
+            flags = [flag for flag, on in (('FSM_NODE_TIMEOUT_REVERTS', node.timeout_reverts),
+                                           ('FSM_NODE_MOMENTARY', node.momentary)) if on]
+            if flags:
+                f.write(f"    .flags = {' | '.join(flags)},\n")
+            f.write("};\n")
+
+    f.write("\nstatic const struct fsm_node *const ui_fsm_nodes[NODE_COUNT] = {\n")
+    for tree in trees:
+        for node in tree.nodes.values():
+            f.write(f"    [{node.enum}] = &{node.symbol},\n")
+    f.write("};\n\nstatic const fsm_callback_t ui_fsm_callbacks[CB_COUNT] = {\n")
+    for cb in callbacks:
+        f.write(f"    [{callback_enum(cb)}] = {cb},\n")
+    f.write("""};
+
+const struct fsm_table ui_fsm_table = {
+    .nodes = ui_fsm_nodes,
+    .callbacks = ui_fsm_callbacks,
+    .node_count = NODE_COUNT,
+    .callback_count = CB_COUNT,
+};
+""")
+
+
+def write_if_changed(path, render):
+    """Only touch the output when content changes to avoid needless rebuilds."""
+    buf = io.StringIO()
+    render(buf)
+    text = buf.getvalue()
+    if os.path.exists(path):
+        with open(path) as f:
+            if f.read() == text:
+                return
+    os.makedirs(os.path.dirname(os.path.abspath(path)), exist_ok=True)
+    with open(path, 'w') as f:
+        f.write(text)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Generate const FSM dispatch tables')
+    parser.add_argument('--max-slots', type=int, default=10,
+                        help='CONFIG_ZBEAM_MAX_NAV_SLOTS (default: 10)')
+    parser.add_argument('--header', required=True, help='Output header path')
+    parser.add_argument('--source', required=True, help='Output source path')
+    parser.add_argument('--check', action='store_true',
+                        help='Validate only, do not write outputs')
+    parser.add_argument('ui', nargs='+', help='UI description YAML files')
+    args = parser.parse_args()
+
+    try:
+        trees = [load_tree(path, args.max_slots) for path in args.ui]
+        for tree in trees:
+            validate_tree(tree)
+
+        symbols = {}
+        for tree in trees:
+            for node in tree.nodes.values():
+                if node.enum in symbols:
+                    tree.err(f"node ID {node.enum} also defined in {symbols[node.enum]}")
+                symbols[node.enum] = tree.path
+
+        callbacks = collect_callbacks(trees)
+        if len(symbols) > MAX_ID or len(callbacks) > MAX_ID:
+            raise GraphError(f"too many nodes ({len(symbols)}) or callbacks "
+                             f"({len(callbacks)}) for uint8_t IDs")
+    except (GraphError, OSError, yaml.YAMLError) as e:
+        print(f"error: {e}", file=sys.stderr)
+        return 1
+
+    sources = [os.path.basename(p) for p in args.ui]
+    print(f"/* FSM tables: {len(symbols)} nodes, {len(callbacks)} callbacks */",
+          file=sys.stderr)
+    if args.check:
+        return 0
+
+    write_if_changed(args.header,
+                     lambda f: write_header(f, trees, callbacks, sources))
+    write_if_changed(args.source,
+                     lambda f: write_source(f, trees, callbacks, sources,
+                                            os.path.basename(args.header)))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
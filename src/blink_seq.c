@@ -0,0 +1,71 @@
+/**
+ * @file blink_seq.c
+ * @brief Non-blocking blink-code sequencer.
+ *
+ * Blink codes and feedback flashes are two small patterns played by the
+ * LED pattern engine: the blink counts, level and durations are passed as
+ * pattern arguments. Aborting only stops playback if one of these
+ * patterns owns the output, so strobes and beacons are left alone.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include "blink_seq.h"
+#include "led_pattern.h"
+
+LOG_MODULE_REGISTER(blink_seq, LOG_LEVEL_INF);
+
+enum { ARG_MAJOR, ARG_MINOR, ARG_LEVEL };
+enum { ARG_FLASH_LEVEL, ARG_FLASH_MS };
+
+static LED_PATTERN_DEFINE(pat_blink_code,
+    PAT_REPEAT_ARG(ARG_MAJOR),
+        PAT_LEVEL_ARG(ARG_LEVEL), PAT_HOLD(BLINK_ON_MS),
+        PAT_LEVEL(0), PAT_HOLD(BLINK_OFF_MS),
+    PAT_NEXT(),
+    PAT_HOLD(BLINK_GAP_MS),
+    PAT_REPEAT_ARG(ARG_MINOR),
+        PAT_LEVEL_ARG(ARG_LEVEL), PAT_HOLD(BLINK_ON_MS),
+        PAT_LEVEL(0), PAT_HOLD(BLINK_OFF_MS),
+    PAT_NEXT(),
+    PAT_END());
+
+static LED_PATTERN_DEFINE(pat_flash,
+    PAT_LEVEL_ARG(ARG_FLASH_LEVEL), PAT_HOLD_ARG(ARG_FLASH_MS),
+    PAT_END());
+
+int blink_seq_play_code(uint8_t major, uint8_t minor, uint8_t level, blink_done_t done)
+{
+    const uint16_t args[] = {
+        [ARG_MAJOR] = major,
+        [ARG_MINOR] = minor,
+        [ARG_LEVEL] = level,
+    };
+
+    LOG_DBG("Blink code %d.%d", major, minor);
+    return led_pattern_play(&pat_blink_code, args, ARRAY_SIZE(args), done);
+}
+
+int blink_seq_flash(uint8_t level, uint32_t duration_ms, blink_done_t done)
+{
+    const uint16_t args[] = {
+        [ARG_FLASH_LEVEL] = level,
+        [ARG_FLASH_MS] = MIN(duration_ms, UINT16_MAX),
+    };
+
+    return led_pattern_play(&pat_flash, args, ARRAY_SIZE(args), done);
+}
+
+void blink_seq_abort(void)
+{
+    if (blink_seq_is_active()) {
+        led_pattern_stop();
+    }
+}
+
+bool blink_seq_is_active(void)
+{
+    const struct led_pattern *pat = led_pattern_current();
+
+    return pat == &pat_blink_code || pat == &pat_flash;
+}
@@ -1,27 +1,130 @@
 #include <zephyr/kernel.h>
 #include <zephyr/drivers/pwm.h>
 #include <zephyr/logging/log.h>
+#include <string.h>
 #include "channel_manager.h"
 #include "thermal_manager.h"
+#include "latency_stats.h"
+
+#ifdef CONFIG_SHELL
+#include <zephyr/shell/shell.h>
+#endif
 
 LOG_MODULE_REGISTER(channel_mgr, LOG_LEVEL_INF);
 
-#define USER_NODE DT_PATH(zephyr_user)
-#define NUM_EMITTERS DT_PROP_LEN(USER_NODE, pwms)
-#define PWM_SPEC_GET(node_id, prop, idx) PWM_DT_SPEC_GET_BY_IDX(node_id, idx)
+/*
+ * Emitters come from the zanduril,emitter-group node, one child each, in
+ * child order. Everything about them (count, role, ramp table) is known
+ * at build time, so the mixer below is expanded per emitter and per mode
+ * rather than looping over runtime weights.
+ */
+#define GROUP_NODE DT_COMPAT_GET_ANY_STATUS_OKAY(zanduril_emitter_group)
+#define NUM_EMITTERS DT_CHILD_NUM(GROUP_NODE)
+
+BUILD_ASSERT(DT_NODE_EXISTS(GROUP_NODE), "Main beam needs a zanduril,emitter-group node");
+BUILD_ASSERT(NUM_EMITTERS >= 1 && NUM_EMITTERS <= 32, "Emitter group needs 1 to 32 emitters");
+
+/* Child-binding "role" enum, in binding order */
+enum emitter_role {
+    ROLE_MAIN,
+    ROLE_COLD,
+    ROLE_WARM,
+    ROLE_SECONDARY,
+};
+
+#define EMITTER_IDX(node) DT_NODE_CHILD_IDX(node)
+#define EMITTER_ROLE(node) DT_ENUM_IDX(node, role)
+/* Duty through the emitter's gamma table, looked up in compute_pulses() */
+#define EMITTER_DUTY(node) _CONCAT(duty_, DT_STRING_TOKEN(node, ramp_table))
+
+/* Emitters with a role, as a constant expression: (0 + 1 + 0 ...) */
+#define ROLE_IS(node, _role) + (EMITTER_ROLE(node) == (_role))
+#define ROLE_COUNT(_role) (0 DT_FOREACH_CHILD_VARGS(GROUP_NODE, ROLE_IS, _role))
 
 static const struct pwm_dt_spec emitters[NUM_EMITTERS] = {
-    DT_FOREACH_PROP_ELEM_SEP(USER_NODE, pwms, PWM_SPEC_GET, (,))
+    DT_FOREACH_CHILD_SEP(GROUP_NODE, PWM_DT_SPEC_GET, (,))
 };
 
+#define EMITTER_DESC(node) {                            \
+    .name = DT_PROP(node, emitter_name),                \
+    .role = EMITTER_ROLE(node),                         \
+    .max_current_ma = DT_PROP(node, max_current_ma),    \
+}
+
+static const struct {
+    const char *name;
+    uint8_t role;
+    uint16_t max_current_ma;
+} emitter_desc[NUM_EMITTERS] = {
+    DT_FOREACH_CHILD_SEP(GROUP_NODE, EMITTER_DESC, (,))
+};
+
+/*
+ * Constant-power mixing needs the full-duty current of every emitter:
+ * the mix then splits a current budget instead of stacking duties, and
+ * thermal and supply limits cap that budget.
+ */
+#define CURRENT_KNOWN(node) && (DT_PROP(node, max_current_ma) > 0)
+#define CHANNEL_BUDGET (1 DT_FOREACH_CHILD(GROUP_NODE, CURRENT_KNOWN))
+
+#if CHANNEL_BUDGET
+BUILD_ASSERT(CONFIG_ZBEAM_CHANNEL_DERATE_MV > CONFIG_ZBEAM_VOLTAGE_MIN_MV,
+             "Supply derating must start above the cutoff voltage");
+
+/* Supply factor at and below the cutoff (1/8): still a usable low */
+#define SUPPLY_FLOOR 32U
+/* Largest supply factor step up per sample */
+#define SUPPLY_RISE 8U
+
+/* Current at full brightness, uA: the group limit or the largest emitter */
+static uint32_t full_scale_ua;
+/* Supply derating of the budget, 0-255 */
+static uint8_t supply_factor = 255;
+#endif
+
 static channel_mode_t current_mode = CHANNEL_MODE_SINGLE;
 
+/*
+ * Pulse cache: the per-emitter pulses for one (mode, level, budget),
+ * so ramp ticks, strobe edges and thermal refreshes at an unchanged
+ * level skip the mix. It is also the staging area: channel_commit()
+ * applies it. Shared by the FSM worker and the lockout momentary path
+ * (input thread), hence the spinlock.
+ *
+ * written[] holds what each emitter was last set to (valid for bits set
+ * in written_mask) so unchanged pulses skip the driver call. PWM drivers
+ * may sleep, so commits call them outside the spinlock, serialized by
+ * commit_lock, which also guards written[].
+ */
+static struct {
+    bool valid;
+    channel_mode_t mode;
+    brightness_t level;
+    uint32_t budget_ua;
+    uint32_t pulse[NUM_EMITTERS];
+} cache;
+
+static uint32_t written[NUM_EMITTERS];
+static uint32_t written_mask;
+static struct channel_stats stats;
+static struct k_spinlock lock;
+static K_MUTEX_DEFINE(commit_lock);
+
+#ifdef CONFIG_ZBEAM_CHANNEL_PHASE_STAGGER
+/*
+ * Emitters driven end-aligned: the PWM API has no phase offset, but an
+ * inverted output with the complemented pulse puts the on-time at the
+ * end of the period, opposite the start-aligned emitters.
+ */
+static uint32_t stagger_mask;
+#endif
+
 void channel_init(void)
 {
     LOG_INF("Initializing %d emitters", NUM_EMITTERS);
     for (int i = 0; i < NUM_EMITTERS; i++) {
         if (!device_is_ready(emitters[i].dev)) {
-            LOG_ERR("Emitter %d PWM device not ready", i);
+            LOG_ERR("Emitter %s PWM device not ready", emitter_desc[i].name);
         }
     }
     
@@ -30,87 +133,432 @@ void channel_init(void)
     } else {
         current_mode = CHANNEL_MODE_SINGLE;
     }
+
+#if CHANNEL_BUDGET
+    full_scale_ua = DT_PROP(GROUP_NODE, max_current_ma) * 1000U;
+    if (DT_PROP(GROUP_NODE, max_current_ma) == 0) {
+        for (int i = 0; i < NUM_EMITTERS; i++) {
+            full_scale_ua = MAX(full_scale_ua, emitter_desc[i].max_current_ma * 1000U);
+        }
+    }
+    supply_factor = 255;
+#endif
+
+    k_mutex_lock(&commit_lock, K_FOREVER);
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    cache.valid = false;
+    written_mask = 0;
+#ifdef CONFIG_ZBEAM_CHANNEL_PHASE_STAGGER
+    stagger_mask = 0;
+    for (int i = 1; i < NUM_EMITTERS; i += 2) {
+        stagger_mask |= BIT(i);
+    }
+#endif
+    k_spin_unlock(&lock, key);
+    k_mutex_unlock(&commit_lock);
 }
 
-void channel_apply_mix(uint8_t master_level)
+/*
+ * Weight (0-255) of emitter @p idx in @p mode. The mode, index and role
+ * are constants at every call site, so this folds to one expression (or
+ * a constant) per emitter. Without cold/warm roles the first emitter is
+ * cold and the last warm.
+ */
+static ALWAYS_INLINE uint32_t emitter_weight(channel_mode_t mode, int idx, int role,
+                                             brightness_t level)
 {
-    // Apply thermal throttling first
-    uint8_t throttled = thermal_apply_throttle(master_level);
-    
-    // Calculate weights based on mode
-    uint16_t weights[NUM_EMITTERS];
-    for (int i = 0; i < NUM_EMITTERS; i++) weights[i] = 0;
-
-    switch (current_mode) {
-        case CHANNEL_MODE_SINGLE:
-            if (NUM_EMITTERS > 0) weights[0] = 255;
-            break;
+    bool cold = ROLE_COUNT(ROLE_COLD) ? role == ROLE_COLD : idx == 0;
+    bool warm = ROLE_COUNT(ROLE_WARM) ? role == ROLE_WARM : idx == NUM_EMITTERS - 1;
 
+    switch (mode) {
         case CHANNEL_MODE_50_50:
-            for (int i = 0; i < NUM_EMITTERS; i++) weights[i] = 255; 
-            // Note: In 50/50, we usually want full power if heat allows, 
-            // but for "equal" power we might cap sum at 255.
-            // Anduril typically allows 100% on both for max output.
-            break;
+            // Equal shares: without emitter currents both run fully, as
+            // Anduril does for max output; with them the budget split
+            // holds the pair to one emitter's current
+            return 255;
 
         case CHANNEL_MODE_COLD:
-            if (NUM_EMITTERS > 0) weights[0] = 255;
-            break;
+            return cold ? 255 : 0;
 
         case CHANNEL_MODE_WARM:
-            if (NUM_EMITTERS > 1) weights[1] = 255;
-            else if (NUM_EMITTERS > 0) weights[0] = 255;
-            break;
+            return warm ? 255 : 0;
 
         case CHANNEL_MODE_AUTO_TINT:
-            if (NUM_EMITTERS >= 2) {
-                // Shift from Emitter 1 (Warm) to Emitter 0 (Cold)
-                weights[0] = throttled;       /* Cold increases with brightness */
-                weights[1] = 255 - throttled; /* Warm decreases with brightness */
-            } else if (NUM_EMITTERS > 0) {
-                weights[0] = 255;
+            // Shift from warm to cold as brightness rises
+            if (cold && warm) return 255;
+            if (cold) return BRIGHTNESS_LEVEL(level);
+            if (warm) return 255 - BRIGHTNESS_LEVEL(level);
+            return 0;
+
+        case CHANNEL_MODE_SEQUENTIAL: {
+            // Slices of the 8.8 ramp, so each emitter fades in smoothly
+            uint32_t slice = BRIGHTNESS_MAX / NUM_EMITTERS;
+            uint32_t start = idx * slice;
+
+            if (level <= start) return 0;
+            if (level >= start + slice) return 255;
+            return (level - start) * 255 / slice;
+        }
+
+        case CHANNEL_MODE_SINGLE:
+        default:
+            return idx == 0 ? 255 : 0;
+    }
+}
+
+#if CHANNEL_BUDGET
+/*
+ * Requested current (uA) of one emitter. Tint modes split the full-scale
+ * current by weight, so any mix of a level draws what one emitter at
+ * that level would; sequential stacks each emitter at its own current.
+ */
+static ALWAYS_INLINE uint32_t emitter_request(int idx, channel_mode_t mode, int role,
+                                              uint32_t duty, brightness_t level,
+                                              uint32_t shares)
+{
+    uint32_t weight = emitter_weight(mode, idx, role, level);
+
+    if (weight == 0) {
+        return 0;
+    }
+
+    if (mode == CHANNEL_MODE_SEQUENTIAL) {
+        return ((uint64_t)duty * weight * emitter_desc[idx].max_current_ma * 1000U) /
+               (255U * RAMP_TABLE_MAX_DUTY);
+    }
+    return ((uint64_t)duty * weight * full_scale_ua) / ((uint64_t)shares * RAMP_TABLE_MAX_DUTY);
+}
+
+#define EMITTER_SHARE(node, _mode) + emitter_weight(_mode, EMITTER_IDX(node),      \
+                                                    EMITTER_ROLE(node), level)
+
+#define EMITTER_MIX(node, _mode)                                                    \
+    req[EMITTER_IDX(node)] = emitter_request(EMITTER_IDX(node), _mode,              \
+                                             EMITTER_ROLE(node), EMITTER_DUTY(node), \
+                                             level, shares);
+
+/* One statement per emitter for a constant mode, after the weight sum */
+#define MIX(_mode) {                                                                \
+    __maybe_unused const uint32_t shares =                                          \
+        0 DT_FOREACH_CHILD_VARGS(GROUP_NODE, EMITTER_SHARE, _mode);                 \
+    DT_FOREACH_CHILD_VARGS(GROUP_NODE, EMITTER_MIX, _mode)                          \
+}
+
+/*
+ * Scale the requests down to the budget, keeping their ratio (the tint),
+ * and turn them into pulses. An emitter asked for more than its own
+ * full-duty current runs at full duty; the excess is not handed on.
+ */
+static void fit_budget(const uint32_t *req, uint32_t budget_ua)
+{
+    uint64_t total = 0;
+
+    for (int i = 0; i < NUM_EMITTERS; i++) {
+        total += req[i];
+    }
+
+    bool limited = total > budget_ua;
+
+    if (limited) {
+        stats.limited++;
+    }
+
+    for (int i = 0; i < NUM_EMITTERS; i++) {
+        uint32_t max_ua = emitter_desc[i].max_current_ma * 1000U;
+        uint32_t ua = limited ? ((uint64_t)req[i] * budget_ua) / total : req[i];
+
+        ua = MIN(ua, max_ua);
+        cache.pulse[i] = ((uint64_t)emitters[i].period * ua) / max_ua;
+    }
+}
+
+#else
+/* Pulse of one emitter from the duty of its gamma table, weighted by mode */
+static ALWAYS_INLINE uint32_t emitter_pulse(int idx, channel_mode_t mode, int role,
+                                            uint32_t duty, brightness_t level)
+{
+    uint32_t weight = emitter_weight(mode, idx, role, level);
+
+    if (weight == 0) {
+        return 0;
+    }
+
+    // Emitter duty = (duty * weight) / 255, in ramp table units
+    uint32_t scaled = weight == 255 ? duty : duty * weight / 255;
+    return ((uint64_t)emitters[idx].period * scaled) / RAMP_TABLE_MAX_DUTY;
+}
+
+#define EMITTER_MIX(node, _mode)                                                    \
+    cache.pulse[EMITTER_IDX(node)] = emitter_pulse(EMITTER_IDX(node), _mode,        \
+                                                   EMITTER_ROLE(node),              \
+                                                   EMITTER_DUTY(node), level);
+
+/* One statement per emitter for a constant mode */
+#define MIX(_mode) DT_FOREACH_CHILD_VARGS(GROUP_NODE, EMITTER_MIX, _mode)
+#endif /* CHANNEL_BUDGET */
+
+/* Fill the pulse cache for a level and current budget in the current mode */
+static void compute_pulses(brightness_t level, uint32_t budget_ua)
+{
+    // One lookup per gamma table (binding "ramp-table"); unused ones fold away
+    __maybe_unused const uint32_t duty_g28 =
+        brightness_to_duty_table(RAMP_TABLE_GAMMA(g28), level);
+    __maybe_unused const uint32_t duty_g22 =
+        brightness_to_duty_table(RAMP_TABLE_GAMMA(g22), level);
+
+#if CHANNEL_BUDGET
+    uint32_t req[NUM_EMITTERS];
+#else
+    ARG_UNUSED(budget_ua);
+#endif
+
+#if NUM_EMITTERS == 1
+    // Every mode lights the only emitter fully: a table lookup and a scale
+    MIX(CHANNEL_MODE_SINGLE);
+#else
+    switch (current_mode) {
+        case CHANNEL_MODE_50_50:      MIX(CHANNEL_MODE_50_50); break;
+        case CHANNEL_MODE_COLD:       MIX(CHANNEL_MODE_COLD); break;
+        case CHANNEL_MODE_WARM:       MIX(CHANNEL_MODE_WARM); break;
+        case CHANNEL_MODE_AUTO_TINT:  MIX(CHANNEL_MODE_AUTO_TINT); break;
+        case CHANNEL_MODE_SEQUENTIAL: MIX(CHANNEL_MODE_SEQUENTIAL); break;
+        default:                      MIX(CHANNEL_MODE_SINGLE); break;
+    }
+#endif
+
+#if CHANNEL_BUDGET
+    fit_budget(req, budget_ua);
+#endif
+
+    cache.valid = true;
+    cache.mode = current_mode;
+    cache.level = level;
+    cache.budget_ua = budget_ua;
+}
+
+void channel_stage_mix(brightness_t master_level)
+{
+#if CHANNEL_BUDGET
+    // Thermal and supply limits cap the current budget rather than scale
+    // the level: only mixes drawing more than the budget are cut down
+    brightness_t level = master_level;
+    uint32_t budget_ua = thermal_apply_budget(((uint64_t)full_scale_ua * supply_factor) / 255);
+#else
+    // Apply thermal throttling first
+    brightness_t level = thermal_apply_throttle(master_level);
+    uint32_t budget_ua = 0;
+#endif
+
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    stats.applies++;
+    if (!cache.valid || cache.mode != current_mode || cache.level != level ||
+        cache.budget_ua != budget_ua) {
+        compute_pulses(level, budget_ua);
+        stats.recomputes++;
+    }
+
+    k_spin_unlock(&lock, key);
+}
+
+bool channel_budget_enabled(void)
+{
+    return CHANNEL_BUDGET;
+}
+
+void channel_set_supply_mv(uint16_t mv)
+{
+#if CHANNEL_BUDGET
+    const uint32_t cutoff = CONFIG_ZBEAM_VOLTAGE_MIN_MV;
+    const uint32_t derate = CONFIG_ZBEAM_CHANNEL_DERATE_MV;
+    uint32_t target;
+
+    if (mv >= derate) {
+        target = 255;
+    } else if (mv <= cutoff) {
+        target = SUPPLY_FLOOR;
+    } else {
+        target = SUPPLY_FLOOR + (255 - SUPPLY_FLOOR) * (mv - cutoff) / (derate - cutoff);
+    }
+
+    // Sag follows the load: drop at once, recover in steps so a lighter
+    // load's higher reading does not swing the budget straight back
+    supply_factor = target < supply_factor ? target : MIN(target, supply_factor + SUPPLY_RISE);
+#else
+    ARG_UNUSED(mv);
+#endif
+}
+
+/* Set one emitter's on-time, end-aligned if it is staggered */
+static int write_emitter(int i, uint32_t pulse)
+{
+#ifdef CONFIG_ZBEAM_CHANNEL_PHASE_STAGGER
+    if (stagger_mask & BIT(i)) {
+        const struct pwm_dt_spec *spec = &emitters[i];
+        int ret = pwm_set(spec->dev, spec->channel, spec->period, spec->period - pulse,
+                          spec->flags ^ PWM_POLARITY_INVERTED);
+
+        if (ret != -ENOTSUP) {
+            return ret;
+        }
+        LOG_WRN("Emitter %d: no inverted polarity, running in phase", i);
+        stagger_mask &= ~BIT(i);
+    }
+#endif
+    return pwm_set_pulse_dt(&emitters[i], pulse);
+}
+
+#ifdef CONFIG_ZBEAM_CHANNEL_SYNC_HOLD
+/* SoCs without shadow register glue: no hold, commits fall back to plain writes */
+__weak int channel_sync_hold(const struct device *pwm)
+{
+    ARG_UNUSED(pwm);
+    return -ENOTSUP;
+}
+
+__weak void channel_sync_release(const struct device *pwm)
+{
+    ARG_UNUSED(pwm);
+}
+#endif
+
+/* Write the pending emitters of one PWM controller; returns first error */
+static int commit_controller(const struct device *dev, uint32_t pending, const uint32_t *pulse)
+{
+    uint32_t dimming = 0;
+    int err = 0;
+
+    for (int i = 0; i < NUM_EMITTERS; i++) {
+        if (emitters[i].dev != dev) {
+            pending &= ~BIT(i);
+        } else if ((pending & BIT(i)) && (written_mask & BIT(i)) && pulse[i] < written[i]) {
+            dimming |= BIT(i);
+        }
+    }
+
+#ifdef CONFIG_ZBEAM_CHANNEL_SYNC_HOLD
+    bool held = channel_sync_hold(dev) == 0;
+#endif
+
+    // Unheld, a period boundary can fall between the writes: dimming
+    // emitters go first so that period dips rather than overshoots
+    const uint32_t batches[] = {dimming, pending & ~dimming};
+
+    for (int b = 0; b < ARRAY_SIZE(batches); b++) {
+        for (int i = 0; i < NUM_EMITTERS; i++) {
+            if (!(batches[b] & BIT(i))) {
+                continue;
             }
-            break;
-
-        case CHANNEL_MODE_SEQUENTIAL:
-            if (NUM_EMITTERS > 0) {
-                uint8_t slice = 255 / NUM_EMITTERS;
-                for (int i = 0; i < NUM_EMITTERS; i++) {
-                    int32_t start = i * slice;
-                    int32_t end = (i + 1) * slice;
-                    if (throttled <= start) {
-                        weights[i] = 0;
-                    } else if (throttled >= end) {
-                        weights[i] = 255;
-                    } else {
-                        // Linear interpolate within slice
-                        weights[i] = (uint32_t)(throttled - start) * 255 / slice;
-                    }
-                }
+            int ret = write_emitter(i, pulse[i]);
+
+            if (ret == 0) {
+                written[i] = pulse[i];
+                written_mask |= BIT(i);
+            } else {
+                written_mask &= ~BIT(i);  // Unknown: write again next time
+                if (err == 0) err = ret;
             }
-            break;
+        }
+    }
 
-        default:
-            if (NUM_EMITTERS > 0) weights[0] = 255;
-            break;
+#ifdef CONFIG_ZBEAM_CHANNEL_SYNC_HOLD
+    if (held) {
+        channel_sync_release(dev);
     }
+#endif
+    return err;
+}
+
+int channel_commit(void)
+{
+    uint32_t pulse[NUM_EMITTERS];
+    uint32_t pending = 0;
+    uint32_t writes = 0;
+    uint32_t elided = 0;
+    int err = 0;
 
-    // Apply to hardware
+    k_mutex_lock(&commit_lock, K_FOREVER);
+
+    // Snapshot the stage: a new one may land while the drivers run
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    bool staged = cache.valid;
+
+    memcpy(pulse, cache.pulse, sizeof(pulse));
+    k_spin_unlock(&lock, key);
+
+    if (!staged) {
+        k_mutex_unlock(&commit_lock);
+        return 0;  // Nothing staged yet
+    }
+
+    // Emitters already at their pulse are left alone
     for (int i = 0; i < NUM_EMITTERS; i++) {
-        // Final duty = (throttled * weight) / 255
-        // If mode is AUTO_TINT, we use weight directly as it already incorporates the mix
-        uint32_t level;
-        if (current_mode == CHANNEL_MODE_AUTO_TINT && NUM_EMITTERS >= 2) {
-            level = weights[i]; // weights already scaled by throttled in this specific mode logic
-            // Wait, no. My weights[0] = throttled; logic above means if master=10, weight=10.
-            // Pulse = (Period * 10) / 255. Correct.
+        if ((written_mask & BIT(i)) && written[i] == pulse[i]) {
+            elided++;
         } else {
-            level = (uint32_t)throttled * weights[i] / 255;
+            pending |= BIT(i);
+            writes++;
+        }
+    }
+
+    key = k_spin_lock(&lock);
+    stats.elided += elided;
+    stats.writes += writes;
+    if (pending != 0) {
+        stats.commits++;
+    }
+    k_spin_unlock(&lock, key);
+
+#if NUM_EMITTERS == 1
+    // One emitter: a direct write, nothing to group
+    if (pending != 0) {
+        err = commit_controller(emitters[0].dev, pending, pulse);
+    }
+#else
+    // One batch per controller, in emitter order
+    while (pending != 0) {
+        int first = 0;
+        while (!(pending & BIT(first))) first++;
+
+        const struct device *dev = emitters[first].dev;
+        int ret = commit_controller(dev, pending, pulse);
+
+        if (ret < 0 && err == 0) err = ret;
+        for (int i = 0; i < NUM_EMITTERS; i++) {
+            if (emitters[i].dev == dev) pending &= ~BIT(i);
         }
+    }
+#endif
+
+    k_mutex_unlock(&commit_lock);
+
+    latency_stats_mark_output();
+    return err;
+}
+
+void channel_apply_mix(brightness_t master_level)
+{
+    channel_stage_mix(master_level);
+    channel_commit();
+}
 
-        uint32_t pulse = (emitters[i].period * level) / 255;
-        pwm_set_pulse_dt(&emitters[i], pulse);
+int channel_get_stats(struct channel_stats *out)
+{
+    if (out == NULL) {
+        return -EINVAL;
     }
+
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    *out = stats;
+    k_spin_unlock(&lock, key);
+    return 0;
+}
+
+void channel_reset_stats(void)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    stats = (struct channel_stats){0};
+    k_spin_unlock(&lock, key);
 }
 
 void channel_cycle_mode(void)
@@ -125,3 +573,46 @@ void channel_cycle_mode(void)
         current_mode = CHANNEL_MODE_SINGLE;
     }
 }
+
+#ifdef CONFIG_SHELL
+static int cmd_channel_stats(const struct shell *sh, size_t argc, char **argv)
+{
+    struct channel_stats st;
+
+    channel_get_stats(&st);
+    shell_print(sh, "applies %u, recomputes %u, limited %u, commits %u, writes %u, elided %u",
+                st.applies, st.recomputes, st.limited, st.commits, st.writes, st.elided);
+    return 0;
+}
+
+static int cmd_channel_emitters(const struct shell *sh, size_t argc, char **argv)
+{
+    static const char *const role_names[] = {"main", "cold", "warm", "secondary"};
+
+    for (int i = 0; i < NUM_EMITTERS; i++) {
+        shell_print(sh, "%d: %s (%s), %s ch %u, %u mA", i, emitter_desc[i].name,
+                    role_names[emitter_desc[i].role], emitters[i].dev->name,
+                    emitters[i].channel, emitter_desc[i].max_current_ma);
+    }
+#if CHANNEL_BUDGET
+    shell_print(sh, "Full scale %u mA, supply %u/255", full_scale_ua / 1000, supply_factor);
+#endif
+    return 0;
+}
+
+static int cmd_channel_reset(const struct shell *sh, size_t argc, char **argv)
+{
+    channel_reset_stats();
+    shell_print(sh, "Channel counters cleared");
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_channel,
+    SHELL_CMD(stats, NULL, "Show output stage counters", cmd_channel_stats),
+    SHELL_CMD(emitters, NULL, "List the emitter group", cmd_channel_emitters),
+    SHELL_CMD(reset, NULL, "Clear counters", cmd_channel_reset),
+    SHELL_SUBCMD_SET_END
+);
+
+SHELL_CMD_REGISTER(channel, &sub_channel, "Emitter output stage", NULL);
+#endif /* CONFIG_SHELL */
@@ -92,11 +92,14 @@ int main(void)
     LOG_INF("UI Actions initialized");
 
     /* 4. Initialize FSM with start node */
-    fsm_init(get_start_node());
+    fsm_init(&ui_fsm_table, get_start_node());
     LOG_INF("FSM initialized");
 
     /* 5. Initialize multi-tap input */
     multi_tap_input_init();
+    multi_tap_set_continue_query(fsm_input_can_continue);
+    multi_tap_set_press_hook(fsm_preview_press);
+    multi_tap_set_edge_hook(fsm_momentary_edge);
     
     /* Verify gpio_keys driver is ready */
     const struct device *input_dev = DEVICE_DT_GET_ONE(gpio_keys);
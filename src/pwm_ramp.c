@@ -0,0 +1,238 @@
+/*
+ * PWM Ramp - Non-blocking Fades
+ *
+ * One FSM deadline steps the active fade. Each expiry writes the level
+ * interpolated for the elapsed time and re-arms at the time the level
+ * next changes, chained from the previous expiry so worker latency does
+ * not stretch the fade. Nothing sleeps: the worker keeps handling input
+ * between steps, and stop/retarget take effect at once.
+ *
+ * The output write is the platform backend's (pwm_ramp_backend_write()).
+ * With CONFIG_PWM_RAMP_DMA the backend runs the whole fade instead and
+ * the deadline only fires when it is due to end, to collect the result.
+ * All entry points run on the FSM worker, so the state needs no locking.
+ */
+
+#include "pwm_ramp.h"
+#include "fsm_sched.h"
+
+#include <stdlib.h>
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(pwm_ramp, LOG_LEVEL_INF);
+
+/* Table entries per output change (LEDC interpolates in between) */
+#ifdef CONFIG_PWM_RAMP_INTERPOLATION_STEP
+#define FADE_STEP CONFIG_PWM_RAMP_INTERPOLATION_STEP
+#else
+#define FADE_STEP 1
+#endif
+
+static void fade_step(struct fsm_deadline *dl);
+static FSM_DEADLINE_DEFINE(fade_deadline, fade_step);
+
+static struct {
+    uint8_t from;
+    uint8_t to;
+    uint32_t ms;
+    uint32_t t;        /* Elapsed fade time at the current step */
+    int64_t next_ms;   /* Scheduled time of the current step */
+} fade;
+
+static bool active;
+static pwm_ramp_done_fn on_done;
+static uint8_t current_brightness;
+
+#ifdef CONFIG_PWM_RAMP_DMA
+static bool hw_fade;   /* The backend is running the fade */
+#endif
+
+static int write_level(uint8_t level)
+{
+    int ret = pwm_ramp_backend_write(level);
+
+    if (ret == 0) {
+        current_brightness = level;
+    }
+    return ret;
+}
+
+/* Halt a fade the backend is running and take over the level it reached */
+static void hw_fade_halt(void)
+{
+#ifdef CONFIG_PWM_RAMP_DMA
+    if (hw_fade) {
+        hw_fade = false;
+        current_brightness = pwm_ramp_backend_fade_stop();
+    }
+#endif
+}
+
+/* End the fade, then notify: the callback may start the next one */
+static void finish(bool completed)
+{
+    pwm_ramp_done_fn done = on_done;
+
+    hw_fade_halt();
+    fsm_deadline_stop(&fade_deadline);
+    active = false;
+    on_done = NULL;
+    if (done) {
+        done(current_brightness, completed);
+    }
+}
+
+/*
+ * Output the level for fade.t and arm the step at which it next changes
+ * by FADE_STEP. Finishes the fade once the target is written.
+ */
+static int fade_advance(void)
+{
+    uint32_t span = abs((int)fade.to - (int)fade.from);
+    uint32_t moved = (uint64_t)span * fade.t / fade.ms;
+
+    if (fade.t >= fade.ms) {
+        moved = span;
+    } else {
+        moved -= moved % FADE_STEP;
+    }
+
+    int ret = write_level(fade.to > fade.from ? fade.from + moved : fade.from - moved);
+
+    if (ret < 0) {
+        finish(false);
+        return ret;
+    }
+    if (moved == span) {
+        finish(true);
+        return 0;
+    }
+
+    /* First elapsed time at which the next step is reached */
+    uint32_t goal = MIN(moved + FADE_STEP, span);
+    uint32_t t_next = ((uint64_t)goal * fade.ms + span - 1) / span;
+    int64_t now = k_uptime_get();
+
+    fade.next_ms += t_next - fade.t;
+    fade.t = t_next;
+    if (fade.next_ms < now) {
+        /* Fell behind: skip ahead rather than replaying missed steps */
+        fade.t += now - fade.next_ms;
+        fade.next_ms = now;
+    }
+    fsm_deadline_start_at(&fade_deadline, fade.next_ms);
+    return 0;
+}
+
+/* Hand the fade to the backend; false if it has to be stepped here */
+static bool hw_fade_begin(void)
+{
+#ifdef CONFIG_PWM_RAMP_DMA
+    if (fade.t < fade.ms && pwm_ramp_backend_fade(fade.from, fade.to, fade.ms) == 0) {
+        hw_fade = true;
+        fsm_deadline_start_at(&fade_deadline, fade.next_ms + fade.ms);
+        return true;
+    }
+#endif
+    return false;
+}
+
+#ifdef CONFIG_PWM_RAMP_DMA
+/* Collect a hardware fade that is due to have ended */
+static void hw_fade_collect(void)
+{
+    uint8_t level;
+
+    if (pwm_ramp_backend_fade_poll(&level)) {
+        /* Timer pacing only rounds down, so this is clock skew: look again */
+        fsm_deadline_start(&fade_deadline, 1, 0);
+        return;
+    }
+    hw_fade = false;
+    current_brightness = level;
+    finish(true);
+}
+#endif
+
+static void fade_step(struct fsm_deadline *dl)
+{
+    if (!active) {
+        return;
+    }
+#ifdef CONFIG_PWM_RAMP_DMA
+    if (hw_fade) {
+        hw_fade_collect();
+        return;
+    }
+#endif
+    fade_advance();
+}
+
+/* (Re)start the interpolation from the level on the output now */
+static int begin(uint8_t target, uint32_t duration_ms)
+{
+    hw_fade_halt();
+    fade.from = current_brightness;
+    fade.to = target;
+    fade.ms = duration_ms;
+    fade.t = 0;
+    fade.next_ms = k_uptime_get();
+
+    if (duration_ms == 0 || target == current_brightness) {
+        fade.ms = 1;
+        fade.t = 1;
+    }
+    active = true;
+    LOG_DBG("Fade: %d -> %d in %u ms", fade.from, fade.to, duration_ms);
+    if (hw_fade_begin()) {
+        return 0;
+    }
+    return fade_advance();
+}
+
+int pwm_ramp_start(uint8_t target_brightness, uint32_t duration_ms, pwm_ramp_done_fn done)
+{
+    if (active) {
+        /* Superseded: report where the old fade got to */
+        finish(false);
+    }
+    on_done = done;
+    return begin(target_brightness, duration_ms);
+}
+
+int pwm_ramp_retarget(uint8_t target_brightness, uint32_t duration_ms)
+{
+    return begin(target_brightness, duration_ms);
+}
+
+void pwm_ramp_set_brightness(uint8_t brightness)
+{
+    if (active) {
+        finish(false);
+    }
+    write_level(brightness);
+}
+
+bool pwm_ramp_is_active(void)
+{
+    return active;
+}
+
+void pwm_ramp_stop(void)
+{
+    if (active) {
+        finish(false);
+    }
+}
+
+uint8_t pwm_ramp_get_brightness(void)
+{
+#ifdef CONFIG_PWM_RAMP_DMA
+    uint8_t level;
+
+    if (hw_fade) {
+        pwm_ramp_backend_fade_poll(&level);
+        return level;
+    }
+#endif
+    return current_brightness;
+}
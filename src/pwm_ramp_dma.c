@@ -1,101 +1,225 @@
 /*
- * PWM Ramp - DMA Implementation (Stub)
- * 
+ * PWM Ramp - DMA Backend
+ *
  * TRUE hardware-offloaded ramp using DMA to Timer CCR.
- * The DMA controller transfers duty values from the ramp table 
- * directly to the timer's Capture/Compare Register.
- * 
- * This is a generic implementation for MCUs with Timer+DMA support.
- * Currently a stub - requires hardware-specific initialization.
+ * A fade is precomputed into a buffer of compare values taken from the
+ * ramp table, and one DMA transfer streams the buffer into the timer's
+ * Capture/Compare Register on its update requests. Once started, a full
+ * 0->255 ramp costs no CPU: src/pwm_ramp.c only collects the result when
+ * the fade is due to end.
+ *
+ * Pacing: each value is held for a whole number of PWM periods (timer
+ * repetition, pwm_ramp_dma_set_pacing()). Fades shorter than one period
+ * per table entry stride through the table instead.
  *
- * Implementation requires:
- * - Configure TIMx in PWM mode
- * - Set up DMA channel: Memory -> TIMx_CCRx
- * - Trigger DMA on timer update event
- * - Circular mode for continuous looping
+ * Devicetree: a "zanduril,pwm-ramp-dma" node names the DMA channel and
+ * the request line of the timer update. The compare register and the
+ * repetition are timer registers, supplied by the SoC glue. The weak
+ * defaults below stand in where there is none: init then refuses the
+ * backend, and without pacing every fade is stepped by src/pwm_ramp.c.
  */
 
 #include "pwm_ramp.h"
 #include "ramp_table.h"
 
+#include <stdlib.h>
+#include <zephyr/drivers/dma.h>
 #include <zephyr/logging/log.h>
 LOG_MODULE_REGISTER(pwm_ramp_dma, CONFIG_PWM_LOG_LEVEL);
 
-/* DMA configuration notes:
- * 
- * Key registers (MCU-specific):
- * - DMA_CFGR: Channel config (MEM2PERIPH, circular, increment)
- * - DMA_CNDTR: Number of data to transfer
- * - DMA_CPAR: Peripheral address (TIMx_CCRy)
- * - DMA_CMAR: Memory address (ramp table)
- * 
- * Timer registers:
- * - TIMx_DIER: Enable update DMA request (UDE bit)
- * - TIMx_CCRx: Capture/Compare register (DMA destination)
- */
+#define RAMP_DMA_NODE DT_COMPAT_GET_ANY_STATUS_OKAY(zanduril_pwm_ramp_dma)
+#define RAMP_DMA_CHANNEL DT_PROP(RAMP_DMA_NODE, dma_channel)
+#define RAMP_DMA_SLOT DT_PROP(RAMP_DMA_NODE, dma_slot)
+
+static const struct device *const dma_dev = DEVICE_DT_GET(DT_DMAS_CTLR(RAMP_DMA_NODE));
 
 static const struct pwm_dt_spec *pwm_dev;
-static uint8_t current_brightness;
-static bool ramp_active;
+static volatile uint16_t *ccr;
+static uint32_t period_cycles;
+
+/* Compare values of the running fade, in output order */
+static uint16_t stream[RAMP_TABLE_SIZE];
+
+static struct {
+    uint8_t from;
+    uint8_t to;
+    uint8_t stride;    /* Table entries per streamed value */
+    uint16_t count;    /* Values in stream[] */
+    bool running;
+} fade;
+
+static struct dma_block_config block;
+
+static void dma_done(const struct device *dev, void *user_data, uint32_t channel, int status)
+{
+    /* Completion is collected by polling; only failures are of interest */
+    if (status < 0 && status != -ECANCELED) {
+        LOG_ERR("Ramp DMA failed: %d", status);
+    }
+}
+
+static struct dma_config dma_cfg = {
+    .dma_slot = RAMP_DMA_SLOT,
+    .channel_direction = MEMORY_TO_PERIPHERAL,
+    .source_data_size = sizeof(uint16_t),
+    .dest_data_size = sizeof(uint16_t),
+    .source_burst_length = sizeof(uint16_t),
+    .dest_burst_length = sizeof(uint16_t),
+    .block_count = 1,
+    .head_block = &block,
+    .dma_callback = dma_done,
+};
+
+/* SoCs without timer glue: no compare register to stream into */
+__weak volatile uint16_t *pwm_ramp_dma_compare_reg(void)
+{
+    return NULL;
+}
+
+__weak int pwm_ramp_dma_set_pacing(uint32_t periods)
+{
+    ARG_UNUSED(periods);
+    return -ENOTSUP;
+}
+
+static uint16_t compare_value(uint8_t brightness)
+{
+    /* Scale from table (max 8191) to the timer's period */
+    return ((uint64_t)pwm_ramp_table[brightness] * period_cycles) / RAMP_TABLE_MAX_DUTY;
+}
+
+/* Level on the output once @p sent values of the stream are out */
+static uint8_t level_after(uint32_t sent)
+{
+    uint32_t span = abs((int)fade.to - (int)fade.from);
+    uint32_t moved = MIN(sent * fade.stride, span);
+
+    return fade.to > fade.from ? fade.from + moved : fade.from - moved;
+}
+
+/* Values of the stream already written to the compare register */
+static uint32_t values_sent(void)
+{
+    struct dma_status status;
+
+    if (dma_get_status(dma_dev, RAMP_DMA_CHANNEL, &status) < 0 || !status.busy) {
+        return fade.count;
+    }
+    return fade.count - status.pending_length / sizeof(uint16_t);
+}
 
 int pwm_ramp_init(const struct pwm_dt_spec *pwm_spec)
 {
-    if (!device_is_ready(pwm_spec->dev)) {
-        LOG_ERR("PWM device not ready");
+    volatile uint16_t *reg = pwm_ramp_dma_compare_reg();
+    uint64_t cycles_per_sec;
+
+    if (reg == NULL) {
+        LOG_ERR("No compare register glue for the ramp DMA");
+        return -ENOTSUP;
+    }
+
+    if (!device_is_ready(pwm_spec->dev) || !device_is_ready(dma_dev)) {
+        LOG_ERR("PWM or DMA device not ready");
         return -ENODEV;
     }
-    
+
+    /* Let the PWM driver set the timer up, then own its compare register */
+    int ret = pwm_set_dt(pwm_spec, pwm_spec->period, 0);
+
+    if (ret == 0) {
+        ret = pwm_get_cycles_per_sec(pwm_spec->dev, pwm_spec->channel, &cycles_per_sec);
+    }
+    if (ret < 0) {
+        LOG_ERR("PWM timer setup failed: %d", ret);
+        return ret;
+    }
+
+    ccr = reg;
+    period_cycles = (cycles_per_sec * pwm_spec->period) / NSEC_PER_SEC;
     pwm_dev = pwm_spec;
-    current_brightness = 0;
-    ramp_active = false;
-    
-    /* TODO: Initialize DMA channel for Timer CCR */
-    LOG_WRN("DMA ramp not yet implemented - using stub");
-    
+
+    LOG_INF("PWM ramp initialized (DMA channel %d)", RAMP_DMA_CHANNEL);
+
     return 0;
 }
 
-void pwm_ramp_set_brightness(uint8_t brightness)
+int pwm_ramp_backend_write(uint8_t brightness)
 {
-    /* TODO: Direct register write for immediate brightness */
-    current_brightness = brightness;
-}
+    if (pwm_dev == NULL) return -ENODEV;
 
-int pwm_ramp_start(uint8_t target_brightness, uint32_t duration_ms)
-{
-    /* TODO: Configure DMA to transfer ramp table to CCR
-     * 
-     * Steps:
-     * 1. Calculate starting index in ramp table
-     * 2. Configure DMA source = &ramp_table[start_index]
-     * 3. Configure DMA destination = &TIMx->CCRy
-     * 4. Set transfer count = abs(target - current) / step
-     * 5. Configure timer period based on duration_ms
-     * 6. Enable DMA and start timer
-     */
-    
-    LOG_WRN("DMA ramp start: %d -> %d (not implemented)",
-            current_brightness, target_brightness);
-    
-    /* Fallback: just set final value */
-    current_brightness = target_brightness;
-    ramp_active = false;
-    
-    return -ENOTSUP;
+    /* Direct CCR write; src/pwm_ramp.c halts any fade first */
+    *ccr = compare_value(brightness);
+    return 0;
 }
 
-bool pwm_ramp_is_active(void)
+int pwm_ramp_backend_fade(uint8_t from, uint8_t to, uint32_t duration_ms)
 {
-    return ramp_active;
+    if (pwm_dev == NULL) return -ENODEV;
+
+    uint32_t span = abs((int)to - (int)from);
+    uint32_t updates = ((uint64_t)duration_ms * NSEC_PER_MSEC) / pwm_dev->period;
+
+    if (span == 0 || updates == 0) {
+        return -EINVAL;
+    }
+
+    fade.from = from;
+    fade.to = to;
+    fade.stride = DIV_ROUND_UP(span, MIN(updates, span));
+    fade.count = DIV_ROUND_UP(span, fade.stride);
+    for (uint32_t i = 0; i < fade.count; i++) {
+        stream[i] = compare_value(level_after(i + 1));
+    }
+
+    int ret = pwm_ramp_dma_set_pacing(updates / fade.count);
+
+    if (ret < 0) {
+        LOG_DBG("No ramp pacing (%d), fade stepped", ret);
+        return ret;
+    }
+
+    block = (struct dma_block_config){
+        .source_address = (uintptr_t)stream,
+        .dest_address = (uintptr_t)ccr,
+        .block_size = fade.count * sizeof(uint16_t),
+        .source_addr_adj = DMA_ADDR_ADJ_INCREMENT,
+        .dest_addr_adj = DMA_ADDR_ADJ_NO_CHANGE,
+    };
+
+    ret = dma_config(dma_dev, RAMP_DMA_CHANNEL, &dma_cfg);
+    if (ret == 0) {
+        ret = dma_start(dma_dev, RAMP_DMA_CHANNEL);
+    }
+    if (ret < 0) {
+        LOG_ERR("Ramp DMA start failed: %d", ret);
+        /* Stepped from here: each write has to take at the next period */
+        pwm_ramp_dma_set_pacing(1);
+        return ret;
+    }
+
+    fade.running = true;
+    LOG_DBG("DMA fade: %d -> %d, %u values x %u periods", from, to, fade.count,
+            updates / fade.count);
+    return 0;
 }
 
-void pwm_ramp_stop(void)
+bool pwm_ramp_backend_fade_poll(uint8_t *level)
 {
-    /* TODO: Disable DMA, stop timer */
-    ramp_active = false;
+    uint32_t sent = values_sent();
+
+    *level = level_after(sent);
+    if (fade.running && sent == fade.count) {
+        dma_stop(dma_dev, RAMP_DMA_CHANNEL);
+        fade.running = false;
+    }
+    return fade.running;
 }
 
-uint8_t pwm_ramp_get_brightness(void)
+uint8_t pwm_ramp_backend_fade_stop(void)
 {
-    return current_brightness;
+    uint8_t level = level_after(values_sent());
+
+    dma_stop(dma_dev, RAMP_DMA_CHANNEL);
+    fade.running = false;
+    return level;
 }
@@ -2,7 +2,9 @@
  * PWM Ramp - ESP32 LEDC Implementation
  * 
  * Uses LEDC hardware fade to interpolate between gamma-corrected table values.
- * This reduces CPU overhead while maintaining perception-corrected brightness.
+ * This reduces CPU overhead while maintaining perception-corrected brightness:
+ * fades (src/pwm_ramp.c) only write every CONFIG_PWM_RAMP_INTERPOLATION_STEP
+ * table entries.
  * 
  * Only compiled for ESP32 variants with CONFIG_PWM_RAMP_ESP32_LEDC_INTERPOLATION.
  */
@@ -14,7 +16,6 @@
 LOG_MODULE_REGISTER(pwm_ramp_esp32, CONFIG_PWM_LOG_LEVEL);
 
 /* ESP32 HAL includes for direct LEDC fade control */
-#include <stdlib.h>
 #include <hal/ledc_hal.h>
 #include <hal/ledc_ll.h>
 #include <soc/ledc_struct.h>
@@ -26,8 +27,6 @@ LOG_MODULE_REGISTER(pwm_ramp_esp32, CONFIG_PWM_LOG_LEVEL);
 #define LEDC_LS_SIG_OUT0        45
 
 static const struct pwm_dt_spec *pwm_dev;
-static uint8_t current_brightness;
-static bool ramp_active;
 
 /* PWM period in ns - must match device tree */
 #define PWM_PERIOD_NS 200000U
@@ -58,8 +57,6 @@ int pwm_ramp_init(const struct pwm_dt_spec *pwm_spec)
     }
     
     pwm_dev = pwm_spec;
-    current_brightness = 0;
-    ramp_active = false;
     
     /* Apply GPIO matrix workaround */
     configure_gpio_for_ledc();
@@ -70,71 +67,11 @@ int pwm_ramp_init(const struct pwm_dt_spec *pwm_spec)
     return 0;
 }
 
-void pwm_ramp_set_brightness(uint8_t brightness)
+int pwm_ramp_backend_write(uint8_t brightness)
 {
-    if (pwm_dev == NULL) return;
+    if (pwm_dev == NULL) return -ENODEV;
     
     uint32_t pulse_ns = brightness_to_pulse_ns(brightness);
     pwm_set_dt(pwm_dev, PWM_PERIOD_NS, pulse_ns);
-    current_brightness = brightness;
-}
-
-int pwm_ramp_start(uint8_t target_brightness, uint32_t duration_ms)
-{
-    if (pwm_dev == NULL) return -ENODEV;
-    
-    ramp_active = true;
-    
-    int step = CONFIG_PWM_RAMP_INTERPOLATION_STEP;
-    int start = current_brightness;
-    int end = target_brightness;
-    int direction = (end > start) ? 1 : -1;
-    int total_steps = (abs(end - start) + step - 1) / step;
-    
-    if (total_steps == 0) {
-        pwm_ramp_set_brightness(target_brightness);
-        ramp_active = false;
-        return 0;
-    }
-    
-    uint32_t step_delay_ms = duration_ms / total_steps;
-    
-    LOG_DBG("Ramp: %d -> %d, step=%d, total_steps=%d, delay=%dms",
-            start, end, step, total_steps, step_delay_ms);
-    
-    /* Step through table, using LEDC fade between points */
-    for (int i = start; direction > 0 ? (i < end) : (i > end); i += direction * step) {
-        int next_idx = i + direction * step;
-        if (direction > 0 && next_idx > end) next_idx = end;
-        if (direction < 0 && next_idx < end) next_idx = end;
-        
-        /* Set current brightness immediately */
-        pwm_ramp_set_brightness(next_idx);
-        
-        k_msleep(step_delay_ms);
-        
-        current_brightness = next_idx;
-        if (!ramp_active) break;
-    }
-    
-    /* Ensure final state */
-    pwm_ramp_set_brightness(target_brightness);
-    ramp_active = false;
-    
     return 0;
 }
-
-bool pwm_ramp_is_active(void)
-{
-    return ramp_active;
-}
-
-void pwm_ramp_stop(void)
-{
-    ramp_active = false;
-}
-
-uint8_t pwm_ramp_get_brightness(void)
-{
-    return current_brightness;
-}
@@ -10,7 +10,6 @@
  */
 
 #include <zephyr/kernel.h>
-#include <zephyr/random/random.h>
 #include <zephyr/logging/log.h>
 #include <zephyr/drivers/pwm.h>
 #include <zephyr/sys/reboot.h>
@@ -18,13 +17,18 @@
 #include <string.h>
 
 #include "fsm_engine.h"
+#include "fsm_sched.h"
 #include "batt_check.h"
 #include "nvs_manager.h"
 #include "thermal_manager.h"
 #include "pm_manager.h"
 #include "aux_manager.h"
+#include "safety_monitor.h"
 #include "channel_manager.h"
+#include "brightness.h"
 #include "pwm_ramp.h"
+#include "blink_seq.h"
+#include "led_pattern.h"
 
 #include "ui_actions.h" // Formerly key_map.h
 
@@ -64,7 +68,7 @@ static uint8_t manual_mem_level =
     128;
 #endif
 
-static uint8_t current_brightness = 0;
+static brightness_t current_brightness = 0;   /* 8.8 fixed point */
 static uint8_t override_brightness = 0;
 static uint8_t memorized_brightness = 128;
 static uint8_t brightness_floor = CONFIG_ZBEAM_BRIGHTNESS_FLOOR;
@@ -85,15 +89,15 @@ static uint8_t stepped_ramp_steps = CONFIG_ZBEAM_STEPPED_RAMP_STEPS;
 #define BRIGHTNESS_CEILING brightness_ceiling
 
 /* Strobe State */
-static struct k_timer strobe_timer;
 static uint8_t strobe_frequency = 12;
-static bool strobe_on = false;
-static bool party_mode = false;
+static void strobe_retune(void);
 
 /* Ramping State */
-static struct k_timer ramp_timer;
+static void ramp_tick(struct fsm_deadline *dl);
+static FSM_DEADLINE_DEFINE(ramp_deadline, ramp_tick);
 static int ramp_direction = 0;
 static bool ramp_active = false;
+static brightness_t ramp_step;   /* Smooth brightness change per tick */
 #define RAMP_STEP_SIZE 1
 
 enum control_param { PARAM_BRIGHTNESS, PARAM_FREQUENCY };
@@ -106,25 +110,35 @@ static enum control_param active_param = PARAM_BRIGHTNESS;
  * 
  * Wraps channel_apply_mix() to handle the actual hardware interaction.
  * 
- * @param level Brightness level (0-255)
+ * @param level 8.8 fixed-point brightness
  */
-static void update_led_hardware(uint8_t level) {
+static void update_led_hardware(brightness_t level) {
     channel_apply_mix(level);
 }
 
+/* Pattern output stage: patterns work in whole 0-255 levels */
+static void pattern_output(uint8_t level) {
+    update_led_hardware(BRIGHTNESS_FROM_LEVEL(level));
+}
+
 /**
  * @brief Periodic thermal regulation handler.
  * 
- * Called by thermal_timer. Reads temperature and adjusts output if necessary.
+ * Called by thermal_deadline. Reads temperature and adjusts output if necessary.
  * Note: Actual regulation logic is inside thermal_update(), this just triggers it.
+ * The battery voltage is sampled on the same tick when the channel mix has a
+ * current budget (emitter currents in the devicetree); otherwise no ADC read.
  * 
- * @param timer Pointer to the k_timer instance
+ * @param dl Pointer to the deadline instance
  */
-static struct k_timer thermal_timer;
-static void thermal_timer_handler(struct k_timer *timer) {
-    thermal_update(current_brightness);
+static void thermal_tick(struct fsm_deadline *dl) {
+    thermal_update(BRIGHTNESS_LEVEL(current_brightness));
+    if (channel_budget_enabled()) {
+        channel_set_supply_mv(batt_read_voltage_mv());
+    }
     update_led_hardware(current_brightness);
 }
+static FSM_DEADLINE_DEFINE(thermal_deadline, thermal_tick);
 
 /* Strobe Delay Calculation */
 static uint32_t get_strobe_delay_ms(uint8_t freq_idx) {
@@ -136,16 +150,30 @@ static uint32_t get_strobe_delay_ms(uint8_t freq_idx) {
 
 /* ========== Ramp Logic ========== */
 
-static void ramp_timer_handler(struct k_timer *timer) {
-    uint8_t *target_val = (active_param == PARAM_BRIGHTNESS) ? 
-                          &current_brightness : &strobe_frequency;
-    
-    // Use shared configuration for limits (Simple & Advanced share the same ramp config currently)
-    uint8_t floor = (active_param == PARAM_BRIGHTNESS) ? brightness_floor : 1;
-    uint8_t ceiling = (active_param == PARAM_BRIGHTNESS) ? brightness_ceiling : 255;
+/* One smooth ramp step within [floor, ceiling], bouncing at either end */
+static int32_t ramp_smooth(int32_t val, int32_t floor, int32_t ceiling, int32_t step) {
+    if (ramp_direction > 0) {
+        if (val < ceiling - step) val += step;
+        else { val = ceiling; ramp_direction = -1; /* Bounce at top */ }
+    } else if (ramp_direction < 0) {
+        if (val > floor + step) val -= step;
+        else { val = floor; ramp_direction = 1; /* Bounce at bottom */ }
+    }
+    return val;
+}
+
+static void ramp_tick(struct fsm_deadline *dl) {
+    if (active_param == PARAM_FREQUENCY) {
+        strobe_frequency = ramp_smooth(strobe_frequency, 1, 255, RAMP_STEP_SIZE);
+        strobe_retune();
+        return;
+    }
+
+    uint8_t floor = brightness_floor;
+    uint8_t ceiling = brightness_ceiling;
     
     /* Stepped Ramp Logic */
-    if (active_param == PARAM_BRIGHTNESS && current_ramp_style == RAMP_STEPPED) {
+    if (current_ramp_style == RAMP_STEPPED) {
         if (stepped_ramp_steps < 2) stepped_ramp_steps = 7; // Safety
         
         // Find current step index
@@ -156,7 +184,8 @@ static void ramp_timer_handler(struct k_timer *timer) {
         uint32_t range = ceiling - floor;
         if (range == 0) range = 1;
 
-        int32_t current_idx = ((int32_t)(*target_val - floor) * (stepped_ramp_steps - 1) + (range/2)) / range;
+        int32_t level = BRIGHTNESS_LEVEL(current_brightness);
+        int32_t current_idx = ((level - floor) * (stepped_ramp_steps - 1) + (int32_t)(range/2)) / (int32_t)range;
         
         // Move to next step
         if (ramp_direction > 0) current_idx++;
@@ -174,20 +203,15 @@ static void ramp_timer_handler(struct k_timer *timer) {
         
         // Calculate new value
         uint32_t new_val = floor + (current_idx * range) / (stepped_ramp_steps - 1);
-        *target_val = (uint8_t)new_val;
+        current_brightness = BRIGHTNESS_FROM_LEVEL(new_val);
         
     } else {
-        /* Smooth / Linear Ramping */
-        if (ramp_direction > 0) {
-            if (*target_val < ceiling - RAMP_STEP_SIZE) *target_val += RAMP_STEP_SIZE;
-            else { *target_val = ceiling; ramp_direction = -1; /* Bounce at top */ }
-        } else if (ramp_direction < 0) {
-            if (*target_val > floor + RAMP_STEP_SIZE) *target_val -= RAMP_STEP_SIZE;
-            else { *target_val = floor; ramp_direction = 1; /* Bounce at bottom */ }
-        }
+        /* Smooth Ramping, in sub-level steps */
+        current_brightness = ramp_smooth(current_brightness, BRIGHTNESS_FROM_LEVEL(floor),
+                                         BRIGHTNESS_FROM_LEVEL(ceiling), ramp_step);
     }
     
-    if (active_param == PARAM_BRIGHTNESS) update_led_hardware(current_brightness);
+    update_led_hardware(current_brightness);
 }
 
 void start_ramping(int direction) {
@@ -201,10 +225,11 @@ void start_ramping(int direction) {
             // Stepped: Slower updates. E.g., one step every 200ms?
             step_ms = 200; 
         } else {
-            // Smooth: Fast updates
+            // Smooth: a fraction of a level every tick, floor to ceiling in the sweep time
             uint32_t duration_ms = CONFIG_ZBEAM_BRIGHTNESS_SWEEP_DURATION_MS;
-            step_ms = duration_ms / 255;
-            if (step_ms < 1) step_ms = 1;
+            uint32_t range = BRIGHTNESS_FROM_LEVEL(brightness_ceiling - brightness_floor);
+            step_ms = CONFIG_ZBEAM_BRIGHTNESS_RAMP_TICK_MS;
+            ramp_step = MAX(range * step_ms / duration_ms, 1);
         }
     } else {
         // Strobe always smooth-ish
@@ -213,14 +238,14 @@ void start_ramping(int direction) {
         if (step_ms < 1) step_ms = 1;
     }
 
-    k_timer_start(&ramp_timer, K_MSEC(step_ms), K_MSEC(step_ms));
+    fsm_deadline_start(&ramp_deadline, step_ms, step_ms);
 }
 
 void stop_ramping(void) {
-    k_timer_stop(&ramp_timer);
+    fsm_deadline_stop(&ramp_deadline);
     ramp_direction = 0;
     if (ramp_active && active_param == PARAM_BRIGHTNESS) {
-        memorized_brightness = current_brightness;
+        memorized_brightness = BRIGHTNESS_LEVEL(current_brightness);
         // Persistence (Auto Memory behavior) - save immediately on ramp stop?
         // Or wait for turn off? Anduril usually saves on "1C" off or ramp stop.
         // For simplicity, we save "memorized" value here but write NVS later/seldom.
@@ -231,130 +256,142 @@ void stop_ramping(void) {
     ramp_active = false;
 }
 
-/* ========== Strobe Logic ========== */
-static uint32_t bike_counter = 0;
+/**
+ * @brief Encoder detents: step the brightness directly, no ramp timer.
+ *
+ * The level is memorized but not written to NVS, so spinning the dial
+ * costs no flash wear; the next ramp stop saves it.
+ *
+ * @param count Signed detent delta.
+ */
+const struct fsm_node *cb_encoder_brightness(const struct fsm_node *self, int count) {
+    int level = BRIGHTNESS_LEVEL(current_brightness) + count * CONFIG_ZBEAM_ENCODER_STEP;
 
-/* Helper to get random number in range [min, max] */
-static uint32_t get_random(uint32_t min, uint32_t max) {
-    if (max <= min) return min;
-    return min + (sys_rand32_get() % (max - min + 1));
+    memorized_brightness = CLAMP(level, BRIGHTNESS_FLOOR, BRIGHTNESS_CEILING);
+    current_brightness = BRIGHTNESS_FROM_LEVEL(memorized_brightness);
+    update_led_hardware(current_brightness);
+    return NULL;
 }
 
-static void strobe_timer_handler(struct k_timer *timer) {
-    uint32_t delay = 0;
-    
-    switch (current_strobe_mode) {
-        case STROBE_PARTY:
-            // Standard variable frequency strobe
-            // ON for very short time (freeze motion), OFF for delay
-            if (!strobe_on) {
-                // Was OFF, turn ON
-                strobe_on = true;
-                update_led_hardware(255);
-                delay = 2; // Short flash (2ms)
-            } else {
-                // Was ON, turn OFF
-                strobe_on = false;
-                update_led_hardware(0);
-                // Delay based on frequency
-                delay = get_strobe_delay_ms(strobe_frequency); 
-                if (delay < 5) delay = 5; 
-            }
-            break;
-
-        case STROBE_TACTICAL:
-            // 50% duty cycle, annoying
-            strobe_on = !strobe_on;
-            update_led_hardware(strobe_on ? 255 : 0);
-            delay = get_strobe_delay_ms(strobe_frequency);
-            break;
+/* ========== Strobe Logic ========== */
 
-        case STROBE_CANDLE:
-            // Random flicker: emulate flame
-            // Every tick, move towards target, update target randomly
-            {
-                // Simple implementation: random brightness every ~20ms
-                // Bias towards lower-mid range for steady burn, occasional dips/flares
-                // Center around brightness 50-100? Or use 'current_brightness' as base?
-                // Let's use current_brightness as the "base" level settable by user (not yet impl)
-                // Hardcode base 50 for now.
-                uint8_t base = 80;
-                // +/- 40
-                uint8_t var = get_random(0, 80);
-                uint8_t val = (base > 40) ? (base - 40 + var) : (var);
-                update_led_hardware(val);
-                delay = get_random(15, 30); // 15-30ms steps
-            }
-            break;
+/* Pattern arguments shared by the strobe group */
+enum { STROBE_ARG_PERIOD, STROBE_ARG_LEVEL };
+
+#define SOS_UNIT_MS 150     // Morse dot length
+#define BEACON_PERIOD_MS 2000
+
+static LED_PATTERN_DEFINE(pat_party,
+    // ON for very short time (freeze motion), OFF for the frequency period
+    PAT_LEVEL(255), PAT_HOLD(2),
+    PAT_LEVEL(0), PAT_HOLD_ARG(STROBE_ARG_PERIOD),
+    PAT_RESTART());
+
+static LED_PATTERN_DEFINE(pat_tactical,
+    // 50% duty cycle, annoying
+    PAT_LEVEL(255), PAT_HOLD_ARG(STROBE_ARG_PERIOD),
+    PAT_LEVEL(0), PAT_HOLD_ARG(STROBE_ARG_PERIOD),
+    PAT_RESTART());
+
+static LED_PATTERN_DEFINE(pat_candle,
+    // Random flicker to emulate flame: base 80 +/- 40, 15-30ms steps
+    PAT_RAND_LEVEL(40, 120), PAT_RAND_HOLD(15, 30),
+    PAT_RESTART());
+
+static LED_PATTERN_DEFINE(pat_bike,
+    // Steady low, pulse high. Period: 1000ms, high for 80ms.
+    PAT_LEVEL(255), PAT_HOLD(80),
+    PAT_LEVEL(40), PAT_HOLD(1000 - 80),
+    PAT_RESTART());
+
+static LED_PATTERN_DEFINE(pat_sos,
+    // ... --- ... at the memorized level, 7-unit word gap
+    PAT_REPEAT(3),
+        PAT_LEVEL_ARG(STROBE_ARG_LEVEL), PAT_HOLD(SOS_UNIT_MS),
+        PAT_LEVEL(0), PAT_HOLD(SOS_UNIT_MS),
+    PAT_NEXT(),
+    PAT_HOLD(2 * SOS_UNIT_MS),
+    PAT_REPEAT(3),
+        PAT_LEVEL_ARG(STROBE_ARG_LEVEL), PAT_HOLD(3 * SOS_UNIT_MS),
+        PAT_LEVEL(0), PAT_HOLD(SOS_UNIT_MS),
+    PAT_NEXT(),
+    PAT_HOLD(2 * SOS_UNIT_MS),
+    PAT_REPEAT(3),
+        PAT_LEVEL_ARG(STROBE_ARG_LEVEL), PAT_HOLD(SOS_UNIT_MS),
+        PAT_LEVEL(0), PAT_HOLD(SOS_UNIT_MS),
+    PAT_NEXT(),
+    PAT_HOLD(6 * SOS_UNIT_MS),
+    PAT_RESTART());
+
+static LED_PATTERN_DEFINE(pat_beacon,
+    // One short blink at the memorized level every 2s
+    PAT_LEVEL_ARG(STROBE_ARG_LEVEL), PAT_HOLD(100),
+    PAT_LEVEL(0), PAT_HOLD(BEACON_PERIOD_MS - 100),
+    PAT_RESTART());
+
+static const struct led_pattern *const strobe_patterns[STROBE_COUNT] = {
+    [STROBE_PARTY] = &pat_party,
+    [STROBE_TACTICAL] = &pat_tactical,
+    [STROBE_CANDLE] = &pat_candle,
+    [STROBE_BIKE] = &pat_bike,
+    [STROBE_SOS] = &pat_sos,
+    [STROBE_BEACON] = &pat_beacon,
+};
+
+static void strobe_play(enum strobe_type mode) {
+    const uint16_t args[] = {
+        [STROBE_ARG_PERIOD] = get_strobe_delay_ms(strobe_frequency),
+        [STROBE_ARG_LEVEL] = memorized_brightness,
+    };
+
+    current_strobe_mode = mode;
+    pm_resume();
+    led_pattern_play(strobe_patterns[mode], args, ARRAY_SIZE(args), NULL);
+}
 
-        case STROBE_BIKE:
-            // Steady low, Pulse high
-            // Period: 1000ms. High for 80ms.
-            bike_counter += 20; // 50Hz tick base
-            if (bike_counter > 1000) bike_counter = 0;
-            
-            if (bike_counter < 80) {
-                update_led_hardware(255); // Flash
-            } else {
-                update_led_hardware(40);  // Steady
-            }
-            delay = 20;
-            break;
-            
-        default:
-            delay = 100;
-            break;
+/* Apply a frequency change to the playing strobe without restarting it */
+static void strobe_retune(void) {
+    if (led_pattern_current() == strobe_patterns[current_strobe_mode]) {
+        led_pattern_set_arg(STROBE_ARG_PERIOD, get_strobe_delay_ms(strobe_frequency));
     }
-    
-    k_timer_start(&strobe_timer, K_MSEC(delay), K_NO_WAIT);
 }
 
 void action_strobe_party(void) {
     LOG_INF("Action: Strobe PARTY");
-    current_strobe_mode = STROBE_PARTY;
-    strobe_on = false;
-    pm_resume();
-    k_timer_start(&strobe_timer, K_NO_WAIT, K_NO_WAIT);
+    strobe_play(STROBE_PARTY);
 }
 
 void action_strobe_tactical(void) {
     LOG_INF("Action: Strobe TACTICAL");
-    current_strobe_mode = STROBE_TACTICAL;
-    strobe_on = false;
-    pm_resume();
-    k_timer_start(&strobe_timer, K_NO_WAIT, K_NO_WAIT);
+    strobe_play(STROBE_TACTICAL);
 }
 
 void action_strobe_candle(void) {
     LOG_INF("Action: Strobe CANDLE");
-    current_strobe_mode = STROBE_CANDLE;
-    pm_resume();
-    k_timer_start(&strobe_timer, K_NO_WAIT, K_NO_WAIT);
+    strobe_play(STROBE_CANDLE);
 }
 
 void action_strobe_bike(void) {
     LOG_INF("Action: Strobe BIKE");
-    current_strobe_mode = STROBE_BIKE;
-    bike_counter = 0;
-    pm_resume();
-    k_timer_start(&strobe_timer, K_NO_WAIT, K_NO_WAIT);
+    strobe_play(STROBE_BIKE);
+}
+
+void action_strobe_sos(void) {
+    LOG_INF("Action: Strobe SOS");
+    strobe_play(STROBE_SOS);
+}
+
+void action_strobe_beacon(void) {
+    LOG_INF("Action: Strobe BEACON");
+    strobe_play(STROBE_BEACON);
 }
 
-struct fsm_node* action_strobe_next(uint8_t count) {
+const struct fsm_node *action_strobe_next(uint8_t count) {
     int next = (int)current_strobe_mode + 1;
     if (next >= STROBE_COUNT) next = 0;
-    current_strobe_mode = (enum strobe_type)next;
-    
-    // Restart timer with new logic
-    k_timer_stop(&strobe_timer);
-    
-    switch (current_strobe_mode) {
-        case STROBE_PARTY: action_strobe_party(); break;
-        case STROBE_TACTICAL: action_strobe_tactical(); break;
-        case STROBE_CANDLE: action_strobe_candle(); break;
-        case STROBE_BIKE: action_strobe_bike(); break;
-        default: action_strobe_party(); break;
-    }
+
+    LOG_INF("Strobe: %s", strobe_patterns[next]->name);
+    strobe_play((enum strobe_type)next);
     
     return NULL; // Stay in same state (ADV_STROBE group)
 }
@@ -365,10 +402,10 @@ struct fsm_node* action_strobe_next(uint8_t count) {
 static int64_t last_off_time = 0;
 
 void action_off(void) {
+    led_pattern_stop();
     stop_ramping();
     update_led_hardware(0);
-    k_timer_stop(&thermal_timer);
-    k_timer_stop(&strobe_timer);
+    fsm_deadline_stop(&thermal_deadline);
     
     /* Record timestamp for Hybrid Memory */
     last_off_time = k_uptime_get();
@@ -377,17 +414,10 @@ void action_off(void) {
     LOG_INF("Action: OFF (Ts: %lld)", last_off_time);
 }
 
-void action_on(void) {
-    pm_resume();
-    k_timer_start(&thermal_timer, K_MSEC(500), K_MSEC(500));
-    stop_ramping();
-    
+/* Level ON would use, without consuming the one-shot override */
+static uint8_t on_level(void) {
     if (override_brightness > 0) {
-        current_brightness = override_brightness;
-        override_brightness = 0; // Consume one-shot override
-        update_led_hardware(current_brightness);
-        LOG_INF("Action: ON (Override: %d)", current_brightness);
-        return;
+        return override_brightness;
     }
 
     uint8_t target_pwm = memorized_brightness;
@@ -418,24 +448,68 @@ void action_on(void) {
             target_pwm = memorized_brightness;
             break;
     }
+
+    return target_pwm;
+}
+
+void action_on(void) {
+    blink_seq_abort();
+    pm_resume();
+    fsm_deadline_start(&thermal_deadline, 500, 500);
+    stop_ramping();
     
-    current_brightness = target_pwm;
+    current_brightness = BRIGHTNESS_FROM_LEVEL(on_level());
+    if (override_brightness > 0) {
+        override_brightness = 0; // Consume one-shot override
+        update_led_hardware(current_brightness);
+        LOG_INF("Action: ON (Override: %d)", BRIGHTNESS_LEVEL(current_brightness));
+        return;
+    }
+
     update_led_hardware(current_brightness);
-    LOG_INF("Action: ON (%d) [Mode: %d]", current_brightness, current_mem_mode);
+    LOG_INF("Action: ON (%d) [Mode: %d]", BRIGHTNESS_LEVEL(current_brightness), current_mem_mode);
+}
+
+#ifdef CONFIG_ZBEAM_SPECULATIVE_ON
+/*
+ * Speculative turn-on: light the ON level at the first key-down from OFF.
+ * Whatever node the sequence resolves to sets its own level; if it maps
+ * to nothing, the engine reverts us. Not while a safety fault is live:
+ * the press then waits for the FSM like any other.
+ */
+static bool preview_begin(const struct fsm_node *node) {
+    if (node->action_routine != action_off || safety_get_status() != SAFETY_OK) {
+        return false;
+    }
+    pm_resume();
+    update_led_hardware(BRIGHTNESS_FROM_LEVEL(on_level()));
+    return true;
+}
+
+static void preview_revert(const struct fsm_node *node) {
+    update_led_hardware(0);
+    pm_suspend();
 }
 
+static const struct fsm_preview ui_preview = {
+    .begin = preview_begin,
+    .revert = preview_revert,
+};
+#endif
+
 void action_moon(void) {
+    led_pattern_stop();
     pm_resume();
-    k_timer_stop(&strobe_timer);
-    current_brightness = BRIGHTNESS_FLOOR;
+    current_brightness = BRIGHTNESS_FROM_LEVEL(BRIGHTNESS_FLOOR);
     update_led_hardware(current_brightness);
     LOG_INF("Action: MOON");
 }
 
 void action_turbo(void) {
+    blink_seq_abort();
     pm_resume();
     stop_ramping();
-    current_brightness = BRIGHTNESS_CEILING; // Or 255 absolute turbo
+    current_brightness = BRIGHTNESS_FROM_LEVEL(BRIGHTNESS_CEILING); // Or 255 absolute turbo
     update_led_hardware(current_brightness);
     LOG_INF("Action: TURBO");
 }
@@ -446,21 +520,50 @@ void action_ramp(void) {
 }
 
 void action_lockout(void) {
+    blink_seq_abort();
     stop_ramping();
     update_led_hardware(0);
+    fsm_deadline_stop(&thermal_deadline);  /* Entered from ON: nothing to regulate */
     LOG_INF("Action: LOCKOUT");
 }
 
+/*
+ * Momentary fast path for lockout: the emitter follows the button at moon
+ * level straight from the input callback. The level is fixed on entry, so
+ * an edge is a single output write with no worker pass in between.
+ */
+static uint8_t momentary_level;
+
+static void momentary_arm(const struct fsm_node *node) {
+    momentary_level = BRIGHTNESS_FLOOR;
+}
+
+static void momentary_edge(bool pressed) {
+    update_led_hardware(pressed ? BRIGHTNESS_FROM_LEVEL(momentary_level) : 0);
+}
+
+static const struct fsm_momentary ui_momentary = {
+    .arm = momentary_arm,
+    .edge = momentary_edge,
+};
+
+/* Readout finished: start the node's auto-exit timeout from here */
+static void readout_done(void) {
+    fsm_restart_timeout();
+}
+
+/* Feedback flash finished: return to the current level */
+static void feedback_done(void) {
+    update_led_hardware(current_brightness);
+}
+
 void action_battcheck(void) {
     stop_ramping();
     LOG_INF("Action: BATTCHECK");
     uint16_t mv = batt_read_voltage_mv();
     uint8_t major, minor;
     batt_calculate_blinks(mv, &major, &minor);
-    // Blocking blink sequence (simple implementation)
-    for (int i=0; i<major; i++) { update_led_hardware(100); k_msleep(100); update_led_hardware(0); k_msleep(300); }
-    k_msleep(800);
-    for (int i=0; i<minor; i++) { update_led_hardware(100); k_msleep(100); update_led_hardware(0); k_msleep(300); }
+    blink_seq_play_code(major, minor, 100, readout_done);
 }
 
 void action_tempcheck(void) {
@@ -472,19 +575,13 @@ void action_tempcheck(void) {
     uint8_t major = c / 10;
     uint8_t minor = c % 10;
     
-    for (int i=0; i<major; i++) { update_led_hardware(100); k_msleep(100); update_led_hardware(0); k_msleep(300); }
-    k_msleep(800);
-    for (int i=0; i<minor; i++) { update_led_hardware(100); k_msleep(100); update_led_hardware(0); k_msleep(300); }
+    blink_seq_play_code(major, minor, 100, readout_done);
 }
 
 void action_strobe(void) {
     stop_ramping();
-    party_mode = false;
     active_param = PARAM_FREQUENCY; 
-    uint32_t delay = get_strobe_delay_ms(strobe_frequency);
-    k_timer_start(&strobe_timer, K_MSEC(delay), K_NO_WAIT);
-    update_led_hardware(255);
-    strobe_on = true;
+    strobe_play(current_strobe_mode);
     LOG_INF("Action: STROBE");
 }
 
@@ -494,40 +591,39 @@ void action_aux_config(void)
     aux_cycle_mode();
     
     /* Visual feedback: Blink main beam briefly */
-    uint8_t prev = ui_get_current_pwm();
-    update_led_hardware(255);
-    k_msleep(20);
-    update_led_hardware(prev);
+    blink_seq_flash(255, 20, feedback_done);
 }
 
 /* Config Buzz Logic */
-static struct k_timer buzz_timer;
 static bool buzz_state = false;
-static void buzz_timer_handler(struct k_timer *timer) {
+static void buzz_tick(struct fsm_deadline *dl) {
     buzz_state = !buzz_state;
-    update_led_hardware(buzz_state ? 4 : 1);
+    update_led_hardware(BRIGHTNESS_FROM_LEVEL(buzz_state ? 4 : 1));
+}
+static FSM_DEADLINE_DEFINE(buzz_deadline, buzz_tick);
+
+static void start_buzz(void) {
+    blink_seq_abort();
+    fsm_deadline_start(&buzz_deadline, 20, 20); // 50Hz Buzz
 }
 
 void action_config_floor(void) {
     LOG_INF("Config: Floor (Wait for clicks)");
-    k_timer_init(&buzz_timer, buzz_timer_handler, NULL);
-    k_timer_start(&buzz_timer, K_MSEC(20), K_MSEC(20)); // 50Hz Buzz
+    start_buzz();
 }
 
 void action_config_ceiling(void) {
     LOG_INF("Config: Ceiling (Wait for clicks)");
-    k_timer_init(&buzz_timer, buzz_timer_handler, NULL);
-    k_timer_start(&buzz_timer, K_MSEC(20), K_MSEC(20));
+    start_buzz();
 }
 
 void action_config_steps(void) {
     LOG_INF("Config: Steps (Wait for clicks)");
-    k_timer_init(&buzz_timer, buzz_timer_handler, NULL);
-    k_timer_start(&buzz_timer, K_MSEC(20), K_MSEC(20));
+    start_buzz();
 }
 
-struct fsm_node* cb_config_floor_set(struct fsm_node *self, int count) {
-    k_timer_stop(&buzz_timer);
+const struct fsm_node *cb_config_floor_set(const struct fsm_node *self, int count) {
+    fsm_deadline_stop(&buzz_deadline);
     if (count > 0) {
         brightness_floor = (uint8_t)count;
         LOG_INF("Floor set to: %d", brightness_floor);
@@ -536,12 +632,11 @@ struct fsm_node* cb_config_floor_set(struct fsm_node *self, int count) {
         #endif
     }
     // Transition to Ceiling (defined in ui_advanced.c)
-    extern struct fsm_node adv_config_ceiling;
     return &adv_config_ceiling;
 }
 
-struct fsm_node* cb_config_ceiling_set(struct fsm_node *self, int count) {
-    k_timer_stop(&buzz_timer);
+const struct fsm_node *cb_config_ceiling_set(const struct fsm_node *self, int count) {
+    fsm_deadline_stop(&buzz_deadline);
     if (count > 0) {
         // Ceiling in Anduril is 151 - N. In ZBeam 1-255:
         // Let's do 256 - N.
@@ -553,65 +648,57 @@ struct fsm_node* cb_config_ceiling_set(struct fsm_node *self, int count) {
         #endif
     }
     // Transition back to ON
-    extern struct fsm_node adv_on;
     return &adv_on;
 }
 
-struct fsm_node* cb_config_steps_set(struct fsm_node *self, int count) {
-    k_timer_stop(&buzz_timer);
+const struct fsm_node *cb_config_steps_set(const struct fsm_node *self, int count) {
+    fsm_deadline_stop(&buzz_deadline);
     // Steps logic not fully impl, just return
-    extern struct fsm_node adv_on;
     return &adv_on;
 }
 
 void action_cal_voltage_entry(void) {
     LOG_INF("Cal: Voltage (Wait for clicks)");
-    k_timer_init(&buzz_timer, buzz_timer_handler, NULL);
-    k_timer_start(&buzz_timer, K_MSEC(20), K_MSEC(20));
+    start_buzz();
 }
 
-struct fsm_node* cb_cal_voltage_set(struct fsm_node *self, int count) {
-    k_timer_stop(&buzz_timer);
+const struct fsm_node *cb_cal_voltage_set(const struct fsm_node *self, int count) {
+    fsm_deadline_stop(&buzz_deadline);
     if (count > 0) {
         // Count = Voltage * 10. e.g. 42 = 4.2V.
         uint16_t mv = count * 100;
         batt_calibrate_voltage(mv);
     }
-    extern struct fsm_node adv_battcheck;
     return &adv_battcheck;
 }
 
 void action_cal_thermal_entry(void) {
     LOG_INF("Cal: Thermal Current (Wait for clicks)");
-    k_timer_init(&buzz_timer, buzz_timer_handler, NULL);
-    k_timer_start(&buzz_timer, K_MSEC(20), K_MSEC(20));
+    start_buzz();
 }
 
-struct fsm_node* cb_cal_thermal_set(struct fsm_node *self, int count) {
-    k_timer_stop(&buzz_timer);
+const struct fsm_node *cb_cal_thermal_set(const struct fsm_node *self, int count) {
+    fsm_deadline_stop(&buzz_deadline);
     if (count > 0) {
         // Count = Degrees C
         thermal_calibrate_current_temp((int32_t)count);
     }
     // Transition to Limit
-    extern struct fsm_node adv_cal_thermal_limit;
     return &adv_cal_thermal_limit;
 }
 
 void action_cal_thermal_limit_entry(void) {
     LOG_INF("Cal: Thermal Limit (Wait for clicks)");
-    k_timer_init(&buzz_timer, buzz_timer_handler, NULL);
-    k_timer_start(&buzz_timer, K_MSEC(20), K_MSEC(20));
+    start_buzz();
 }
 
-struct fsm_node* cb_cal_thermal_limit_set(struct fsm_node *self, int count) {
-    k_timer_stop(&buzz_timer);
+const struct fsm_node *cb_cal_thermal_limit_set(const struct fsm_node *self, int count) {
+    fsm_deadline_stop(&buzz_deadline);
     if (count > 0) {
         // Limit = 30 + Count
         uint8_t limit = 30 + count;
         thermal_set_limit(limit);
     }
-    extern struct fsm_node adv_tempcheck;
     return &adv_tempcheck;
 }
 
@@ -627,7 +714,7 @@ void action_factory_reset(void)
 
 /* ========== System Init & Mode Switching ========== */
 
-struct fsm_node *get_start_node(void) {
+const struct fsm_node *get_start_node(void) {
     if (current_ui_mode == UI_SIMPLE) {
         return get_simple_off_node();
     } else {
@@ -635,7 +722,7 @@ struct fsm_node *get_start_node(void) {
     }
 }
 
-struct fsm_node *ui_toggle_mode(void) {
+const struct fsm_node *ui_toggle_mode(void) {
     if (current_ui_mode == UI_SIMPLE) {
         current_ui_mode = UI_ADVANCED;
         LOG_INF("UI Mode -> ADVANCED");
@@ -651,16 +738,21 @@ struct fsm_node *ui_toggle_mode(void) {
     return get_start_node();
 }
 
+const struct fsm_node *cb_toggle_ui_mode(const struct fsm_node *self, int count) {
+    return ui_toggle_mode();
+}
+
 void ui_init(void) {
-    k_timer_init(&ramp_timer, ramp_timer_handler, NULL);
-    k_timer_init(&strobe_timer, strobe_timer_handler, NULL);
-    k_timer_init(&thermal_timer, thermal_timer_handler, NULL);
-    
     thermal_init();
     batt_init();
     pm_init();
     channel_init();
     aux_init();
+    led_pattern_init(pattern_output);
+#ifdef CONFIG_ZBEAM_SPECULATIVE_ON
+    fsm_set_preview(&ui_preview);
+#endif
+    fsm_set_momentary(&ui_momentary);
     
     memorized_brightness = 128;
     
@@ -711,7 +803,7 @@ void ui_init(void) {
 }
 
 /* Wrappers */
-uint8_t ui_get_current_pwm(void) { return current_brightness; }
+uint8_t ui_get_current_pwm(void) { return BRIGHTNESS_LEVEL(current_brightness); }
 uint8_t ui_get_strobe_freq(void) { return strobe_frequency; }
 enum ui_mode ui_get_current_mode(void) { return current_ui_mode; }
 
@@ -721,13 +813,13 @@ void ui_set_next_brightness(uint8_t level) {
 void ui_set_next_brightness_floor(void) { override_brightness = brightness_floor; }
 void ui_set_next_brightness_ceiling(void) { override_brightness = brightness_ceiling; }
 
-struct fsm_node* action_channel_cycle(uint8_t count) {
+const struct fsm_node *action_channel_cycle(uint8_t count) {
     channel_cycle_mode();
     // Return a short blink for feedback (using existing blink-buzz if possible or just returning current state)
     return NULL; 
 }
 
-struct fsm_node *action_toggle_ramp_style(uint8_t count) {
+const struct fsm_node *action_toggle_ramp_style(uint8_t count) {
     if (current_ramp_style == RAMP_SMOOTH) current_ramp_style = RAMP_STEPPED;
     else current_ramp_style = RAMP_SMOOTH;
     
@@ -738,10 +830,7 @@ struct fsm_node *action_toggle_ramp_style(uint8_t count) {
     #endif
     
     // Feedback: Blink once for stepped, buzz for smooth? Or just blink.
-    uint8_t prev = ui_get_current_pwm();
-    update_led_hardware(0);
-    k_msleep(100);
-    update_led_hardware(prev);
+    blink_seq_flash(0, 100, feedback_done);
     
     return NULL;
 }
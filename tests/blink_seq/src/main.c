@@ -0,0 +1,141 @@
+/**
+ * @file main.c
+ * @brief Unit tests for the non-blocking blink-code sequencer.
+ *
+ * No worker thread is linked: the test thread stands in for it and runs
+ * expired deadlines itself, so every output step is observed in order.
+ */
+
+#include <zephyr/ztest.h>
+#include "blink_seq.h"
+#include "led_pattern.h"
+#include "fsm_sched.h"
+
+#define MAX_WRITES 32
+
+static uint8_t levels[MAX_WRITES];
+static int64_t stamps[MAX_WRITES];
+static int writes;
+static int done_calls;
+
+static void mock_output(uint8_t level)
+{
+    if (writes < MAX_WRITES) {
+        levels[writes] = level;
+        stamps[writes] = k_uptime_get();
+    }
+    writes++;
+}
+
+static void mock_done(void)
+{
+    done_calls++;
+}
+
+/* Act as the FSM worker for up to @p max_ms or until the sequence ends */
+static void run_for(uint32_t max_ms)
+{
+    int64_t end = k_uptime_get() + max_ms;
+
+    while (blink_seq_is_active() && k_uptime_get() < end) {
+        fsm_sched_run_expired();
+        k_msleep(1);
+    }
+}
+
+static void *blink_setup(void)
+{
+    zassert_equal(blink_seq_flash(255, 10, NULL), -ENODEV, "Playing without output must fail");
+    led_pattern_init(mock_output);
+    return NULL;
+}
+
+static void blink_before(void *fixture)
+{
+    led_pattern_stop();
+    writes = 0;
+    done_calls = 0;
+}
+
+ZTEST_SUITE(blink_seq_suite, NULL, blink_setup, blink_before, NULL, NULL);
+
+ZTEST(blink_seq_suite, test_code_sequence)
+{
+    /* 4.2V: 4 major, 2 minor blinks */
+    int64_t start = k_uptime_get();
+
+    zassert_ok(blink_seq_play_code(4, 2, 100, mock_done));
+    zassert_true(blink_seq_is_active());
+    run_for(5000);
+
+    zassert_false(blink_seq_is_active());
+    zassert_equal(writes, 12, "Expected 6 on/off pairs, got %d writes", writes);
+    for (int i = 0; i < writes; i++) {
+        zassert_equal(levels[i], (i % 2) ? 0 : 100, "Write %d has level %d", i, levels[i]);
+    }
+
+    /* Blink and group pauses, with scheduler slack */
+    zassert_within(stamps[1] - stamps[0], BLINK_ON_MS, 5);
+    zassert_within(stamps[2] - stamps[1], BLINK_OFF_MS, 5);
+    zassert_within(stamps[8] - stamps[7], BLINK_OFF_MS + BLINK_GAP_MS, 5);
+
+    zassert_equal(done_calls, 1);
+    zassert_within(k_uptime_get() - start, 6 * (BLINK_ON_MS + BLINK_OFF_MS) + BLINK_GAP_MS, 20);
+}
+
+ZTEST(blink_seq_suite, test_empty_group)
+{
+    /* 3.0V: minor group is empty, gap is still observed */
+    zassert_ok(blink_seq_play_code(3, 0, 100, mock_done));
+    run_for(3000);
+
+    zassert_equal(writes, 6);
+    zassert_equal(done_calls, 1);
+}
+
+ZTEST(blink_seq_suite, test_abort)
+{
+    zassert_ok(blink_seq_play_code(4, 2, 100, mock_done));
+    run_for(500);
+    zassert_true(blink_seq_is_active());
+
+    int seen = writes;
+
+    blink_seq_abort();
+    zassert_false(blink_seq_is_active());
+
+    /* Nothing left scheduled: further worker passes are silent */
+    k_msleep(BLINK_GAP_MS);
+    fsm_sched_run_expired();
+    zassert_equal(writes, seen, "Output changed after abort");
+    zassert_equal(done_calls, 0, "Aborted sequence must not complete");
+}
+
+ZTEST(blink_seq_suite, test_flash)
+{
+    int64_t start = k_uptime_get();
+
+    zassert_ok(blink_seq_flash(255, 20, mock_done));
+    zassert_equal(writes, 1, "Flash level is applied immediately");
+    zassert_equal(levels[0], 255);
+    zassert_equal(done_calls, 0);
+
+    run_for(200);
+    zassert_equal(done_calls, 1);
+    zassert_true(k_uptime_get() - start >= 20, "Flash ended early");
+}
+
+ZTEST(blink_seq_suite, test_restart_replaces)
+{
+    zassert_ok(blink_seq_play_code(4, 2, 100, mock_done));
+    run_for(200);
+
+    /* A new sequence drops the old one without completing it */
+    zassert_ok(blink_seq_play_code(1, 1, 50, mock_done));
+    writes = 0;
+    run_for(3000);
+
+    zassert_equal(writes, 4);
+    zassert_equal(levels[0], 50);
+    zassert_equal(done_calls, 1);
+}
@@ -0,0 +1,197 @@
+/**
+ * @file main.c
+ * @brief Tests for constant-power mixing against a current budget.
+ *
+ * Cold (3000 mA) and warm (2000 mA) emitters on the fake PWM controller,
+ * no group limit: full scale is the larger emitter's 3000 mA. Currents
+ * are read back from the written pulses.
+ */
+
+#include <zephyr/ztest.h>
+#include <zephyr/fff.h>
+#include <zephyr/drivers/pwm/pwm_fake.h>
+#include "channel_manager.h"
+
+DEFINE_FFF_GLOBALS;
+
+#define PERIOD_NS 100000
+#define COLD 0
+#define WARM 1
+#define FULL_SCALE_UA 3000000
+
+/* One ns of pulse on the cold emitter is 30 uA */
+#define TOLERANCE_UA 100
+
+static const uint32_t max_ua[] = {3000000, 2000000};
+static uint8_t throttle_factor;
+
+/* --- MOCKS --- */
+
+uint32_t thermal_apply_budget(uint32_t budget_ua)
+{
+    return ((uint64_t)budget_ua * throttle_factor) / 255;
+}
+
+/* --- HELPERS --- */
+
+static uint32_t last_pulse(uint32_t channel)
+{
+    for (int i = fake_pwm_set_cycles_fake.call_count - 1; i >= 0; i--) {
+        if (i < FFF_ARG_HISTORY_LEN && fake_pwm_set_cycles_fake.arg1_history[i] == channel) {
+            return fake_pwm_set_cycles_fake.arg3_history[i];
+        }
+    }
+    return 0;
+}
+
+static uint32_t current_ua(uint32_t channel)
+{
+    return ((uint64_t)last_pulse(channel) * max_ua[channel]) / PERIOD_NS;
+}
+
+static uint32_t total_ua(void)
+{
+    return current_ua(COLD) + current_ua(WARM);
+}
+
+/* Current one emitter at full scale draws for @p b */
+static uint32_t expect_ua(brightness_t b)
+{
+    return ((uint64_t)brightness_to_duty(b) * FULL_SCALE_UA) / RAMP_TABLE_MAX_DUTY;
+}
+
+static uint32_t limited(void)
+{
+    struct channel_stats st;
+
+    zassert_ok(channel_get_stats(&st));
+    return st.limited;
+}
+
+/* From the 50/50 start, step @p n modes along */
+static void cycle_modes(int n)
+{
+    while (n-- > 0) {
+        channel_cycle_mode();
+    }
+}
+
+/* --- FIXTURE --- */
+
+static void before(void *fixture)
+{
+    channel_init();   /* 50/50, full supply */
+    channel_reset_stats();
+    RESET_FAKE(fake_pwm_set_cycles);
+    throttle_factor = 255;
+}
+
+ZTEST_SUITE(channel_budget_suite, NULL, NULL, before, NULL, NULL);
+
+/* --- TESTS --- */
+
+ZTEST(channel_budget_suite, test_tint_mixes_draw_the_same_current)
+{
+    static const uint8_t levels[] = {20, 80, 150, 200};
+
+    zassert_true(channel_budget_enabled(), "Both emitters have currents");
+
+    /* 50/50, cold, warm, auto-tint */
+    for (int mode = 0; mode < 4; mode++) {
+        for (int i = 0; i < ARRAY_SIZE(levels); i++) {
+            brightness_t b = BRIGHTNESS_FROM_LEVEL(levels[i]);
+
+            channel_apply_mix(b);
+            zassert_within(total_ua(), expect_ua(b), TOLERANCE_UA,
+                           "Mode step %d, level %d: %u uA, expected %u", mode, levels[i],
+                           total_ua(), expect_ua(b));
+        }
+        channel_cycle_mode();
+    }
+
+    zassert_equal(limited(), 0);
+}
+
+ZTEST(channel_budget_suite, test_50_50_splits_current_not_duty)
+{
+    channel_apply_mix(BRIGHTNESS_MAX);
+
+    /* 1500 mA each: half the cold emitter, three quarters of the warm */
+    zassert_equal(last_pulse(COLD), PERIOD_NS / 2);
+    zassert_equal(last_pulse(WARM), PERIOD_NS * 3 / 4);
+}
+
+ZTEST(channel_budget_suite, test_emitter_stops_at_its_own_current)
+{
+    cycle_modes(2);   /* Warm */
+    channel_apply_mix(BRIGHTNESS_MAX);
+
+    /* Asked for the 3000 mA full scale, held at its 2000 mA */
+    zassert_equal(last_pulse(WARM), PERIOD_NS);
+    zassert_equal(last_pulse(COLD), 0);
+    zassert_equal(limited(), 0, "Within budget, only the emitter is at its limit");
+}
+
+ZTEST(channel_budget_suite, test_sequential_is_capped_to_budget)
+{
+    cycle_modes(4);   /* Sequential */
+
+    /* Below the budget the emitters stack as before */
+    channel_apply_mix(BRIGHTNESS_FROM_LEVEL(64));
+    zassert_equal(limited(), 0);
+    zassert_equal(last_pulse(WARM), 0);
+
+    /* 3000 + 2000 mA asked, 3000 allowed: both scaled by 3/5 */
+    channel_apply_mix(BRIGHTNESS_MAX);
+    zassert_equal(limited(), 1);
+    zassert_equal(last_pulse(COLD), PERIOD_NS * 3 / 5);
+    zassert_equal(last_pulse(WARM), PERIOD_NS * 3 / 5);
+    zassert_within(total_ua(), FULL_SCALE_UA, TOLERANCE_UA);
+}
+
+ZTEST(channel_budget_suite, test_thermal_caps_instead_of_scaling)
+{
+    brightness_t low = BRIGHTNESS_FROM_LEVEL(100);
+
+    channel_apply_mix(low);
+    uint32_t cool_cold = last_pulse(COLD);
+    uint32_t cool_warm = last_pulse(WARM);
+
+    /* Hot: the budget halves, a level well under it is left alone */
+    throttle_factor = 128;
+    channel_apply_mix(low);
+    zassert_equal(last_pulse(COLD), cool_cold);
+    zassert_equal(last_pulse(WARM), cool_warm);
+    zassert_equal(limited(), 0);
+
+    /* Full power is cut to the budget, still split evenly */
+    channel_apply_mix(BRIGHTNESS_MAX);
+    zassert_equal(limited(), 1);
+    zassert_within(total_ua(), FULL_SCALE_UA / 255 * 128, TOLERANCE_UA);
+    zassert_within(current_ua(COLD), current_ua(WARM), TOLERANCE_UA);
+}
+
+ZTEST(channel_budget_suite, test_supply_sag_derates_budget)
+{
+    /* At the cutoff: an eighth of the budget */
+    channel_set_supply_mv(CONFIG_ZBEAM_VOLTAGE_MIN_MV);
+    channel_apply_mix(BRIGHTNESS_MAX);
+    zassert_within(total_ua(), FULL_SCALE_UA / 255 * 32, TOLERANCE_UA);
+
+    /* Recovers one step per sample, not at once */
+    channel_set_supply_mv(4200);
+    channel_apply_mix(BRIGHTNESS_MAX);
+    zassert_within(total_ua(), FULL_SCALE_UA / 255 * 40, TOLERANCE_UA, "%u uA", total_ua());
+
+    for (int i = 0; i < 30; i++) {
+        channel_set_supply_mv(4200);
+    }
+    channel_apply_mix(BRIGHTNESS_MAX);
+    zassert_within(total_ua(), FULL_SCALE_UA, TOLERANCE_UA);
+
+    /* Halfway down the derating range: halfway down to the floor */
+    channel_set_supply_mv((CONFIG_ZBEAM_CHANNEL_DERATE_MV + CONFIG_ZBEAM_VOLTAGE_MIN_MV) / 2);
+    channel_apply_mix(BRIGHTNESS_MAX);
+    zassert_within(total_ua(), FULL_SCALE_UA / 255 * (32 + (255 - 32) / 2), TOLERANCE_UA,
+                   "%u uA", total_ua());
+}
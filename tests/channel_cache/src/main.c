@@ -0,0 +1,332 @@
+/**
+ * @file main.c
+ * @brief Tests for the output stage pulse cache, PWM write elision and
+ *        staged commits.
+ *
+ * Two emitters on the fake PWM controller: its set_cycles fake counts
+ * the driver calls that actually reach the hardware. The shadow register
+ * hooks are implemented here and log into the same event trace as the
+ * writes, so their order can be checked.
+ */
+
+#include <zephyr/ztest.h>
+#include <zephyr/fff.h>
+#include <zephyr/drivers/pwm/pwm_fake.h>
+#include "channel_manager.h"
+
+DEFINE_FFF_GLOBALS;
+
+#define EMITTERS 2
+#define PERIOD_NS 100000
+
+#define MAX_EVENTS 16
+
+/* Trace entries: a write is its channel number */
+#define EV_HOLD 100
+#define EV_RELEASE 101
+
+static uint8_t throttle_factor;
+static int hold_ret;
+static int events[MAX_EVENTS];
+static int event_count;
+
+/* --- MOCKS --- */
+
+brightness_t thermal_apply_throttle(brightness_t requested_brightness)
+{
+    return ((uint32_t)requested_brightness * throttle_factor) / 255;
+}
+
+static void log_event(int ev)
+{
+    if (event_count < MAX_EVENTS) {
+        events[event_count] = ev;
+    }
+    event_count++;
+}
+
+int channel_sync_hold(const struct device *pwm)
+{
+    log_event(EV_HOLD);
+    return hold_ret;
+}
+
+void channel_sync_release(const struct device *pwm)
+{
+    log_event(EV_RELEASE);
+}
+
+static int traced_set_cycles(const struct device *dev, uint32_t channel, uint32_t period,
+                             uint32_t pulse, pwm_flags_t flags)
+{
+    log_event(channel);
+    return 0;
+}
+
+/* A driver busy long enough for the other thread to stage a new level */
+static int staging_set_cycles(const struct device *dev, uint32_t channel, uint32_t period,
+                              uint32_t pulse, pwm_flags_t flags)
+{
+    if (channel == 0) {
+        channel_stage_mix(BRIGHTNESS_FROM_LEVEL(30));
+    }
+    return 0;
+}
+
+/* --- HELPERS --- */
+
+static struct channel_stats stats(void)
+{
+    struct channel_stats st;
+
+    zassert_ok(channel_get_stats(&st));
+    return st;
+}
+
+static uint32_t last_pulse(uint32_t channel)
+{
+    for (int i = fake_pwm_set_cycles_fake.call_count - 1; i >= 0; i--) {
+        if (i < FFF_ARG_HISTORY_LEN && fake_pwm_set_cycles_fake.arg1_history[i] == channel) {
+            return fake_pwm_set_cycles_fake.arg3_history[i];
+        }
+    }
+    return UINT32_MAX;
+}
+
+/* --- FIXTURE --- */
+
+static void before(void *fixture)
+{
+    channel_init();   /* 50/50, cache and written pulses forgotten */
+    channel_reset_stats();
+    RESET_FAKE(fake_pwm_set_cycles);
+    throttle_factor = 255;
+    hold_ret = 0;
+    event_count = 0;
+}
+
+ZTEST_SUITE(channel_cache_suite, NULL, NULL, before, NULL, NULL);
+
+/* --- TESTS --- */
+
+ZTEST(channel_cache_suite, test_unchanged_level_is_elided)
+{
+    for (int i = 0; i < 10; i++) {
+        channel_apply_mix(BRIGHTNESS_FROM_LEVEL(128));
+    }
+
+    struct channel_stats st = stats();
+
+    zassert_equal(st.applies, 10);
+    zassert_equal(st.recomputes, 1, "Cache recomputed %u times", st.recomputes);
+    zassert_equal(st.writes, EMITTERS, "%u writes", st.writes);
+    zassert_equal(st.elided, 9 * EMITTERS, "%u elided", st.elided);
+    zassert_equal(fake_pwm_set_cycles_fake.call_count, EMITTERS,
+                  "Driver called %u times", fake_pwm_set_cycles_fake.call_count);
+
+    /* Gamma-corrected duty of the period, on both emitters in 50/50 */
+    uint32_t expect = (uint64_t)PERIOD_NS * pwm_ramp_table[128] / RAMP_TABLE_MAX_DUTY;
+
+    zassert_equal(last_pulse(0), expect, "Pulse %u, expected %u", last_pulse(0), expect);
+    zassert_equal(last_pulse(1), expect);
+}
+
+ZTEST(channel_cache_suite, test_level_change_recomputes)
+{
+    channel_apply_mix(BRIGHTNESS_FROM_LEVEL(100));
+    channel_apply_mix(BRIGHTNESS_FROM_LEVEL(100) + 0x80);   /* Half a level up */
+    channel_apply_mix(BRIGHTNESS_FROM_LEVEL(100));
+
+    struct channel_stats st = stats();
+
+    zassert_equal(st.recomputes, 3);
+    zassert_equal(st.writes, 3 * EMITTERS);
+    zassert_equal(st.elided, 0);
+    zassert_true(last_pulse(0) > 0);
+}
+
+ZTEST(channel_cache_suite, test_throttle_change_recomputes)
+{
+    channel_apply_mix(BRIGHTNESS_MAX);
+    uint32_t full = last_pulse(0);
+
+    /* Same request, hotter: the throttled level is a new cache key */
+    throttle_factor = 128;
+    channel_apply_mix(BRIGHTNESS_MAX);
+    channel_apply_mix(BRIGHTNESS_MAX);
+
+    struct channel_stats st = stats();
+
+    zassert_equal(st.recomputes, 2);
+    zassert_equal(st.writes, 2 * EMITTERS);
+    zassert_equal(st.elided, EMITTERS);
+    zassert_true(last_pulse(0) < full, "Throttle did not reach the emitter");
+}
+
+ZTEST(channel_cache_suite, test_mode_change_writes_only_what_changed)
+{
+    channel_apply_mix(BRIGHTNESS_FROM_LEVEL(200));
+    uint32_t on = last_pulse(0);
+
+    /* 50/50 -> cold only: emitter 0 keeps its pulse, emitter 1 goes dark */
+    channel_cycle_mode();
+    channel_apply_mix(BRIGHTNESS_FROM_LEVEL(200));
+
+    struct channel_stats st = stats();
+
+    zassert_equal(st.recomputes, 2);
+    zassert_equal(st.writes, EMITTERS + 1);
+    zassert_equal(st.elided, 1);
+    zassert_equal(last_pulse(0), on);
+    zassert_equal(last_pulse(1), 0);
+}
+
+ZTEST(channel_cache_suite, test_failed_write_is_retried)
+{
+    fake_pwm_set_cycles_fake.return_val = -EIO;
+    channel_apply_mix(BRIGHTNESS_FROM_LEVEL(50));
+
+    fake_pwm_set_cycles_fake.return_val = 0;
+    channel_apply_mix(BRIGHTNESS_FROM_LEVEL(50));
+    channel_apply_mix(BRIGHTNESS_FROM_LEVEL(50));
+
+    struct channel_stats st = stats();
+
+    /* The failed pair is not trusted, the retried pair is */
+    zassert_equal(st.recomputes, 1);
+    zassert_equal(st.writes, 2 * EMITTERS);
+    zassert_equal(st.elided, EMITTERS);
+    zassert_equal(fake_pwm_set_cycles_fake.call_count, 2 * EMITTERS);
+}
+
+ZTEST(channel_cache_suite, test_reset_stats)
+{
+    zassert_false(channel_budget_enabled(), "No emitter currents, no budget");
+
+    channel_apply_mix(BRIGHTNESS_FROM_LEVEL(10));
+    channel_reset_stats();
+
+    struct channel_stats st = stats();
+
+    zassert_equal(st.applies, 0);
+    zassert_equal(st.writes, 0);
+    zassert_equal(channel_get_stats(NULL), -EINVAL);
+}
+
+ZTEST(channel_cache_suite, test_stage_defers_writes)
+{
+    channel_stage_mix(BRIGHTNESS_FROM_LEVEL(180));
+    zassert_equal(fake_pwm_set_cycles_fake.call_count, 0, "Stage touched the hardware");
+
+    /* Only the latest stage is committed */
+    channel_stage_mix(BRIGHTNESS_FROM_LEVEL(90));
+    zassert_ok(channel_commit());
+    zassert_ok(channel_commit());
+
+    struct channel_stats st = stats();
+    uint32_t expect = (uint64_t)PERIOD_NS * pwm_ramp_table[90] / RAMP_TABLE_MAX_DUTY;
+
+    zassert_equal(st.applies, 2);
+    zassert_equal(st.commits, 1, "%u commits wrote", st.commits);
+    zassert_equal(st.writes, EMITTERS);
+    zassert_equal(st.elided, EMITTERS);
+    zassert_equal(last_pulse(0), expect);
+    zassert_equal(last_pulse(1), expect);
+}
+
+ZTEST(channel_cache_suite, test_commit_reports_write_error)
+{
+    zassert_ok(channel_commit(), "Nothing staged, nothing to fail");
+    zassert_equal(fake_pwm_set_cycles_fake.call_count, 0);
+
+    channel_stage_mix(BRIGHTNESS_FROM_LEVEL(40));
+    fake_pwm_set_cycles_fake.return_val = -EIO;
+    zassert_equal(channel_commit(), -EIO);
+
+    /* Both emitters were still attempted */
+    zassert_equal(fake_pwm_set_cycles_fake.call_count, EMITTERS);
+}
+
+ZTEST(channel_cache_suite, test_stage_during_driver_call)
+{
+    /* The driver runs without the cache lock: staging from it must not block */
+    fake_pwm_set_cycles_fake.custom_fake = staging_set_cycles;
+    channel_apply_mix(BRIGHTNESS_FROM_LEVEL(160));
+
+    uint32_t expect = (uint64_t)PERIOD_NS * pwm_ramp_table[160] / RAMP_TABLE_MAX_DUTY;
+
+    /* That commit finished on its own snapshot... */
+    zassert_equal(last_pulse(0), expect);
+    zassert_equal(last_pulse(1), expect);
+
+    /* ...and the level staged meanwhile goes out with the next one */
+    fake_pwm_set_cycles_fake.custom_fake = NULL;
+    zassert_ok(channel_commit());
+    expect = (uint64_t)PERIOD_NS * pwm_ramp_table[30] / RAMP_TABLE_MAX_DUTY;
+    zassert_equal(last_pulse(0), expect);
+    zassert_equal(last_pulse(1), expect);
+}
+
+ZTEST(channel_cache_suite, test_unheld_commit_dims_first)
+{
+    /* No hold (or none in this build): write order is all that is left */
+    int first = IS_ENABLED(CONFIG_ZBEAM_CHANNEL_SYNC_HOLD) ? 1 : 0;
+
+    hold_ret = -ENOTSUP;
+    channel_apply_mix(BRIGHTNESS_FROM_LEVEL(200));
+
+    /* 50/50 -> cold at a higher level: cold rises, warm goes dark */
+    channel_cycle_mode();
+    fake_pwm_set_cycles_fake.custom_fake = traced_set_cycles;
+    event_count = 0;
+    channel_apply_mix(BRIGHTNESS_FROM_LEVEL(230));
+
+    zassert_equal(event_count, first + 2, "%d events", event_count);
+    zassert_equal(events[first], 1, "Dimming emitter not written first");
+    zassert_equal(events[first + 1], 0);
+}
+
+#ifdef CONFIG_ZBEAM_CHANNEL_SYNC_HOLD
+ZTEST(channel_cache_suite, test_commit_is_held_per_controller)
+{
+    fake_pwm_set_cycles_fake.custom_fake = traced_set_cycles;
+
+    channel_apply_mix(BRIGHTNESS_FROM_LEVEL(150));
+
+    /* Both channels between one hold and its release */
+    zassert_equal(event_count, 4, "%d events", event_count);
+    zassert_equal(events[0], EV_HOLD);
+    zassert_equal(events[1], 0);
+    zassert_equal(events[2], 1);
+    zassert_equal(events[3], EV_RELEASE);
+
+    /* Nothing changed: no hold either */
+    event_count = 0;
+    channel_apply_mix(BRIGHTNESS_FROM_LEVEL(150));
+    zassert_equal(event_count, 0, "Elided commit held the controller");
+
+    /* Cold only: emitter 1 changes alone, still held */
+    channel_cycle_mode();
+    channel_apply_mix(BRIGHTNESS_FROM_LEVEL(150));
+    zassert_equal(event_count, 3);
+    zassert_equal(events[0], EV_HOLD);
+    zassert_equal(events[1], 1);
+    zassert_equal(events[2], EV_RELEASE);
+}
+
+ZTEST(channel_cache_suite, test_hold_failure_falls_back)
+{
+    fake_pwm_set_cycles_fake.custom_fake = traced_set_cycles;
+    hold_ret = -ENOTSUP;
+
+    zassert_ok(channel_commit());
+    channel_apply_mix(BRIGHTNESS_FROM_LEVEL(70));
+
+    /* Written anyway, and nothing released that was not held */
+    zassert_equal(event_count, 3, "%d events", event_count);
+    zassert_equal(events[0], EV_HOLD);
+    zassert_equal(events[1], 0);
+    zassert_equal(events[2], 1);
+    zassert_equal(stats().writes, EMITTERS);
+}
+#endif /* CONFIG_ZBEAM_CHANNEL_SYNC_HOLD */
@@ -0,0 +1,156 @@
+/**
+ * @file main.c
+ * @brief Tests for the compile-time mixer built from the emitter group.
+ *
+ * dual.overlay lists the warm emitter (gamma 2.2) before the cold one
+ * (gamma 2.8), so each mode must pick emitters by role and scale them
+ * through their own table. single.overlay checks that a one-emitter
+ * group lights it fully in every mode.
+ */
+
+#include <zephyr/ztest.h>
+#include <zephyr/fff.h>
+#include <zephyr/drivers/pwm/pwm_fake.h>
+#include "channel_manager.h"
+
+DEFINE_FFF_GLOBALS;
+
+#define EMITTERS DT_CHILD_NUM(DT_COMPAT_GET_ANY_STATUS_OKAY(zanduril_emitter_group))
+#define PERIOD_NS 100000
+
+/* dual.overlay channels */
+#define WARM 0
+#define COLD 1
+
+/* --- MOCKS --- */
+
+brightness_t thermal_apply_throttle(brightness_t requested_brightness)
+{
+    return requested_brightness;
+}
+
+/* --- HELPERS --- */
+
+static uint32_t last_pulse(uint32_t channel)
+{
+    for (int i = fake_pwm_set_cycles_fake.call_count - 1; i >= 0; i--) {
+        if (i < FFF_ARG_HISTORY_LEN && fake_pwm_set_cycles_fake.arg1_history[i] == channel) {
+            return fake_pwm_set_cycles_fake.arg3_history[i];
+        }
+    }
+    return UINT32_MAX;
+}
+
+/* Pulse for @p b through @p table at @p weight / 255 */
+static uint32_t expect_pulse(const uint16_t *table, brightness_t b, uint32_t weight)
+{
+    uint32_t level = brightness_to_duty_table(table, b) * weight / 255;
+
+    return (uint64_t)PERIOD_NS * level / RAMP_TABLE_MAX_DUTY;
+}
+
+/* From the 50/50 start, step @p n modes along */
+static void cycle_modes(int n)
+{
+    while (n-- > 0) {
+        channel_cycle_mode();
+    }
+}
+
+/* --- FIXTURE --- */
+
+static void before(void *fixture)
+{
+    channel_init();
+    RESET_FAKE(fake_pwm_set_cycles);
+}
+
+ZTEST_SUITE(channel_mixer_suite, NULL, NULL, before, NULL, NULL);
+
+/* --- TESTS --- */
+
+#if EMITTERS == 2
+
+ZTEST(channel_mixer_suite, test_50_50_uses_each_table)
+{
+    brightness_t b = BRIGHTNESS_FROM_LEVEL(120);
+
+    channel_apply_mix(b);
+
+    zassert_equal(last_pulse(WARM), expect_pulse(RAMP_TABLE_GAMMA(g22), b, 255));
+    zassert_equal(last_pulse(COLD), expect_pulse(RAMP_TABLE_GAMMA(g28), b, 255));
+    zassert_true(last_pulse(WARM) > last_pulse(COLD), "Gamma 2.2 should be brighter mid-ramp");
+}
+
+ZTEST(channel_mixer_suite, test_cold_and_warm_follow_roles)
+{
+    brightness_t b = BRIGHTNESS_FROM_LEVEL(150);
+
+    cycle_modes(1);   /* Cold */
+    channel_apply_mix(b);
+    zassert_equal(last_pulse(COLD), expect_pulse(RAMP_TABLE_GAMMA(g28), b, 255));
+    zassert_equal(last_pulse(WARM), 0);
+
+    cycle_modes(1);   /* Warm */
+    channel_apply_mix(b);
+    zassert_equal(last_pulse(WARM), expect_pulse(RAMP_TABLE_GAMMA(g22), b, 255));
+    zassert_equal(last_pulse(COLD), 0);
+}
+
+ZTEST(channel_mixer_suite, test_auto_tint_shifts_warm_to_cold)
+{
+    brightness_t b = BRIGHTNESS_FROM_LEVEL(64);
+
+    cycle_modes(3);   /* Auto-tint */
+    channel_apply_mix(b);
+
+    zassert_equal(last_pulse(COLD), expect_pulse(RAMP_TABLE_GAMMA(g28), b, 64));
+    zassert_equal(last_pulse(WARM), expect_pulse(RAMP_TABLE_GAMMA(g22), b, 255 - 64));
+}
+
+ZTEST(channel_mixer_suite, test_sequential_slices_by_order)
+{
+    /* A quarter of the ramp is half of the first slice */
+    brightness_t b = BRIGHTNESS_FROM_LEVEL(64);
+    uint32_t weight = (uint32_t)b * 255 / (BRIGHTNESS_MAX / 2);
+
+    cycle_modes(4);   /* Sequential */
+    channel_apply_mix(b);
+
+    zassert_equal(last_pulse(0), expect_pulse(RAMP_TABLE_GAMMA(g22), b, weight));
+    zassert_equal(last_pulse(1), 0);
+
+    channel_apply_mix(BRIGHTNESS_MAX);
+    zassert_equal(last_pulse(0), PERIOD_NS);
+    zassert_equal(last_pulse(1), PERIOD_NS);
+}
+
+ZTEST(channel_mixer_suite, test_single_lights_first_emitter)
+{
+    brightness_t b = BRIGHTNESS_FROM_LEVEL(200);
+
+    cycle_modes(5);   /* Single */
+    channel_apply_mix(b);
+
+    zassert_equal(last_pulse(0), expect_pulse(RAMP_TABLE_GAMMA(g22), b, 255));
+    zassert_equal(last_pulse(1), 0);
+}
+
+#else /* One emitter */
+
+ZTEST(channel_mixer_suite, test_single_emitter_every_mode)
+{
+    brightness_t b = BRIGHTNESS_FROM_LEVEL(90);
+    uint32_t full = expect_pulse(RAMP_TABLE_GAMMA(g28), b, 255);
+
+    for (int mode = 0; mode < CHANNEL_MODE_COUNT; mode++) {
+        channel_apply_mix(b);
+        zassert_equal(last_pulse(0), full, "Mode step %d: pulse %u", mode, last_pulse(0));
+        channel_cycle_mode();
+    }
+
+    /* One write, the rest elided */
+    zassert_equal(fake_pwm_set_cycles_fake.call_count, 1);
+}
+
+#endif /* EMITTERS */
@@ -0,0 +1,210 @@
+/**
+ * @file main.c
+ * @brief Battery current model for in-phase vs staggered emitters.
+ *
+ * Two emitters on the fake PWM controller. The set_cycles fake keeps the
+ * last pulse and polarity of each channel; the model rebuilds one PWM
+ * period of the outputs from them, sums a fixed LED current for every
+ * emitter that is on, and reports the RMS battery current. The same
+ * on-times, all start-aligned, give the in-phase reference.
+ */
+
+#include <zephyr/ztest.h>
+#include <zephyr/fff.h>
+#include <zephyr/drivers/pwm/pwm_fake.h>
+#include "channel_manager.h"
+
+DEFINE_FFF_GLOBALS;
+
+#define EMITTERS 2
+#define PERIOD_NS 100000
+#define STEP_NS 10
+#define LED_CURRENT_MA 3000
+
+struct output {
+    uint32_t pulse;
+    pwm_flags_t flags;
+};
+
+static struct output outputs[EMITTERS];
+static bool reject_inverted;
+
+/* --- MOCKS --- */
+
+brightness_t thermal_apply_throttle(brightness_t requested_brightness)
+{
+    return requested_brightness;
+}
+
+static int capture_set_cycles(const struct device *dev, uint32_t channel, uint32_t period,
+                              uint32_t pulse, pwm_flags_t flags)
+{
+    if (reject_inverted && (flags & PWM_POLARITY_INVERTED)) {
+        return -ENOTSUP;
+    }
+    outputs[channel] = (struct output){.pulse = pulse, .flags = flags};
+    return 0;
+}
+
+/* --- MODEL --- */
+
+/* Whether emitter @p ch is lit at @p t ns into the period */
+static bool lit(int ch, uint32_t t)
+{
+    bool in_pulse = t < outputs[ch].pulse;
+
+    return (outputs[ch].flags & PWM_POLARITY_INVERTED) ? !in_pulse : in_pulse;
+}
+
+/* Time emitter @p ch is lit per period, wherever it falls */
+static uint32_t on_time(int ch)
+{
+    uint32_t pulse = outputs[ch].pulse;
+
+    return (outputs[ch].flags & PWM_POLARITY_INVERTED) ? PERIOD_NS - pulse : pulse;
+}
+
+static uint32_t isqrt(uint64_t x)
+{
+    uint64_t r = 0;
+
+    for (uint64_t bit = 1ULL << 62; bit != 0; bit >>= 2) {
+        if (x >= r + bit) {
+            x -= r + bit;
+            r = (r >> 1) + bit;
+        } else {
+            r >>= 1;
+        }
+    }
+    return (uint32_t)r;
+}
+
+/*
+ * RMS battery current (mA) over one period, from the programmed outputs
+ * or, with @p in_phase, from the same on-times all starting together.
+ */
+static uint32_t battery_rms_ma(bool in_phase, uint32_t *peak_ma)
+{
+    uint64_t sum_sq = 0;
+    uint32_t peak = 0;
+
+    for (uint32_t t = 0; t < PERIOD_NS; t += STEP_NS) {
+        uint32_t ma = 0;
+
+        for (int ch = 0; ch < EMITTERS; ch++) {
+            if (in_phase ? t < on_time(ch) : lit(ch, t)) {
+                ma += LED_CURRENT_MA;
+            }
+        }
+        sum_sq += (uint64_t)ma * ma;
+        peak = MAX(peak, ma);
+    }
+    if (peak_ma != NULL) {
+        *peak_ma = peak;
+    }
+    return isqrt(sum_sq / (PERIOD_NS / STEP_NS));
+}
+
+/* Highest level whose duty is at most half the period */
+static uint8_t half_duty_level(void)
+{
+    uint8_t level = 0;
+
+    while (level < 255 && pwm_ramp_table[level + 1] * 2 <= RAMP_TABLE_MAX_DUTY) {
+        level++;
+    }
+    return level;
+}
+
+/* --- FIXTURE --- */
+
+static void before(void *fixture)
+{
+    channel_init();   /* 50/50 */
+    RESET_FAKE(fake_pwm_set_cycles);
+    fake_pwm_set_cycles_fake.custom_fake = capture_set_cycles;
+    memset(outputs, 0, sizeof(outputs));
+    reject_inverted = false;
+}
+
+ZTEST_SUITE(channel_phase_suite, NULL, NULL, before, NULL, NULL);
+
+/* --- TESTS --- */
+
+ZTEST(channel_phase_suite, test_rms_at_half_duty)
+{
+    uint8_t level = half_duty_level();
+    uint32_t peak, peak_ref;
+
+    channel_apply_mix(BRIGHTNESS_FROM_LEVEL(level));
+
+    uint32_t rms = battery_rms_ma(false, &peak);
+    uint32_t rms_ref = battery_rms_ma(true, &peak_ref);
+
+    TC_PRINT("Level %d, %d%% duty per emitter: in phase %u mA RMS (%u peak), "
+             "programmed %u mA RMS (%u peak)\n",
+             level, on_time(0) * 100 / PERIOD_NS, rms_ref, peak_ref, rms, peak);
+
+    /* Light output is unchanged whichever way the on-times are placed */
+    zassert_equal(on_time(0), on_time(1));
+    zassert_equal(peak_ref, EMITTERS * LED_CURRENT_MA);
+
+#ifdef CONFIG_ZBEAM_CHANNEL_PHASE_STAGGER
+    /* Interleaved: one emitter at a time, ~1/sqrt(2) of the in-phase RMS */
+    zassert_equal(peak, LED_CURRENT_MA, "On-times overlap (peak %u mA)", peak);
+    zassert_true(rms * 10 < rms_ref * 8, "RMS %u not below %u", rms, rms_ref);
+#else
+    zassert_equal(rms, rms_ref);
+    zassert_equal(peak, peak_ref);
+#endif
+}
+
+ZTEST(channel_phase_suite, test_full_power_is_unchanged)
+{
+    channel_apply_mix(BRIGHTNESS_MAX);
+
+    /* Both emitters on for the whole period: nothing left to interleave */
+    zassert_equal(on_time(0), PERIOD_NS);
+    zassert_equal(on_time(1), PERIOD_NS);
+    zassert_equal(battery_rms_ma(false, NULL), battery_rms_ma(true, NULL));
+}
+
+ZTEST(channel_phase_suite, test_staggered_on_time_matches_mix)
+{
+    uint32_t expect = (uint64_t)PERIOD_NS * pwm_ramp_table[60] / RAMP_TABLE_MAX_DUTY;
+
+    channel_apply_mix(BRIGHTNESS_FROM_LEVEL(60));
+
+    zassert_equal(on_time(0), expect);
+    zassert_equal(on_time(1), expect, "Emitter 1 lit %u ns, expected %u", on_time(1), expect);
+    zassert_true(lit(0, 0), "Emitter 0 should start the period");
+#ifdef CONFIG_ZBEAM_CHANNEL_PHASE_STAGGER
+    zassert_false(lit(1, 0), "Emitter 1 should be end-aligned");
+    zassert_true(lit(1, PERIOD_NS - 1));
+#else
+    zassert_true(lit(1, 0));
+#endif
+
+    /* Off means off, inverted or not */
+    channel_apply_mix(0);
+    zassert_equal(on_time(0), 0);
+    zassert_equal(on_time(1), 0);
+}
+
+#ifdef CONFIG_ZBEAM_CHANNEL_PHASE_STAGGER
+ZTEST(channel_phase_suite, test_unsupported_polarity_runs_in_phase)
+{
+    reject_inverted = true;
+    channel_apply_mix(BRIGHTNESS_FROM_LEVEL(100));
+
+    /* Rejected once, then written (and kept) start-aligned */
+    zassert_equal(fake_pwm_set_cycles_fake.call_count, EMITTERS + 1);
+    zassert_true(lit(1, 0));
+    zassert_equal(on_time(1), on_time(0));
+
+    channel_apply_mix(BRIGHTNESS_FROM_LEVEL(110));
+    zassert_equal(fake_pwm_set_cycles_fake.call_count, 2 * EMITTERS + 1,
+                  "Inverted polarity retried");
+    zassert_equal(battery_rms_ma(false, NULL), battery_rms_ma(true, NULL));
+}
+#endif /* CONFIG_ZBEAM_CHANNEL_PHASE_STAGGER */
@@ -5,6 +5,7 @@
 
 #include <zephyr/ztest.h>
 #include "fsm_engine.h"
+#include "fsm_trace.h"
 #include "zbeam_msg.h"
 
 /* --- Mock Nodes & Routines --- */
@@ -16,44 +17,102 @@ static int click_callback_count = 0;
 static void routine_a(void) { node_a_action_count++; }
 static void routine_b(void) { node_b_action_count++; }
 
-/* Forward decls */
-extern struct fsm_node node_a;
-extern struct fsm_node node_b;
-extern struct fsm_node node_off; // Satisfy extern in fsm_engine.c
+/* Node / callback IDs for the test table (0 is FSM_NONE) */
+enum { TN_NONE, TN_A, TN_B, TN_OFF, TN_MOMENTARY, TN_DUAL, TN_COUNT };
+enum { TCB_NONE, TCB_GOTO_B, TCB_STAY, TCB_ENCODER, TCB_COUNT };
 
-static struct fsm_node *cb_goto_b(struct fsm_node *curr, int count) {
+extern const struct fsm_node node_a;
+extern const struct fsm_node node_b;
+extern const struct fsm_node node_off;
+
+static const struct fsm_node *cb_goto_b(const struct fsm_node *curr, int count) {
     click_callback_count++;
     return &node_b;
 }
 
-static struct fsm_node *cb_stay(struct fsm_node *curr, int count) {
+static const struct fsm_node *cb_stay(const struct fsm_node *curr, int count) {
     click_callback_count++;
     return NULL;
 }
 
-struct fsm_node node_a = {
-    .id = 1, .name = "A",
+static int encoder_total;
+
+static const struct fsm_node *cb_encoder(const struct fsm_node *curr, int count) {
+    encoder_total += count;
+    return NULL;
+}
+
+const struct fsm_node node_a = {
+    .id = TN_A, .name = "A",
     .action_routine = routine_a,
-    .click_map = {
-        [0] = &node_b, /* 1C -> B */
-    },
-    .hold_map = {
-        [0] = &node_b, /* 1H -> B */
-    },
-    .click_callbacks = {
-        [1] = cb_goto_b, /* 2C callback -> B */
-        [2] = cb_stay,   /* 3C callback -> Stay (intercept) */
-    }
+    FSM_CLICKS(
+        [0] = FSM_GOTO(TN_B),      /* 1C -> B */
+        [1] = FSM_CALL(TCB_GOTO_B), /* 2C callback -> B */
+        [2] = FSM_CALL(TCB_STAY),   /* 3C callback -> Stay (intercept) */
+    ),
+    FSM_HOLDS(
+        [0] = FSM_GOTO(TN_B),      /* 1H -> B */
+    ),
 };
 
-struct fsm_node node_b = {
-    .id = 2, .name = "B",
+const struct fsm_node node_b = {
+    .id = TN_B, .name = "B",
     .action_routine = routine_b,
 };
 
-/* Real definition of node_off to satisfy fsm_engine.c extern */
-struct fsm_node node_off = {
-    .id = 0, .name = "OFF",
+/* Lit straight from the input edge while current */
+const struct fsm_node node_momentary = {
+    .id = TN_MOMENTARY, .name = "MOM",
+    .flags = FSM_NODE_MOMENTARY,
+};
+
+/* Main 1C -> B; tail 2C -> OFF; side unmapped; encoder callback */
+const struct fsm_node node_dual = {
+    .id = TN_DUAL, .name = "DUAL",
+    FSM_CLICKS(
+        [0] = FSM_GOTO(TN_B),
+    ),
+    FSM_INPUTS(
+        { .source = INPUT_SRC_TAIL, FSM_CLICKS([1] = FSM_GOTO(TN_OFF)) },
+    ),
+    .encoder_callback = TCB_ENCODER,
+};
+
+/* Home node for emergency off */
+const struct fsm_node node_off = {
+    .id = TN_OFF, .name = "OFF",
+};
+
+static const struct fsm_node *const test_nodes[TN_COUNT] = {
+    [TN_A] = &node_a,
+    [TN_B] = &node_b,
+    [TN_OFF] = &node_off,
+    [TN_MOMENTARY] = &node_momentary,
+    [TN_DUAL] = &node_dual,
+};
+
+static const fsm_callback_t test_callbacks[TCB_COUNT] = {
+    [TCB_GOTO_B] = cb_goto_b,
+    [TCB_STAY] = cb_stay,
+    [TCB_ENCODER] = cb_encoder,
+};
+
+static const struct fsm_table test_table = {
+    .nodes = test_nodes,
+    .callbacks = test_callbacks,
+    .node_count = TN_COUNT,
+    .callback_count = TCB_COUNT,
+};
+
+static int momentary_arms;
+static int momentary_presses;
+
+static void mock_momentary_arm(const struct fsm_node *node) { momentary_arms++; }
+static void mock_momentary_edge(bool pressed) { momentary_presses += pressed ? 1 : -1; }
+
+static const struct fsm_momentary mock_momentary = {
+    .arm = mock_momentary_arm,
+    .edge = mock_momentary_edge,
 };
 
 /* --- Test Setup --- */
@@ -63,7 +122,11 @@ static void before(void *fixture)
     node_a_action_count = 0;
     node_b_action_count = 0;
     click_callback_count = 0;
-    fsm_init(&node_a);
+    encoder_total = 0;
+    momentary_arms = 0;
+    momentary_presses = 0;
+    fsm_set_momentary(&mock_momentary);
+    fsm_init(&test_table, &node_a);
 }
 
 ZTEST_SUITE(fsm_core_suite, NULL, NULL, before, NULL, NULL);
@@ -119,6 +182,99 @@ ZTEST(fsm_core_suite, test_callback_intercept)
     zassert_equal(fsm_get_current_node(), &node_a, "Should stay in A");
 }
 
+ZTEST(fsm_core_suite, test_count_beyond_table)
+{
+    /* A's click table is packed to 3 slots; 5C must be ignored safely */
+    struct zbeam_msg msg = { .type = MSG_INPUT_TAP, .count = 5 };
+    fsm_process_msg(&msg);
+
+    zassert_equal(click_callback_count, 0, "No callback should fire");
+    zassert_equal(fsm_get_current_node(), &node_a, "Should stay in A");
+}
+
+ZTEST(fsm_core_suite, test_input_can_continue)
+{
+    /* A maps 1C-3C and 1H */
+    zassert_true(fsm_input_can_continue(INPUT_SRC_MAIN, 1), "2C/3C still reachable");
+    zassert_true(fsm_input_can_continue(INPUT_SRC_MAIN, 2), "3C still reachable");
+    zassert_false(fsm_input_can_continue(INPUT_SRC_MAIN, 3), "Nothing beyond 3C or 1H");
+
+    /* B maps nothing: every tap can be committed at once */
+    fsm_transition_to(&node_b);
+    zassert_false(fsm_input_can_continue(INPUT_SRC_MAIN, 1), "B has no mappings");
+
+    /* Other sources only look at their own map */
+    fsm_transition_to(&node_dual);
+    zassert_true(fsm_input_can_continue(INPUT_SRC_TAIL, 1), "Tail 2C still reachable");
+    zassert_false(fsm_input_can_continue(INPUT_SRC_TAIL, 2), "Nothing beyond tail 2C");
+    zassert_false(fsm_input_can_continue(INPUT_SRC_SIDE, 1), "Side is not mapped");
+}
+
+ZTEST(fsm_core_suite, test_input_sources)
+{
+    struct zbeam_msg msg = { .type = MSG_INPUT_TAP, .count = 2, .source = INPUT_SRC_MAIN };
+
+    /* Main 2C is unmapped on DUAL; tail 2C is */
+    fsm_transition_to(&node_dual);
+    fsm_process_msg(&msg);
+    zassert_equal(fsm_get_current_node(), &node_dual, "Main 2C must not use the tail map");
+
+    msg.source = INPUT_SRC_SIDE;
+    fsm_process_msg(&msg);
+    zassert_equal(fsm_get_current_node(), &node_dual, "Unmapped source must be ignored");
+
+    msg.source = INPUT_SRC_TAIL;
+    fsm_process_msg(&msg);
+    zassert_equal(fsm_get_current_node(), &node_off, "Tail 2C should go to OFF");
+
+    /* A tail tap on a node without a tail map does nothing */
+    fsm_transition_to(&node_a);
+    msg.count = 1;
+    fsm_process_msg(&msg);
+    zassert_equal(fsm_get_current_node(), &node_a, "A has no tail map");
+}
+
+ZTEST(fsm_core_suite, test_encoder_callback)
+{
+    struct zbeam_msg msg = { .type = MSG_INPUT_ENCODER, .source = INPUT_SRC_ENCODER };
+
+    msg.count = (uint8_t)(int8_t)-3;
+    fsm_process_msg(&msg);
+    zassert_equal(encoder_total, 0, "A maps no encoder callback");
+
+    fsm_transition_to(&node_dual);
+    fsm_process_msg(&msg);
+    zassert_equal(encoder_total, -3, "Delta must arrive signed");
+    msg.count = 5;
+    fsm_process_msg(&msg);
+    zassert_equal(encoder_total, 2, "Detents not accumulated");
+}
+
+ZTEST(fsm_core_suite, test_momentary_fast_path)
+{
+    /* Not armed on a plain node */
+    fsm_momentary_edge(true);
+    zassert_equal(momentary_presses, 0, "Fast path must be idle outside momentary nodes");
+
+    fsm_transition_to(&node_momentary);
+    zassert_equal(momentary_arms, 1, "Entering a momentary node arms the fast path");
+    fsm_momentary_edge(true);
+    zassert_equal(momentary_presses, 1, "Key-down not forwarded");
+    fsm_momentary_edge(false);
+    zassert_equal(momentary_presses, 0, "Key-up not forwarded");
+
+    /* Leaving disarms */
+    fsm_transition_to(&node_b);
+    fsm_momentary_edge(true);
+    zassert_equal(momentary_presses, 0, "Fast path still armed after leaving");
+
+    /* So does emergency off */
+    fsm_transition_to(&node_momentary);
+    fsm_emergency_off();
+    fsm_momentary_edge(true);
+    zassert_equal(momentary_presses, 0, "Fast path still armed after emergency off");
+}
+
 ZTEST(fsm_core_suite, test_emergency_off)
 {
     fsm_transition_to(&node_a);
@@ -126,6 +282,47 @@ ZTEST(fsm_core_suite, test_emergency_off)
     zassert_equal(fsm_get_current_node(), &node_off, "Emergency off should go to OFF node");
 }
 
+ZTEST(fsm_core_suite, test_trace_records_events)
+{
+    struct fsm_trace_entry e[4];
+
+    fsm_trace_clear();
+    struct zbeam_msg msg = { .type = MSG_INPUT_TAP, .count = 1 };
+    fsm_process_msg(&msg);
+
+    zassert_equal(fsm_trace_read(e, ARRAY_SIZE(e)), 2, "Expected TAP + TRANSITION");
+    zassert_equal(e[0].event, FSM_TRACE_TAP, "First entry should be the tap");
+    zassert_equal(e[0].from, TN_A, "Tap should be recorded on A");
+    zassert_equal(e[0].count, 1, "Tap count mismatch");
+    zassert_equal(e[1].event, FSM_TRACE_TRANSITION, "Second entry should be the transition");
+    zassert_equal(e[1].from, TN_A, "Transition source mismatch");
+    zassert_equal(e[1].to, TN_B, "Transition target mismatch");
+    zassert_true(e[1].uptime_ms >= e[0].uptime_ms, "Timestamps must not go backwards");
+}
+
+ZTEST(fsm_core_suite, test_trace_wraps)
+{
+    static struct fsm_trace_entry e[CONFIG_ZBEAM_FSM_TRACE_DEPTH];
+    int extra = 3;
+
+    fsm_trace_clear();
+    for (int i = 0; i < CONFIG_ZBEAM_FSM_TRACE_DEPTH + extra; i++) {
+        fsm_trace_record(FSM_TRACE_TAP, TN_A, FSM_NONE, (uint8_t)i);
+    }
+
+    zassert_equal(fsm_trace_read(e, ARRAY_SIZE(e)), CONFIG_ZBEAM_FSM_TRACE_DEPTH, "Ring should be full");
+    zassert_equal(fsm_trace_overwritten(), extra, "Overwrite count mismatch");
+    zassert_equal(e[0].count, extra, "Oldest surviving entry mismatch");
+    zassert_equal(e[CONFIG_ZBEAM_FSM_TRACE_DEPTH - 1].count, CONFIG_ZBEAM_FSM_TRACE_DEPTH + extra - 1,
+                  "Newest entry mismatch");
+
+    /* Short reader keeps the newest entries */
+    zassert_equal(fsm_trace_read(e, 2), 2, "Short read");
+    zassert_equal(e[1].count, CONFIG_ZBEAM_FSM_TRACE_DEPTH + extra - 1, "Short read should end at newest");
+
+    fsm_trace_dump();
+}
+
 void test_main(void)
 {
     ztest_run_test_suites(NULL, false, 1, 1);
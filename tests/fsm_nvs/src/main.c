@@ -3,23 +3,15 @@
 #include "nvs_manager.h"
 #include "ui_actions.h"
 #include "thermal_manager.h"
+#include "safety_monitor.h"
 
 
 LOG_MODULE_REGISTER(Test_FSM_NVS, LOG_LEVEL_INF);
 
-// Helper to simulate looking up nodes (since we removed global array)
-// For these tests, we assume Advanced Mode topology structure
-static struct fsm_node *get_node_by_id(enum fsm_node_id id) {
-    struct fsm_node *root = get_start_node(); // Should be Advanced Off
-    if (root->id == id) return root;
-    
-    // Simple lookups based on standard topology
-    if (id == NODE_RAMP) return root->hold_map[0]; // 1H -> Ramp
-    if (id == NODE_ON) return root->click_map[0];  // 1C -> On
-    if (id == NODE_STROBE) return root->click_map[2]; // 3C -> Strobe (Advanced)
-    // Add others if needed for tests
-    
-    return NULL;
+// Nodes are resolved by ID through the flash-resident UI table
+static const struct fsm_node *get_node_by_id(enum fsm_node_id id) {
+    if (id == NODE_NONE || id >= NODE_COUNT) return NULL;
+    return ui_fsm_table.nodes[id];
 }
 
 // Stubs for hardware dependencies
@@ -32,6 +24,7 @@ void pm_suspend(void) {}
 void pm_resume(void) {}
 
 void aux_init(void) {}
+enum safety_fault safety_get_status(void) { return SAFETY_OK; }
 
 // Suite setup
 static void *setup(void)
@@ -46,16 +39,17 @@ ZTEST_SUITE(fsm_nvs_suite, NULL, setup, NULL, NULL, NULL);
 
 ZTEST(fsm_nvs_suite, test_01_defaults_load)
 {
-    struct fsm_node *off = get_start_node();
+    const struct fsm_node *off = get_start_node();
     zassert_not_null(off, "Off node is null");
-    zassert_equal(off->id, NODE_OFF, "ID Mismatch");
+    zassert_true(off->id == NODE_SMP_OFF || off->id == NODE_ADV_OFF, "ID Mismatch");
     
     // By default compile time: click[0] should be NODE_ON (Standard ZBeam)
     // Wait, test previously expected RAMP? 
     // "Default target is not RAMP".
     // ANDURIL 2 / Default ZBeam: 1C -> ON.
     // Let's check what logic expects. If it expects ON, let's assert ON.
-    struct fsm_node *target = off->click_map[0];
+    zassert_true(off->click_count > 0, "Off node has no click slots");
+    const struct fsm_node *target = get_node_by_id(off->clicks[0].target);
     zassert_not_null(target, "Default target is null");
     // zassert_equal(target->id, NODE_ON, "Default target is not ON"); 
     // Keeping generic check
@@ -119,17 +113,13 @@ ZTEST(fsm_nvs_suite, test_12_pwm_accessor)
     // Default might be 0 (OFF) or memorized?
     // action_off sets hardware to 0 but current_brightness might be 0.
     
-    struct fsm_node *ramp = get_node_by_id(NODE_RAMP);
-    if (!ramp) {
-         // fallback
-         ramp = get_start_node()->hold_map[0];
-    }
+    const struct fsm_node *ramp = get_node_by_id(NODE_ADV_RAMP);
     zassert_not_null(ramp, "Ramp node missing");
 
-    fsm_init(ramp);
-    if(ramp->hold_callbacks[0]) ramp->hold_callbacks[0](ramp, 0); // Ramp up
+    fsm_init(&ui_fsm_table, ramp);
+    cb_adv_hold_ramp_up(ramp, 0); // Ramp up
     k_msleep(TEST_RAMP_STEP_MS + 20);
-    if(ramp->release_callback) ramp->release_callback(ramp, 0);
+    if (ramp->release_callback) ui_fsm_table.callbacks[ramp->release_callback](ramp, 0);
     
     // Verify changes
     // zassert_true(pwm_after != pwm, "PWM should change");
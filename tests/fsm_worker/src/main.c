@@ -0,0 +1,344 @@
+/**
+ * @file main.c
+ * @brief Unit tests for FSM worker priority lanes, coalescing and deadlines.
+ *
+ * The FSM engine is mocked: every input message costs a fixed busy-wait,
+ * so a flooded input lane represents a real backlog. Shutdown latency is
+ * measured with k_cycle_get_32() from post to fsm_emergency_off().
+ */
+
+#include <zephyr/ztest.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
+#include "fsm_worker.h"
+#include "fsm_sched.h"
+#include "zbeam_msg.h"
+
+/* Simulated cost of handling one input message in the FSM */
+#define INPUT_SERVICE_US 2000
+#define LATENCY_TRIALS   8
+
+/* --- Mock FSM Engine --- */
+
+static atomic_t inputs_processed;
+static atomic_t timers_processed;
+static volatile uint32_t shutdown_cycles;
+static volatile atomic_val_t inputs_at_shutdown;
+static K_SEM_DEFINE(shutdown_seen, 0, 1);
+
+void fsm_process_msg(const struct zbeam_msg *msg)
+{
+    k_busy_wait(INPUT_SERVICE_US);
+    atomic_inc(&inputs_processed);
+}
+
+void fsm_process_timer(const struct zbeam_msg *msg)
+{
+    atomic_inc(&timers_processed);
+}
+
+void fsm_emergency_off(void)
+{
+    shutdown_cycles = k_cycle_get_32();
+    inputs_at_shutdown = atomic_get(&inputs_processed);
+    k_sem_give(&shutdown_seen);
+}
+
+static atomic_t edges_processed;
+static volatile atomic_val_t inputs_at_first_edge;
+
+void multi_tap_input_process_edge(const struct zbeam_msg *edge)
+{
+    if (atomic_inc(&edges_processed) == 0) {
+        inputs_at_first_edge = atomic_get(&inputs_processed);
+    }
+}
+
+bool multi_tap_input_take_encoder(struct zbeam_msg *msg)
+{
+    return true;
+}
+
+/* --- Mock Deadlines --- */
+
+static atomic_t deadline_a_runs;
+static atomic_t deadline_b_runs;
+static volatile bool deadline_in_isr;
+
+static void deadline_a_fn(struct fsm_deadline *dl)
+{
+    deadline_in_isr = k_is_in_isr();
+    atomic_inc(&deadline_a_runs);
+}
+
+static void deadline_b_fn(struct fsm_deadline *dl)
+{
+    atomic_inc(&deadline_b_runs);
+}
+
+static FSM_DEADLINE_DEFINE(deadline_a, deadline_a_fn);
+static FSM_DEADLINE_DEFINE(deadline_b, deadline_b_fn);
+
+/* --- Helpers --- */
+
+static int flood_input(int n)
+{
+    struct zbeam_msg tap = { .type = MSG_INPUT_TAP, .count = 1 };
+    int accepted = 0;
+
+    for (int i = 0; i < n; i++) {
+        if (fsm_worker_post_msg(&tap) == 0) {
+            accepted++;
+        }
+    }
+    return accepted;
+}
+
+static void wait_lanes_idle(void)
+{
+    struct fsm_lane_stats stats;
+
+    for (int i = 0; i < FSM_LANE_COUNT; i++) {
+        do {
+            k_sleep(K_MSEC(5));
+            fsm_worker_get_lane_stats(i, &stats);
+        } while (stats.depth > 0);
+    }
+    /* Let the worker finish the message it dequeued last */
+    k_sleep(K_USEC(2 * INPUT_SERVICE_US));
+}
+
+/* --- Test Setup --- */
+
+static void before(void *fixture)
+{
+    wait_lanes_idle();
+    k_sem_reset(&shutdown_seen);
+    atomic_clear(&inputs_processed);
+    atomic_clear(&timers_processed);
+    atomic_clear(&edges_processed);
+    fsm_deadline_stop(&deadline_a);
+    fsm_deadline_stop(&deadline_b);
+    atomic_clear(&deadline_a_runs);
+    atomic_clear(&deadline_b_runs);
+    fsm_worker_reset_stats();
+}
+
+ZTEST_SUITE(fsm_worker_suite, NULL, NULL, before, NULL, NULL);
+
+/* --- Tests --- */
+
+ZTEST(fsm_worker_suite, test_lane_counters)
+{
+    struct fsm_lane_stats stats;
+    int extra = 3;
+
+    /* Worker cannot run while the (cooperative) test thread is busy */
+    int accepted = flood_input(CONFIG_ZBEAM_FSM_MSGQ_DEPTH + extra);
+    zassert_equal(accepted, CONFIG_ZBEAM_FSM_MSGQ_DEPTH, "Lane should accept exactly its depth");
+
+    fsm_worker_get_lane_stats(FSM_LANE_INPUT, &stats);
+    zassert_equal(stats.posted, CONFIG_ZBEAM_FSM_MSGQ_DEPTH, "Posted count mismatch");
+    zassert_equal(stats.dropped, extra, "Drop count mismatch");
+    zassert_equal(stats.depth, CONFIG_ZBEAM_FSM_MSGQ_DEPTH, "Depth mismatch");
+    zassert_equal(stats.high_water, CONFIG_ZBEAM_FSM_MSGQ_DEPTH, "High-water mismatch");
+
+    fsm_worker_get_lane_stats(FSM_LANE_SAFETY, &stats);
+    zassert_equal(stats.posted + stats.dropped, 0, "Input must not touch the safety lane");
+}
+
+ZTEST(fsm_worker_suite, test_priority_order)
+{
+    struct zbeam_msg timeout = { .type = MSG_TIMEOUT_INACTIVITY };
+
+    /* Housekeeping queued first, input second: input must still win */
+    zassert_equal(fsm_worker_post_msg(&timeout), 0, "Timeout rejected");
+    flood_input(2);
+
+    /* Wait for exactly one input to complete */
+    k_sleep(K_USEC(INPUT_SERVICE_US + INPUT_SERVICE_US / 2));
+    zassert_equal(atomic_get(&timers_processed), 0, "Housekeeping ran before input");
+
+    wait_lanes_idle();
+    zassert_equal(atomic_get(&inputs_processed), 2, "Inputs lost");
+    zassert_equal(atomic_get(&timers_processed), 1, "Timeout lost");
+}
+
+ZTEST(fsm_worker_suite, test_edge_ring)
+{
+    struct zbeam_msg edge = { .type = MSG_INPUT_EDGE, .count = 1 };
+    struct zbeam_msg tap = { .type = MSG_INPUT_TAP, .count = 1 };
+    struct fsm_lane_stats stats;
+    struct fsm_worker_stats wstats;
+
+    /* Edges first, then a resolved tap: the tap must still be dispatched first */
+    for (int i = 0; i < CONFIG_ZBEAM_FSM_EDGE_RING_DEPTH; i++) {
+        zassert_ok(fsm_worker_post_edge(&edge), "Edge %d rejected", i);
+    }
+    zassert_equal(fsm_worker_post_edge(&edge), -ENOMSG, "Full ring must reject");
+    zassert_ok(fsm_worker_post_msg(&tap));
+
+    fsm_worker_get_lane_stats(FSM_LANE_EDGE, &stats);
+    zassert_equal(stats.posted, CONFIG_ZBEAM_FSM_EDGE_RING_DEPTH, "Posted count mismatch");
+    zassert_equal(stats.dropped, 1, "Drop count mismatch");
+    zassert_equal(stats.depth, CONFIG_ZBEAM_FSM_EDGE_RING_DEPTH, "Depth mismatch");
+    zassert_is_null(fsm_worker_get_queue(FSM_LANE_EDGE), "Edge lane has no k_msgq");
+
+    wait_lanes_idle();
+    zassert_equal(atomic_get(&edges_processed), CONFIG_ZBEAM_FSM_EDGE_RING_DEPTH, "Edges lost");
+    zassert_equal(inputs_at_first_edge, 1, "Input lane must drain before edges");
+
+    fsm_worker_get_stats(&wstats);
+    zassert_equal(wstats.wakeups, 1, "Only the first edge should kick the worker");
+}
+
+ZTEST(fsm_worker_suite, test_batch_drain_single_wakeup)
+{
+    struct fsm_worker_stats stats;
+
+    flood_input(CONFIG_ZBEAM_FSM_MSGQ_DEPTH);
+    wait_lanes_idle();
+
+    fsm_worker_get_stats(&stats);
+    zassert_equal(stats.wakeups, 1, "Backlog should drain in one wakeup (got %u)", stats.wakeups);
+    zassert_equal(stats.processed, CONFIG_ZBEAM_FSM_MSGQ_DEPTH, "Inputs must never coalesce");
+    zassert_equal(stats.coalesced, 0, "Inputs must never coalesce");
+}
+
+ZTEST(fsm_worker_suite, test_coalescing)
+{
+    static const uint8_t severities[] = { 1, 5, 3, 2 };
+    struct zbeam_msg timeout = { .type = MSG_TIMEOUT_INACTIVITY };
+    struct fsm_worker_stats stats;
+
+    for (int i = 0; i < ARRAY_SIZE(severities); i++) {
+        struct zbeam_msg warn = { .type = MSG_SAFETY_THERMAL_WARN, .severity = severities[i] };
+        zassert_equal(fsm_worker_post_msg(&warn), 0, "Warning rejected");
+    }
+    for (int i = 0; i < 3; i++) {
+        zassert_equal(fsm_worker_post_msg(&timeout), 0, "Timeout rejected");
+    }
+
+    wait_lanes_idle();
+
+    fsm_worker_get_stats(&stats);
+    zassert_equal(stats.received, 7, "Received mismatch");
+    zassert_equal(stats.processed, 4, "Expected one warning + three timeouts");
+    zassert_equal(stats.coalesced, 3, "Coalesced mismatch");
+    zassert_equal(stats.wakeups, 1, "Expected a single wakeup");
+    zassert_equal(atomic_get(&timers_processed), 3, "Timeouts must not coalesce");
+}
+
+ZTEST(fsm_worker_suite, test_deadline_thread_context)
+{
+    int64_t expiry;
+
+    zassert_equal(fsm_sched_next_deadline(&expiry), -ENOENT, "Nothing should be armed");
+
+    fsm_deadline_start(&deadline_a, 20, 0);
+    zassert_equal(fsm_sched_next_deadline(&expiry), 0, "Deadline not armed");
+    zassert_true(expiry > k_uptime_get(), "Expiry should be in the future");
+
+    k_sleep(K_MSEC(40));
+    zassert_equal(atomic_get(&deadline_a_runs), 1, "One-shot should run once");
+    zassert_false(deadline_in_isr, "Deadline must run in thread context");
+    zassert_false(fsm_deadline_is_armed(&deadline_a), "One-shot should disarm");
+}
+
+ZTEST(fsm_worker_suite, test_deadline_merge)
+{
+    struct fsm_worker_stats stats;
+
+    /* Same expiry: both callbacks must share one wakeup */
+    fsm_deadline_start(&deadline_a, 20, 0);
+    fsm_deadline_start(&deadline_b, 20, 0);
+
+    /* Arming kicks the worker once to shorten its sleep; ignore that */
+    k_sleep(K_MSEC(5));
+    fsm_worker_reset_stats();
+    k_sleep(K_MSEC(35));
+
+    fsm_worker_get_stats(&stats);
+    zassert_equal(atomic_get(&deadline_a_runs) + atomic_get(&deadline_b_runs), 2,
+                  "Both deadlines should run");
+    zassert_equal(stats.deadlines, 2, "Deadline counter mismatch");
+    zassert_equal(stats.wakeups, 1, "Coincident deadlines should merge (got %u wakeups)",
+                  stats.wakeups);
+}
+
+ZTEST(fsm_worker_suite, test_deadline_periodic_stop)
+{
+    fsm_deadline_start(&deadline_a, 10, 10);
+    k_sleep(K_MSEC(55));
+    fsm_deadline_stop(&deadline_a);
+
+    atomic_val_t runs = atomic_get(&deadline_a_runs);
+    zassert_true(runs >= 4 && runs <= 6, "Periodic deadline ran %d times", (int)runs);
+
+    k_sleep(K_MSEC(30));
+    zassert_equal(atomic_get(&deadline_a_runs), runs, "Stopped deadline kept running");
+}
+
+ZTEST(fsm_worker_suite, test_shutdown_reserved_slot)
+{
+    struct zbeam_msg warn = { .type = MSG_SAFETY_THERMAL_WARN, .severity = 1 };
+    struct zbeam_msg shutdown = { .type = MSG_SAFETY_SHUTDOWN, .severity = 255 };
+    struct fsm_lane_stats stats;
+
+    /* Fill the safety lane completely */
+    for (int i = 0; i < CONFIG_ZBEAM_FSM_SAFETY_MSGQ_DEPTH + 2; i++) {
+        fsm_worker_post_msg(&warn);
+    }
+    fsm_worker_get_lane_stats(FSM_LANE_SAFETY, &stats);
+    zassert_equal(stats.dropped, 2, "Safety lane should be full");
+
+    /* Shutdown must still be accepted and delivered */
+    zassert_equal(fsm_worker_post_msg(&shutdown), 0, "Shutdown rejected");
+    zassert_equal(k_sem_take(&shutdown_seen, K_MSEC(100)), 0, "Shutdown not delivered");
+
+    fsm_worker_get_lane_stats(FSM_LANE_SAFETY, &stats);
+    zassert_equal(stats.dropped, 2, "Shutdown must never count as dropped");
+}
+
+ZTEST(fsm_worker_suite, test_input_flood_shutdown_latency)
+{
+    struct zbeam_msg shutdown = { .type = MSG_SAFETY_SHUTDOWN, .severity = 255 };
+    uint32_t worst_us = 0;
+
+    for (int trial = 0; trial < LATENCY_TRIALS; trial++) {
+        k_sem_reset(&shutdown_seen);
+        int queued = flood_input(CONFIG_ZBEAM_FSM_MSGQ_DEPTH);
+        zassert_equal(queued, CONFIG_ZBEAM_FSM_MSGQ_DEPTH, "Flood not accepted");
+
+        /* Let the worker get partway into the backlog, at a varying phase */
+        k_sleep(K_USEC(INPUT_SERVICE_US + (trial * INPUT_SERVICE_US) / LATENCY_TRIALS));
+
+        atomic_val_t inputs_before = atomic_get(&inputs_processed);
+        uint32_t t0 = k_cycle_get_32();
+        zassert_equal(fsm_worker_post_msg(&shutdown), 0, "Shutdown rejected");
+        zassert_equal(k_sem_take(&shutdown_seen, K_MSEC(100)), 0, "Shutdown not delivered");
+
+        uint32_t latency_us = k_cyc_to_us_ceil32(shutdown_cycles - t0);
+        if (latency_us > worst_us) {
+            worst_us = latency_us;
+        }
+
+        /* At most the message already in flight may complete first */
+        zassert_true(inputs_at_shutdown - inputs_before <= 1,
+                     "Shutdown waited behind %d queued inputs",
+                     (int)(inputs_at_shutdown - inputs_before));
+
+        wait_lanes_idle();
+        atomic_clear(&inputs_processed);
+    }
+
+    TC_PRINT("Worst-case shutdown latency: %u us (input backlog %d x %d us)\n",
+             worst_us, CONFIG_ZBEAM_FSM_MSGQ_DEPTH, INPUT_SERVICE_US);
+    zassert_true(worst_us <= 2 * INPUT_SERVICE_US,
+                 "Shutdown latency %u us exceeds one in-flight input", worst_us);
+}
+
+void test_main(void)
+{
+    ztest_run_test_suites(NULL, false, 1, 1);
+}
@@ -7,20 +7,25 @@
 #include <zephyr/input/input.h>
 #include <zephyr/kernel.h>
 #include "zbeam_msg.h"
+#include "fsm_sched.h"
+#include "fsm_worker.h"
 
-/* Mock Message Queue */
-K_MSGQ_DEFINE(zbeam_msgq, sizeof(struct zbeam_msg), 10, 4);
+/* Captured FSM events */
+K_MSGQ_DEFINE(zbeam_msgq, sizeof(struct zbeam_msg), 16, 4);
 
-/* Externs to satisfy multi_tap_input link requirements */
-/* multi_tap_input calls fsm_worker_post_msg. We implement it here to capture output. */
-/* Externs to satisfy multi_tap_input link requirements */
-/* multi_tap_input calls fsm_worker_post_msg. We implement it here to capture output. */
-int fsm_worker_post_msg(struct zbeam_msg *msg)
+/*
+ * Key edges travel through the real FSM worker, which runs the
+ * multi-tap deadlines. Mock the engine at the far end to capture output.
+ */
+void fsm_process_msg(const struct zbeam_msg *msg)
 {
-    printk("DEBUG: Mock fsm_worker_post_msg type=%d count=%d\n", msg->type, msg->count);
-    return k_msgq_put(&zbeam_msgq, msg, K_NO_WAIT);
+    printk("DEBUG: Mock fsm_process_msg type=%d count=%d\n", msg->type, msg->count);
+    k_msgq_put(&zbeam_msgq, msg, K_NO_WAIT);
 }
 
+void fsm_process_timer(const struct zbeam_msg *msg) { }
+void fsm_emergency_off(void) { }
+
 #include "multi_tap_input.h" 
 extern void multi_tap_input_init(void);
 
@@ -53,6 +58,7 @@ static void before(void *fixture)
         initialized = true;
     }
     multi_tap_input_reset();
+    multi_tap_set_continue_query(NULL);
     k_msgq_purge(&zbeam_msgq);
     /* Yield to let timers process cancellation */
     k_sleep(K_MSEC(10)); 
@@ -115,6 +121,198 @@ ZTEST(input_logic_suite, test_hold)
     zassert_equal(msg.type, MSG_INPUT_HOLD_RELEASE, "Type mismatch");
 }
 
+ZTEST(input_logic_suite, test_timeouts_are_deadlines)
+{
+    int64_t expiry;
+
+    zassert_equal(fsm_sched_next_deadline(&expiry), -ENOENT, "Idle input should arm nothing");
+
+    /* A press arms the hold deadline on the worker */
+    press_button();
+    k_sleep(K_MSEC(10));
+    zassert_equal(fsm_sched_next_deadline(&expiry), 0, "Press should arm a deadline");
+    zassert_true(expiry - k_uptime_get() <= CONFIG_ZBEAM_HOLD_DURATION_MS,
+                 "Next deadline should be the hold threshold");
+
+    /* Release swaps it for the click timeout; expiry resolves the tap */
+    release_button();
+    k_sleep(K_MSEC(CONFIG_ZBEAM_CLICK_TIMEOUT_MS + 50));
+    zassert_equal(fsm_sched_next_deadline(&expiry), -ENOENT, "Deadlines should be consumed");
+
+    struct zbeam_msg msg;
+    zassert_equal(k_msgq_get(&zbeam_msgq, &msg, K_NO_WAIT), 0, "Tap not delivered");
+    zassert_equal(msg.type, MSG_INPUT_TAP, "Should be TAP");
+}
+
+static bool continue_below_two(uint8_t source, int count)
+{
+    return count < 2;
+}
+
+ZTEST(input_logic_suite, test_early_commit)
+{
+    struct zbeam_msg msg;
+
+    multi_tap_set_continue_query(continue_below_two);
+
+    /* 1C may still become 2C: waits for the click timeout */
+    press_button();
+    k_sleep(K_MSEC(50));
+    release_button();
+    k_sleep(K_MSEC(20));
+    zassert_equal(k_msgq_get(&zbeam_msgq, &msg, K_NO_WAIT), -ENOMSG, "1C committed early");
+
+    /* 2C is the longest sequence: committed on release */
+    press_button();
+    k_sleep(K_MSEC(50));
+    release_button();
+    k_sleep(K_MSEC(20));
+    zassert_equal(k_msgq_get(&zbeam_msgq, &msg, K_NO_WAIT), 0, "2C should not wait");
+    zassert_equal(msg.type, MSG_INPUT_TAP, "Should be TAP");
+    zassert_equal(msg.count, 2, "Count should be 2");
+
+    /* Nothing left behind for the click timeout to deliver */
+    k_sleep(K_MSEC(CONFIG_ZBEAM_CLICK_TIMEOUT_MS + 50));
+    zassert_equal(k_msgq_get(&zbeam_msgq, &msg, K_NO_WAIT), -ENOMSG, "Duplicate tap");
+}
+
+/* Toggle the contact @p edges times, 1 ms apart, starting from @p pressed */
+static void chatter(bool pressed, int edges)
+{
+    for (int i = 0; i < edges; i++) {
+        input_report_key(NULL, INPUT_KEY_0, pressed, true, K_NO_WAIT);
+        pressed = !pressed;
+        k_sleep(K_MSEC(1));
+    }
+}
+
+ZTEST(input_logic_suite, test_debounce_chatter)
+{
+    struct zbeam_msg msg;
+
+    /* Bouncy press settling pressed, then bouncy release settling released */
+    chatter(true, 5);
+    k_sleep(K_MSEC(50));
+    chatter(false, 3);
+    k_sleep(K_MSEC(CONFIG_ZBEAM_CLICK_TIMEOUT_MS + 50));
+
+    zassert_equal(k_msgq_get(&zbeam_msgq, &msg, K_NO_WAIT), 0, "Tap not delivered");
+    zassert_equal(msg.type, MSG_INPUT_TAP, "Should be TAP");
+    zassert_equal(msg.count, 1, "Chatter counted as extra taps");
+    zassert_equal(k_msgq_get(&zbeam_msgq, &msg, K_NO_WAIT), -ENOMSG, "Chatter leaked through");
+}
+
+ZTEST(input_logic_suite, test_debounce_short_press)
+{
+    struct zbeam_msg msg;
+
+    /* Released inside the window: the release is applied when it closes */
+    chatter(true, 2);
+    k_sleep(K_MSEC(CONFIG_ZBEAM_CLICK_TIMEOUT_MS + 50));
+
+    zassert_equal(k_msgq_get(&zbeam_msgq, &msg, K_NO_WAIT), 0, "Short press lost");
+    zassert_equal(msg.type, MSG_INPUT_TAP, "Release lost: should be TAP, not HOLD");
+    zassert_equal(msg.count, 1, "Count should be 1");
+}
+
+ZTEST(input_logic_suite, test_debounce_release_with_press)
+{
+    struct zbeam_msg msg;
+
+    /*
+     * Release straight behind the press: the settle can fall due just
+     * before the window from the accepted press closes, and must wait
+     * out the rest rather than drop the release.
+     */
+    press_button();
+    release_button();
+    k_sleep(K_MSEC(CONFIG_ZBEAM_CLICK_TIMEOUT_MS + 50));
+
+    zassert_equal(k_msgq_get(&zbeam_msgq, &msg, K_NO_WAIT), 0, "Release lost");
+    zassert_equal(msg.type, MSG_INPUT_TAP, "Should be TAP");
+    zassert_equal(msg.count, 1, "Count should be 1");
+}
+
+ZTEST(input_logic_suite, test_fast_double_click)
+{
+    struct zbeam_msg msg;
+
+    /* 30 ms presses and gaps: too fast for a 50 ms hardware debounce */
+    for (int i = 0; i < 2; i++) {
+        press_button();
+        k_sleep(K_MSEC(30));
+        release_button();
+        k_sleep(K_MSEC(30));
+    }
+    k_sleep(K_MSEC(CONFIG_ZBEAM_CLICK_TIMEOUT_MS + 50));
+
+    zassert_equal(k_msgq_get(&zbeam_msgq, &msg, K_NO_WAIT), 0, "Tap not delivered");
+    zassert_equal(msg.count, 2, "Count should be 2");
+}
+
+static void click_key(uint16_t code)
+{
+    input_report_key(NULL, code, 1, true, K_NO_WAIT);
+    k_sleep(K_MSEC(50));
+    input_report_key(NULL, code, 0, true, K_NO_WAIT);
+    k_sleep(K_MSEC(50));
+}
+
+ZTEST(input_logic_suite, test_sources_are_independent)
+{
+    struct zbeam_msg msg;
+    int main_taps = 0, tail_taps = 0;
+
+    /* Tail 2C while the main button is down: neither sequence sees the other */
+    press_button();
+    click_key(INPUT_KEY_1);
+    click_key(INPUT_KEY_1);
+    release_button();
+    k_sleep(K_MSEC(CONFIG_ZBEAM_CLICK_TIMEOUT_MS + 50));
+
+    while (k_msgq_get(&zbeam_msgq, &msg, K_NO_WAIT) == 0) {
+        zassert_equal(msg.type, MSG_INPUT_TAP, "Should be TAP, got %d", msg.type);
+        if (msg.source == INPUT_SRC_MAIN) {
+            main_taps++;
+            zassert_equal(msg.count, 1, "Main count should be 1");
+        } else {
+            tail_taps++;
+            zassert_equal(msg.source, INPUT_SRC_TAIL, "Unexpected source %d", msg.source);
+            zassert_equal(msg.count, 2, "Tail count should be 2");
+        }
+    }
+    zassert_equal(main_taps, 1, "Expected one main tap");
+    zassert_equal(tail_taps, 1, "Expected one tail tap");
+}
+
+ZTEST(input_logic_suite, test_encoder_coalesced)
+{
+    struct fsm_lane_stats lane;
+    struct zbeam_msg msg;
+    int total = 0;
+
+    fsm_worker_reset_stats();
+
+    /* Fast spin: 12 detents up, 2 back */
+    for (int i = 0; i < 12; i++) {
+        input_report_rel(NULL, INPUT_REL_WHEEL, 1, true, K_NO_WAIT);
+    }
+    input_report_rel(NULL, INPUT_REL_WHEEL, -2, true, K_NO_WAIT);
+    k_sleep(K_MSEC(50));
+
+    while (k_msgq_get(&zbeam_msgq, &msg, K_NO_WAIT) == 0) {
+        zassert_equal(msg.type, MSG_INPUT_ENCODER, "Should be ENCODER");
+        zassert_equal(msg.source, INPUT_SRC_ENCODER, "Should be tagged as encoder");
+        total += (int8_t)msg.count;
+    }
+    zassert_equal(total, 10, "Detents lost or duplicated");
+
+    /* Never more than one encoder message queued */
+    fsm_worker_get_lane_stats(FSM_LANE_INPUT, &lane);
+    zassert_true(lane.high_water <= 1, "Encoder flooded the lane (%d)", lane.high_water);
+    zassert_equal(lane.dropped, 0);
+}
+
 void test_main(void)
 {
     ztest_run_test_suites(NULL, false, 1, 1);
@@ -0,0 +1,429 @@
+/**
+ * @file main.c
+ * @brief Replay recorded input traces through the full input and UI path
+ *        and check the FSM trace and the output timeline.
+ *
+ * Runs under native_sim virtual time: a replay sleeps from edge to edge,
+ * so the hours-long field test finishes in seconds of wall time. Hooks are
+ * bound as in src/main.c, so preview, early commit and the lockout
+ * momentary path are all part of what is replayed. Timings are the stock
+ * Kconfig defaults, the ones field captures are taken with.
+ */
+
+#include <zephyr/ztest.h>
+#include <zephyr/kernel.h>
+#include "ui_actions.h"
+#include "multi_tap_input.h"
+#include "fsm_engine.h"
+#include "fsm_worker.h"
+#include "safety_monitor.h"
+#include "replay.h"
+
+#define CLICK_MS CONFIG_ZBEAM_CLICK_TIMEOUT_MS
+#define HOLD_MS  CONFIG_ZBEAM_HOLD_DURATION_MS
+#define FLOOR    CONFIG_ZBEAM_BRIGHTNESS_FLOOR
+#define CEILING  CONFIG_ZBEAM_BRIGHTNESS_CEILING
+#define SWEEP_MS CONFIG_ZBEAM_BRIGHTNESS_SWEEP_DURATION_MS
+#define TICK_MS  CONFIG_ZBEAM_BRIGHTNESS_RAMP_TICK_MS
+
+/* Let the last commit and its actions run after a replay */
+#define SETTLE_MS (CLICK_MS + HOLD_MS + 100)
+
+/* Allowed timing error: one tick of rounding either way */
+#define SLACK_MS (1 + 1000 / CONFIG_SYS_CLOCK_TICKS_PER_SEC)
+
+/* Fuzzed durations stay this far from a threshold, beyond that it's a bug */
+#define GUARD_MS (2 * SLACK_MS)
+#define FUZZ_WINDOW_MS 60
+
+#define FIELD_HOURS  8
+#define FIELD_IDLE_S 90
+
+#define LIT 0x100  /* Any non-zero level (timeline expectations) */
+
+#define KEY(_ms, _level) REPLAY_KEY(_ms, INPUT_SRC_MAIN, _level)
+#define TAP(_ms, _len) KEY(_ms, 1), KEY((_ms) + (_len), 0)
+
+/* --- MOCKS (channel_apply_mix is the recorder in replay.c) --- */
+
+void channel_init(void) { }
+void channel_cycle_mode(void) { }
+bool channel_budget_enabled(void) { return false; }
+void channel_set_supply_mv(uint16_t mv) { }
+void pm_init(void) { }
+void pm_suspend(void) { }
+void pm_resume(void) { }
+void aux_init(void) { }
+void aux_cycle_mode(void) { }
+void batt_init(void) { }
+uint16_t batt_read_voltage_mv(void) { return 4000; }
+void batt_calculate_blinks(uint16_t mv, uint8_t *major, uint8_t *minor) { *major = 4; *minor = 0; }
+void batt_calibrate_voltage(uint16_t actual_mv) { }
+void thermal_init(void) { }
+void thermal_update(uint8_t current_brightness) { }
+int32_t thermal_get_temp_mc(void) { return 25000; }
+void thermal_calibrate_current_temp(int32_t known_current_c) { }
+void thermal_set_limit(uint8_t limit_c) { }
+enum safety_fault safety_get_status(void) { return SAFETY_OK; }
+
+/* --- TRACES --- */
+
+static const struct replay_event evening_session[] = {
+#include "traces/evening_session.inc"
+};
+
+/* Inputs the engine should see for each evening session, in order */
+static const struct fsm_trace_entry evening_inputs[] = {
+    { .event = FSM_TRACE_TAP, .count = 1 },      /* ON */
+    { .event = FSM_TRACE_HOLD, .count = 1 },     /* Ramp up */
+    { .event = FSM_TRACE_RELEASE, .count = 1 },
+    { .event = FSM_TRACE_TAP, .count = 2 },      /* Ceiling */
+    { .event = FSM_TRACE_TAP, .count = 1 },      /* OFF */
+    { .event = FSM_TRACE_TAP, .count = 4 },      /* Lockout */
+    { .event = FSM_TRACE_HOLD, .count = 1 },     /* Momentary */
+    { .event = FSM_TRACE_RELEASE, .count = 1 },
+    { .event = FSM_TRACE_TAP, .count = 3 },      /* Unlock to OFF */
+};
+
+/* --- HELPERS --- */
+
+static struct fsm_trace_entry fsm_log[CONFIG_ZBEAM_FSM_TRACE_DEPTH];
+static struct replay_event recorded[CONFIG_ZBEAM_FSM_TRACE_DEPTH];
+
+static bool is_input(const struct fsm_trace_entry *e)
+{
+    return e->event == FSM_TRACE_TAP || e->event == FSM_TRACE_HOLD ||
+           e->event == FSM_TRACE_RELEASE;
+}
+
+/* Keep only the tap/hold/release dispatches */
+static size_t input_dispatches(struct fsm_trace_entry *log, size_t n)
+{
+    size_t out = 0;
+
+    for (size_t i = 0; i < n; i++) {
+        if (is_input(&log[i])) {
+            log[out++] = log[i];
+        }
+    }
+    return out;
+}
+
+static void assert_dispatches(const struct fsm_trace_entry *expect, size_t n_expect,
+                              const struct fsm_trace_entry *got, size_t n_got,
+                              const char *what)
+{
+    zassert_equal(n_got, n_expect, "%s: %zu dispatches, expected %zu", what, n_got, n_expect);
+    for (size_t i = 0; i < n_expect; i++) {
+        zassert_equal(got[i].event, expect[i].event, "%s #%zu: event %u, expected %u",
+                      what, i, got[i].event, expect[i].event);
+        zassert_equal(got[i].count, expect[i].count, "%s #%zu: count %u, expected %u",
+                      what, i, got[i].count, expect[i].count);
+    }
+}
+
+static bool in_node(uint8_t id)
+{
+    const struct fsm_node *node = fsm_get_current_node();
+
+    return node && node->id == id;
+}
+
+/* --- FIXTURE --- */
+
+static void *setup(void)
+{
+    multi_tap_input_init();
+    multi_tap_set_continue_query(fsm_input_can_continue);
+    multi_tap_set_press_hook(fsm_preview_press);
+    multi_tap_set_edge_hook(fsm_momentary_edge);
+    ui_init();
+    return NULL;
+}
+
+static void before(void *fixture)
+{
+    multi_tap_set_continue_query(fsm_input_can_continue);
+    multi_tap_input_reset();
+    fsm_init(&ui_fsm_table, get_start_node()); /* OFF */
+    fsm_worker_reset_stats();
+    k_sleep(K_MSEC(50));
+}
+
+ZTEST_SUITE(input_replay_suite, NULL, setup, before, NULL, NULL);
+
+/* --- TESTS --- */
+
+ZTEST(input_replay_suite, test_golden_trace_and_timeline)
+{
+    static const struct replay_event trace[] = {
+        TAP(0, 80), TAP(250, 80), TAP(500, 80), TAP(750, 80),      /* 4C: lockout */
+        TAP(3000, 1000),                                            /* Momentary */
+        TAP(5000, 80), TAP(5250, 80), TAP(5500, 80), TAP(5750, 80),
+        TAP(6000, 80),                                              /* 5C: ceiling */
+        TAP(8000, 80),                                              /* 1C: OFF */
+    };
+    static const struct fsm_trace_entry expect[] = {
+        { 830 + CLICK_MS, FSM_TRACE_TAP, NODE_SMP_OFF, FSM_NONE, 4 },
+        { 830 + CLICK_MS, FSM_TRACE_TRANSITION, NODE_SMP_OFF, NODE_SMP_LOCKOUT, 0 },
+        { 3000 + HOLD_MS, FSM_TRACE_HOLD, NODE_SMP_LOCKOUT, FSM_NONE, 1 },
+        { 4000, FSM_TRACE_RELEASE, NODE_SMP_LOCKOUT, FSM_NONE, 1 },
+        /* Nothing longer than 5C is mapped in lockout: committed at release */
+        { 6080, FSM_TRACE_TAP, NODE_SMP_LOCKOUT, FSM_NONE, 5 },
+        { 6080, FSM_TRACE_TRANSITION, NODE_SMP_LOCKOUT, NODE_SMP_TURBO, 0 },
+        { 8080 + CLICK_MS, FSM_TRACE_TAP, NODE_SMP_TURBO, FSM_NONE, 1 },
+        { 8080 + CLICK_MS, FSM_TRACE_TRANSITION, NODE_SMP_TURBO, NODE_SMP_OFF, 0 },
+    };
+    static const struct {
+        uint32_t at_ms;
+        uint16_t level;
+    } duty[] = {
+        { 0, LIT },                 /* Preview at key-down */
+        { 830 + CLICK_MS, 0 },      /* Lockout */
+        { 3000, FLOOR }, { 4000, 0 },
+        { 5000, FLOOR }, { 5080, 0 }, { 5250, FLOOR }, { 5330, 0 },
+        { 5500, FLOOR }, { 5580, 0 }, { 5750, FLOOR }, { 5830, 0 },
+        { 6000, FLOOR }, { 6080, 0 },
+        { 6080, CEILING },
+        { 8080 + CLICK_MS, 0 },
+    };
+
+    int64_t start = replay_begin();
+
+    replay_run(start, trace, ARRAY_SIZE(trace));
+    k_sleep(K_MSEC(SETTLE_MS));
+
+    size_t n = replay_fsm_trace(start, fsm_log, ARRAY_SIZE(fsm_log));
+
+    zassert_equal(n, ARRAY_SIZE(expect), "%zu FSM entries, expected %zu", n, ARRAY_SIZE(expect));
+    for (size_t i = 0; i < n; i++) {
+        const struct fsm_trace_entry *e = &expect[i];
+        const struct fsm_trace_entry *g = &fsm_log[i];
+
+        zassert_true(e->event == g->event && e->from == g->from && e->to == g->to &&
+                     e->count == g->count,
+                     "#%zu: got %u %u->%u x%u, expected %u %u->%u x%u", i,
+                     g->event, g->from, g->to, g->count, e->event, e->from, e->to, e->count);
+        zassert_within(g->uptime_ms, e->uptime_ms, SLACK_MS,
+                       "#%zu at %u ms, expected %u ms", i, g->uptime_ms, e->uptime_ms);
+    }
+
+    const struct duty_sample *samples;
+    int len = replay_timeline(&samples);
+
+    zassert_equal(len, ARRAY_SIZE(duty), "%d level changes, expected %zu", len, ARRAY_SIZE(duty));
+    for (int i = 0; i < len; i++) {
+        zassert_within(samples[i].at_ms, duty[i].at_ms, SLACK_MS,
+                       "Change #%d at %u ms, expected %u ms", i, samples[i].at_ms, duty[i].at_ms);
+        if (duty[i].level == LIT) {
+            zassert_not_equal(samples[i].level, 0, "Change #%d should be lit", i);
+        } else {
+            zassert_equal(samples[i].level, BRIGHTNESS_FROM_LEVEL(duty[i].level),
+                          "Change #%d: brightness %u, expected level %u",
+                          i, samples[i].level, duty[i].level);
+        }
+    }
+}
+
+ZTEST(input_replay_suite, test_hold_ramp_timeline)
+{
+    static const struct replay_event trace[] = { TAP(0, 1450) };   /* 1H from OFF */
+
+    int64_t start = replay_begin();
+
+    replay_run(start, trace, ARRAY_SIZE(trace));
+    k_sleep(K_MSEC(SETTLE_MS));
+    zassert_true(in_node(NODE_SMP_ON), "Ramp release should land in ON");
+
+    const struct duty_sample *samples;
+    int len = replay_timeline(&samples);
+    int moon = -1;
+
+    zassert_true(len > 0, "Nothing written");
+    for (int i = 0; i < len; i++) {
+        if (samples[i].at_ms + SLACK_MS >= HOLD_MS) {
+            moon = i;
+            break;
+        }
+    }
+    zassert_true(moon >= 0, "No change at the hold threshold");
+    zassert_within(samples[moon].at_ms, HOLD_MS, SLACK_MS, "Moon at %u ms", samples[moon].at_ms);
+    zassert_equal(samples[moon].level, BRIGHTNESS_FROM_LEVEL(FLOOR),
+                  "1H should start at the floor");
+    zassert_true(len - moon >= 3, "Ramp took fewer than two steps");
+
+    /* Ramp: rising in sub-level steps every tick, frozen at release */
+    for (int i = moon + 1; i < len; i++) {
+        zassert_true(samples[i].level > samples[i - 1].level, "Ramp fell at step %d", i);
+        zassert_true(samples[i].level - samples[i - 1].level < BRIGHTNESS_FROM_LEVEL(1),
+                     "Step %d moved a whole level", i);
+        if (i > moon + 1) {
+            zassert_within(samples[i].at_ms - samples[i - 1].at_ms, TICK_MS, SLACK_MS,
+                           "Uneven ramp step %d", i);
+        }
+        zassert_true(samples[i].at_ms <= 1450, "Level changed after release");
+    }
+
+    /* Floor to ceiling takes the sweep time */
+    uint32_t expect = FLOOR + (CEILING - FLOOR) * (1450 - HOLD_MS) / SWEEP_MS;
+
+    zassert_within(BRIGHTNESS_LEVEL(samples[len - 1].level), expect, 2,
+                   "Ramp reached %u, expected %u", BRIGHTNESS_LEVEL(samples[len - 1].level),
+                   expect);
+    zassert_equal(replay_level(), ui_get_current_pwm(), "ON level differs from the ramp");
+}
+
+ZTEST(input_replay_suite, test_recording_round_trip)
+{
+    int64_t start = replay_begin();
+
+    replay_run(start, evening_session, ARRAY_SIZE(evening_session));
+    k_sleep(K_MSEC(SETTLE_MS));
+
+    /* The trace the firmware records is the one that was replayed */
+    size_t n = replay_recorded_inputs(start, recorded, ARRAY_SIZE(recorded));
+
+    zassert_equal(fsm_trace_overwritten(), 0, "Trace depth too small for the session");
+    zassert_equal(n, ARRAY_SIZE(evening_session), "Recorded %zu inputs, replayed %zu",
+                  n, ARRAY_SIZE(evening_session));
+    for (size_t i = 0; i < n; i++) {
+        zassert_within(recorded[i].at_ms, evening_session[i].at_ms, SLACK_MS,
+                       "Input #%zu at %u ms, replayed at %u ms",
+                       i, recorded[i].at_ms, evening_session[i].at_ms);
+        zassert_equal(recorded[i].source, evening_session[i].source, "Input #%zu source", i);
+        zassert_equal(recorded[i].value, evening_session[i].value, "Input #%zu value", i);
+    }
+
+    n = replay_fsm_trace(start, fsm_log, ARRAY_SIZE(fsm_log));
+    n = input_dispatches(fsm_log, n);
+    assert_dispatches(evening_inputs, ARRAY_SIZE(evening_inputs), fsm_log, n, "Evening");
+    zassert_true(in_node(NODE_SMP_OFF), "Session should end in OFF");
+    zassert_equal(replay_level(), 0, "Session should end dark");
+}
+
+ZTEST(input_replay_suite, test_field_hours)
+{
+    int64_t first = k_uptime_get();
+    int sessions = 0;
+
+    while (k_uptime_get() - first < FIELD_HOURS * 3600 * MSEC_PER_SEC) {
+        int64_t start = replay_begin();
+
+        replay_run(start, evening_session, ARRAY_SIZE(evening_session));
+        k_sleep(K_MSEC(SETTLE_MS));
+
+        size_t n = replay_fsm_trace(start, fsm_log, ARRAY_SIZE(fsm_log));
+
+        n = input_dispatches(fsm_log, n);
+        assert_dispatches(evening_inputs, ARRAY_SIZE(evening_inputs), fsm_log, n, "Field");
+        zassert_true(in_node(NODE_SMP_OFF), "Session %d did not end in OFF", sessions);
+        zassert_equal(replay_level(), 0, "Session %d left the emitter on", sessions);
+        sessions++;
+
+        k_sleep(K_SECONDS(FIELD_IDLE_S));
+    }
+
+    for (int lane = 0; lane < FSM_LANE_COUNT; lane++) {
+        struct fsm_lane_stats stats;
+
+        zassert_ok(fsm_worker_get_lane_stats(lane, &stats));
+        zassert_equal(stats.dropped, 0, "Lane %d dropped %u messages", lane, stats.dropped);
+    }
+    printk("Replayed %d sessions over %d h of virtual time\n", sessions, FIELD_HOURS);
+}
+
+/* --- TIMING FUZZ --- */
+
+#define FUZZ_SEED    0x5EEDu
+#define FUZZ_BATCHES 40
+#define FUZZ_PRESSES 12
+
+static uint32_t fuzz_state = FUZZ_SEED;
+
+static uint32_t fuzz_next(void)
+{
+    /* xorshift32: same sequence on every run and platform */
+    fuzz_state ^= fuzz_state << 13;
+    fuzz_state ^= fuzz_state >> 17;
+    fuzz_state ^= fuzz_state << 5;
+    return fuzz_state;
+}
+
+static uint32_t fuzz_range(uint32_t lo, uint32_t hi)
+{
+    return lo + fuzz_next() % (hi - lo + 1);
+}
+
+/* Close to @p threshold on either side, but never within the guard band */
+static uint32_t fuzz_near(uint32_t threshold)
+{
+    uint32_t ms;
+
+    do {
+        ms = fuzz_range(threshold - FUZZ_WINDOW_MS, threshold + FUZZ_WINDOW_MS);
+    } while (ms + GUARD_MS > threshold && ms < threshold + GUARD_MS);
+    return ms;
+}
+
+ZTEST(input_replay_suite, test_fuzz_thresholds)
+{
+    static struct replay_event trace[2 * FUZZ_PRESSES];
+    static struct fsm_trace_entry expect[2 * FUZZ_PRESSES];
+
+    /* Early commit moves with the node; fuzz the detector's own timing */
+    multi_tap_set_continue_query(NULL);
+
+    for (int batch = 0; batch < FUZZ_BATCHES; batch++) {
+        size_t n_expect = 0;
+        uint32_t t = 0;
+        uint8_t count = 0;
+
+        for (int i = 0; i < FUZZ_PRESSES; i++) {
+            uint32_t press = fuzz_next() & 1 ? fuzz_near(HOLD_MS)
+                                             : fuzz_range(30, HOLD_MS - GUARD_MS);
+            uint32_t gap = fuzz_next() & 1 ? fuzz_near(CLICK_MS)
+                                           : fuzz_range(30, CLICK_MS - GUARD_MS);
+
+            /* End sequences by 4C/4H: 10H would switch the UI mode */
+            if (count == 3) {
+                gap = MAX(gap, CLICK_MS + GUARD_MS);
+            }
+            bool last = (i == FUZZ_PRESSES - 1);
+
+            trace[2 * i] = (struct replay_event)KEY(t, 1);
+            trace[2 * i + 1] = (struct replay_event)KEY(t + press, 0);
+            t += press + gap;
+            count++;
+
+            if (press >= HOLD_MS) {
+                expect[n_expect++] = (struct fsm_trace_entry){ .event = FSM_TRACE_HOLD, .count = count };
+                expect[n_expect++] = (struct fsm_trace_entry){ .event = FSM_TRACE_RELEASE, .count = count };
+                count = 0;
+            } else if (last || gap >= CLICK_MS) {
+                expect[n_expect++] = (struct fsm_trace_entry){ .event = FSM_TRACE_TAP, .count = count };
+                count = 0;
+            }
+        }
+
+        int64_t start = replay_begin();
+
+        replay_run(start, trace, ARRAY_SIZE(trace));
+        k_sleep(K_MSEC(SETTLE_MS));
+
+        size_t n = replay_fsm_trace(start, fsm_log, ARRAY_SIZE(fsm_log));
+
+        zassert_equal(fsm_trace_overwritten(), 0, "Batch %d overflowed the trace", batch);
+        n = input_dispatches(fsm_log, n);
+        assert_dispatches(expect, n_expect, fsm_log, n, "Fuzz");
+
+        /* Start every batch from a known node */
+        fsm_init(&ui_fsm_table, get_start_node());
+    }
+    printk("Fuzzed %d presses around %u/%u ms (seed 0x%x)\n",
+           FUZZ_BATCHES * FUZZ_PRESSES, HOLD_MS, CLICK_MS, FUZZ_SEED);
+}
+
+void test_main(void)
+{
+    ztest_run_test_suites(NULL, false, 1, 1);
+}
@@ -0,0 +1,117 @@
+/**
+ * @file replay.c
+ * @brief Input trace replay driver and output timeline recorder.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/input/input.h>
+#include <zephyr/dt-bindings/input/input-event-codes.h>
+#include <errno.h>
+#include "channel_manager.h"
+#include "replay.h"
+
+#define TIMELINE_DEPTH 1024
+
+/* Same codes the input engine maps to its sources */
+static const uint16_t key_codes[INPUT_SRC_KEY_COUNT] = {
+    [INPUT_SRC_MAIN] = INPUT_KEY_0,
+    [INPUT_SRC_TAIL] = INPUT_KEY_1,
+    [INPUT_SRC_SIDE] = INPUT_KEY_2,
+};
+
+static struct duty_sample timeline[TIMELINE_DEPTH];
+static size_t timeline_len;
+static bool timeline_overflow;
+static int64_t timeline_start;
+static brightness_t last_level;
+static struct fsm_trace_entry snapshot[CONFIG_ZBEAM_FSM_TRACE_DEPTH];
+
+/* Output stage mock: keep brightness changes only, not repeated writes */
+void channel_apply_mix(brightness_t master_level)
+{
+    if (master_level == last_level) {
+        return;
+    }
+    last_level = master_level;
+
+    if (timeline_len == TIMELINE_DEPTH) {
+        timeline_overflow = true;
+        return;
+    }
+    timeline[timeline_len++] = (struct duty_sample){
+        .at_ms = (uint32_t)(k_uptime_get() - timeline_start),
+        .level = master_level,
+    };
+}
+
+int64_t replay_begin(void)
+{
+    /* Settle anything still running so it does not land in the new window */
+    k_sleep(K_MSEC(1));
+
+    fsm_trace_clear();
+    timeline_start = k_uptime_get();
+    timeline_len = 0;
+    timeline_overflow = false;
+    return timeline_start;
+}
+
+void replay_run(int64_t start, const struct replay_event *events, size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        const struct replay_event *ev = &events[i];
+
+        k_sleep(K_TIMEOUT_ABS_MS(start + ev->at_ms));
+
+        if (ev->source == INPUT_SRC_ENCODER) {
+            input_report_rel(NULL, INPUT_REL_WHEEL, ev->value, true, K_FOREVER);
+        } else if (ev->source < INPUT_SRC_KEY_COUNT) {
+            input_report_key(NULL, key_codes[ev->source], ev->value, true, K_FOREVER);
+        }
+    }
+}
+
+size_t replay_fsm_trace(int64_t start, struct fsm_trace_entry *buf, size_t max)
+{
+    size_t n = fsm_trace_read(snapshot, ARRAY_SIZE(snapshot));
+    size_t out = 0;
+
+    for (size_t i = 0; i < n && out < max; i++) {
+        if (snapshot[i].event == FSM_TRACE_INPUT) {
+            continue;
+        }
+        buf[out] = snapshot[i];
+        buf[out].uptime_ms -= (uint32_t)start;
+        out++;
+    }
+    return out;
+}
+
+size_t replay_recorded_inputs(int64_t start, struct replay_event *buf, size_t max)
+{
+    size_t n = fsm_trace_read(snapshot, ARRAY_SIZE(snapshot));
+    size_t out = 0;
+
+    for (size_t i = 0; i < n && out < max; i++) {
+        if (snapshot[i].event != FSM_TRACE_INPUT) {
+            continue;
+        }
+        buf[out++] = (struct replay_event){
+            .at_ms = snapshot[i].uptime_ms - (uint32_t)start,
+            .source = snapshot[i].from,
+            .value = (int8_t)snapshot[i].count,
+        };
+    }
+    return out;
+}
+
+int replay_timeline(const struct duty_sample **samples)
+{
+    *samples = timeline;
+    return timeline_overflow ? -ENOMEM : (int)timeline_len;
+}
+
+uint8_t replay_level(void)
+{
+    return BRIGHTNESS_LEVEL(last_level);
+}
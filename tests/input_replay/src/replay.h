@@ -0,0 +1,83 @@
+/**
+ * @file replay.h
+ * @brief Input trace replay driver and output timeline recorder.
+ *
+ * A trace is an array of timestamped raw inputs, the same edges the
+ * firmware's input callback sees (bounce included). The driver reports
+ * each one through the input subsystem at its time, so under native_sim
+ * virtual time an hour of usage replays in milliseconds. Field captures
+ * (CONFIG_ZBEAM_FSM_TRACE_INPUT) convert with
+ * scripts/decode_fsm_trace.py --replay.
+ */
+
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "brightness.h"
+#include "fsm_trace.h"
+#include "zbeam_msg.h"
+
+/**
+ * @brief One recorded input.
+ */
+struct replay_event {
+    uint32_t at_ms;  /**< Since the start of the replay */
+    uint8_t source;  /**< enum zbeam_input_source */
+    int8_t value;    /**< Key level (1 = down) or encoder detents */
+};
+
+#define REPLAY_KEY(_ms, _source, _level) \
+    { .at_ms = (_ms), .source = (_source), .value = (_level) }
+#define REPLAY_ENCODER(_ms, _detents) \
+    { .at_ms = (_ms), .source = INPUT_SRC_ENCODER, .value = (_detents) }
+
+/**
+ * @brief Output brightness change, as written to channel_apply_mix().
+ */
+struct duty_sample {
+    uint32_t at_ms;       /**< Since the start of the replay */
+    brightness_t level;   /**< 8.8 fixed point */
+};
+
+/**
+ * @brief Clear the FSM trace and the output timeline, then start the clock.
+ * @return Uptime (ms) that trace and timeline times are relative to.
+ */
+int64_t replay_begin(void);
+
+/**
+ * @brief Report @p count events at their times after @p start.
+ *
+ * Sleeps until each event is due, so the FSM worker and its deadlines run
+ * in between exactly as they would on the device.
+ */
+void replay_run(int64_t start, const struct replay_event *events, size_t count);
+
+/**
+ * @brief FSM entries since @p start, without raw inputs and re-timed.
+ * @return Number of entries copied.
+ */
+size_t replay_fsm_trace(int64_t start, struct fsm_trace_entry *buf, size_t max);
+
+/**
+ * @brief Raw inputs the firmware recorded since @p start, as a trace.
+ * @return Number of events copied.
+ */
+size_t replay_recorded_inputs(int64_t start, struct replay_event *buf, size_t max);
+
+/**
+ * @brief Output brightness changes since replay_begin(), timed from it.
+ *
+ * @param samples Set to the recorded timeline.
+ * @return Number of samples, or -ENOMEM if the timeline overflowed.
+ */
+int replay_timeline(const struct duty_sample **samples);
+
+/**
+ * @brief Whole level last written to the output.
+ */
+uint8_t replay_level(void);
+
+#endif /* REPLAY_H */
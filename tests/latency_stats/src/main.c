@@ -0,0 +1,147 @@
+/**
+ * @file main.c
+ * @brief Unit tests for input-to-photon latency histograms.
+ *
+ * Messages are stamped in the past by a known amount, then run through
+ * the begin/mark_output/end bracket the FSM worker uses, or the fast-path
+ * mark.
+ */
+
+#include <zephyr/ztest.h>
+#include <zephyr/kernel.h>
+#include "latency_stats.h"
+#include "zbeam_msg.h"
+
+static struct zbeam_msg msg_aged(uint8_t type, uint32_t age_us)
+{
+    struct zbeam_msg msg = { .type = type };
+
+    latency_stamp(&msg, k_cycle_get_32() - k_us_to_cyc_ceil32(age_us));
+    return msg;
+}
+
+static void before(void *fixture)
+{
+    latency_stats_reset();
+}
+
+ZTEST_SUITE(latency_stats_suite, NULL, NULL, before, NULL, NULL);
+
+ZTEST(latency_stats_suite, test_dispatch_and_output)
+{
+    struct zbeam_msg tap = msg_aged(MSG_INPUT_TAP, 1000);
+    struct latency_summary s;
+
+    latency_stats_begin(&tap);
+    k_busy_wait(500);
+    latency_stats_mark_output();
+    latency_stats_mark_output(); /* Only the first write counts */
+    latency_stats_end();
+
+    latency_stats_get(MSG_INPUT_TAP, LATENCY_STAGE_DISPATCH, &s);
+    zassert_equal(s.count, 1, "Dispatch sample missing");
+    zassert_within(s.min_us, 1000, 200, "Dispatch latency %u us", s.min_us);
+
+    latency_stats_get(MSG_INPUT_TAP, LATENCY_STAGE_OUTPUT, &s);
+    zassert_equal(s.count, 1, "Output should be recorded once per dispatch");
+    zassert_true(s.min_us >= 1500, "Output latency %u us too short", s.min_us);
+}
+
+ZTEST(latency_stats_suite, test_output_outside_dispatch_ignored)
+{
+    struct zbeam_msg hold = msg_aged(MSG_INPUT_HOLD_START, 100);
+    struct latency_summary s;
+
+    latency_stats_mark_output();
+
+    latency_stats_begin(&hold);
+    latency_stats_end();
+    latency_stats_mark_output(); /* e.g. a ramp deadline after dispatch */
+
+    for (int type = 0; type < MSG_TYPE_COUNT; type++) {
+        latency_stats_get(type, LATENCY_STAGE_OUTPUT, &s);
+        zassert_equal(s.count, 0, "Unattributed output recorded for type %d", type);
+    }
+}
+
+static void other_thread_write(void *p1, void *p2, void *p3)
+{
+    latency_stats_mark_output();
+}
+
+K_THREAD_STACK_DEFINE(other_stack, 512);
+static struct k_thread other_thread;
+
+ZTEST(latency_stats_suite, test_output_from_other_thread_ignored)
+{
+    struct zbeam_msg msg = msg_aged(MSG_INPUT_TAP, 100);
+    struct latency_summary s;
+
+    /* e.g. the momentary fast path writing while the worker dispatches */
+    latency_stats_begin(&msg);
+    k_thread_create(&other_thread, other_stack, K_THREAD_STACK_SIZEOF(other_stack),
+                    other_thread_write, NULL, NULL, NULL, K_PRIO_PREEMPT(0), 0, K_NO_WAIT);
+    k_thread_join(&other_thread, K_FOREVER);
+
+    latency_stats_get(MSG_INPUT_TAP, LATENCY_STAGE_OUTPUT, &s);
+    zassert_equal(s.count, 0, "Other thread's write attributed to the dispatch");
+
+    /* The dispatch's own write still counts */
+    latency_stats_mark_output();
+    latency_stats_end();
+    latency_stats_get(MSG_INPUT_TAP, LATENCY_STAGE_OUTPUT, &s);
+    zassert_equal(s.count, 1);
+}
+
+ZTEST(latency_stats_suite, test_fast_path)
+{
+    struct latency_summary s;
+
+    latency_stats_mark_fast_path(k_cycle_get_32() - k_us_to_cyc_ceil32(300));
+
+    latency_stats_get(MSG_INPUT_EDGE, LATENCY_STAGE_FAST_PATH, &s);
+    zassert_equal(s.count, 1, "Fast-path sample missing");
+    zassert_within(s.min_us, 300, 100, "Fast-path latency %u us", s.min_us);
+
+    latency_stats_get(MSG_INPUT_EDGE, LATENCY_STAGE_OUTPUT, &s);
+    zassert_equal(s.count, 0, "Fast path leaked into the worker's output stage");
+}
+
+ZTEST(latency_stats_suite, test_summary)
+{
+    struct latency_summary s;
+
+    /* 99 fast samples, one slow outlier */
+    for (int i = 0; i < 99; i++) {
+        struct zbeam_msg m = msg_aged(MSG_INPUT_TAP, 100);
+        latency_stats_begin(&m);
+        latency_stats_end();
+    }
+    struct zbeam_msg slow = msg_aged(MSG_INPUT_TAP, 50000);
+    latency_stats_begin(&slow);
+    latency_stats_end();
+
+    latency_stats_get(MSG_INPUT_TAP, LATENCY_STAGE_DISPATCH, &s);
+    zassert_equal(s.count, 100, "Count mismatch");
+    zassert_true(s.min_us >= 100, "Min %u", s.min_us);
+    zassert_true(s.max_us >= 50000, "Max %u", s.max_us);
+    zassert_true(s.avg_us > s.min_us && s.avg_us < s.max_us, "Avg %u", s.avg_us);
+    /* p99 lands in the fast samples' bucket, not the outlier's */
+    zassert_true(s.p99_us < 1024, "p99 %u should exclude the outlier", s.p99_us);
+
+    latency_stats_log();
+}
+
+ZTEST(latency_stats_suite, test_bad_args)
+{
+    struct latency_summary s;
+
+    zassert_equal(latency_stats_get(MSG_TYPE_COUNT, LATENCY_STAGE_DISPATCH, &s), -EINVAL, NULL);
+    zassert_equal(latency_stats_get(MSG_INPUT_TAP, LATENCY_STAGE_COUNT, &s), -EINVAL, NULL);
+    zassert_equal(latency_stats_get(MSG_INPUT_TAP, LATENCY_STAGE_DISPATCH, NULL), -EINVAL, NULL);
+}
+
+void test_main(void)
+{
+    ztest_run_test_suites(NULL, false, 1, 1);
+}
@@ -0,0 +1,186 @@
+/**
+ * @file main.c
+ * @brief Unit tests for the bytecode LED pattern engine.
+ *
+ * No worker thread is linked: the test thread stands in for it and runs
+ * expired deadlines itself, so every output step is observed in order.
+ */
+
+#include <zephyr/ztest.h>
+#include "led_pattern.h"
+#include "fsm_sched.h"
+
+#define MAX_WRITES 64
+
+static uint8_t levels[MAX_WRITES];
+static int64_t stamps[MAX_WRITES];
+static int writes;
+static int done_calls;
+
+static void mock_output(uint8_t level)
+{
+    if (writes < MAX_WRITES) {
+        levels[writes] = level;
+        stamps[writes] = k_uptime_get();
+    }
+    writes++;
+}
+
+static void mock_done(void)
+{
+    done_calls++;
+}
+
+/* Act as the FSM worker, polling every @p poll_ms, until idle or @p max_ms */
+static void run_for(uint32_t max_ms, uint32_t poll_ms)
+{
+    int64_t end = k_uptime_get() + max_ms;
+
+    while (led_pattern_current() && k_uptime_get() < end) {
+        fsm_sched_run_expired();
+        k_msleep(poll_ms);
+    }
+}
+
+static LED_PATTERN_DEFINE(pat_ramp,
+    PAT_LEVEL(0), PAT_RAMP(10, 100),
+    PAT_END());
+
+static LED_PATTERN_DEFINE(pat_fast_ramp,
+    PAT_LEVEL(0), PAT_RAMP(255, 50),
+    PAT_END());
+
+static LED_PATTERN_DEFINE(pat_loops,
+    PAT_REPEAT(2),
+        PAT_REPEAT(3),
+            PAT_LEVEL(1), PAT_HOLD(1),
+        PAT_NEXT(),
+        PAT_LEVEL(2), PAT_HOLD(1),
+    PAT_NEXT(),
+    PAT_REPEAT_ARG(0),
+        PAT_LEVEL(9), PAT_HOLD(1),
+    PAT_NEXT(),
+    PAT_END());
+
+static LED_PATTERN_DEFINE(pat_arg_level,
+    PAT_LEVEL_ARG(0), PAT_HOLD(5),
+    PAT_RESTART());
+
+static LED_PATTERN_DEFINE(pat_square,
+    PAT_LEVEL(1), PAT_HOLD(10),
+    PAT_LEVEL(0), PAT_HOLD(10),
+    PAT_RESTART());
+
+static LED_PATTERN_DEFINE(pat_unbalanced,
+    PAT_LEVEL(1), PAT_HOLD(1),
+    PAT_NEXT(),
+    PAT_END());
+
+static LED_PATTERN_DEFINE(pat_no_hold,
+    PAT_LEVEL(1),
+    PAT_RESTART());
+
+static void *pattern_setup(void)
+{
+    zassert_equal(led_pattern_play(&pat_ramp, NULL, 0, NULL), -ENODEV,
+                  "Playing without output must fail");
+    led_pattern_init(mock_output);
+    return NULL;
+}
+
+static void pattern_before(void *fixture)
+{
+    led_pattern_stop();
+    writes = 0;
+    done_calls = 0;
+}
+
+ZTEST_SUITE(led_pattern_suite, NULL, pattern_setup, pattern_before, NULL, NULL);
+
+ZTEST(led_pattern_suite, test_ramp_wakes_per_level)
+{
+    zassert_ok(led_pattern_play(&pat_ramp, NULL, 0, mock_done));
+    run_for(500, 1);
+
+    /* LEVEL 0, ramp start, then one write per level at 10 ms spacing */
+    zassert_equal(writes, 12, "Got %d writes", writes);
+    for (int i = 2; i < writes; i++) {
+        zassert_equal(levels[i], i - 1, "Write %d has level %d", i, levels[i]);
+        zassert_within(stamps[i] - stamps[i - 1], 10, 3);
+    }
+    zassert_equal(done_calls, 1);
+}
+
+ZTEST(led_pattern_suite, test_fast_ramp_bounded_wakeups)
+{
+    zassert_ok(led_pattern_play(&pat_fast_ramp, NULL, 0, mock_done));
+    run_for(500, 1);
+
+    /* 255 levels in 50 ms: at most one step per millisecond */
+    zassert_true(writes <= 2 + 50, "Got %d writes", writes);
+    zassert_equal(levels[MIN(writes, MAX_WRITES) - 1], 255);
+    zassert_equal(done_calls, 1);
+}
+
+ZTEST(led_pattern_suite, test_nested_and_empty_loops)
+{
+    const uint16_t args[] = { 0 };
+    const uint8_t expect[] = { 1, 1, 1, 2, 1, 1, 1, 2 };
+
+    zassert_ok(led_pattern_play(&pat_loops, args, ARRAY_SIZE(args), mock_done));
+    run_for(500, 1);
+
+    zassert_equal(writes, ARRAY_SIZE(expect), "Got %d writes", writes);
+    zassert_mem_equal(levels, expect, sizeof(expect));
+    zassert_equal(done_calls, 1, "Zero-count block must be skipped to END");
+}
+
+ZTEST(led_pattern_suite, test_set_arg_live)
+{
+    const uint16_t args[] = { 10 };
+
+    zassert_ok(led_pattern_play(&pat_arg_level, args, ARRAY_SIZE(args), NULL));
+    zassert_equal(levels[0], 10, "First level is applied immediately");
+
+    run_for(20, 1);
+    led_pattern_set_arg(0, 20);
+    run_for(20, 1);
+
+    zassert_equal(levels[MIN(writes, MAX_WRITES) - 1], 20, "New argument not picked up");
+    zassert_equal(led_pattern_current(), &pat_arg_level, "Looping pattern must keep playing");
+    led_pattern_stop();
+    zassert_is_null(led_pattern_current());
+}
+
+ZTEST(led_pattern_suite, test_holds_chain_from_expiry)
+{
+    zassert_ok(led_pattern_play(&pat_square, NULL, 0, NULL));
+
+    /* A sluggish worker (3 ms per pass) must not stretch the period */
+    run_for(405, 3);
+    led_pattern_stop();
+
+    zassert_true(writes >= 41, "Got %d writes", writes);
+    zassert_within(stamps[40] - stamps[0], 400, 4);
+}
+
+ZTEST(led_pattern_suite, test_malformed_patterns_stop)
+{
+    zassert_ok(led_pattern_play(&pat_unbalanced, NULL, 0, mock_done));
+    run_for(50, 1);
+    zassert_is_null(led_pattern_current());
+
+    zassert_ok(led_pattern_play(&pat_no_hold, NULL, 0, mock_done));
+    zassert_is_null(led_pattern_current(), "Pattern without holds must be stopped");
+
+    zassert_equal(done_calls, 0, "Failed patterns must not complete");
+}
+
+ZTEST(led_pattern_suite, test_bad_args)
+{
+    const uint16_t args[LED_PATTERN_ARGS + 1] = { 0 };
+
+    zassert_equal(led_pattern_play(NULL, NULL, 0, NULL), -EINVAL);
+    zassert_equal(led_pattern_play(&pat_ramp, args, ARRAY_SIZE(args), NULL), -EINVAL);
+    zassert_equal(led_pattern_play(&pat_ramp, NULL, 1, NULL), -EINVAL);
+}
@@ -0,0 +1,251 @@
+/**
+ * @file main.c
+ * @brief Unit tests for the non-blocking PWM ramp (start, stop, retarget,
+ *        completion callback).
+ *
+ * No worker thread is linked: the test thread stands in for it and runs
+ * expired deadlines itself, so every output write is observed in order.
+ */
+
+#include <zephyr/ztest.h>
+#include <stdlib.h>
+#include "pwm_ramp.h"
+#include "fsm_sched.h"
+
+#ifdef CONFIG_PWM_RAMP_INTERPOLATION_STEP
+#define FADE_STEP CONFIG_PWM_RAMP_INTERPOLATION_STEP
+#else
+#define FADE_STEP 1
+#endif
+
+#define MAX_WRITES 512
+#define TOLERANCE_MS (CONFIG_ZBEAM_FSM_SCHED_SLACK_MS + 1)
+
+static uint8_t levels[MAX_WRITES];
+static int64_t stamps[MAX_WRITES];
+static int writes;
+
+static int done_calls;
+static uint8_t done_level;
+static bool done_completed;
+
+/* --- MOCKS --- */
+
+int pwm_ramp_backend_write(uint8_t brightness)
+{
+    if (writes < MAX_WRITES) {
+        levels[writes] = brightness;
+        stamps[writes] = k_uptime_get();
+    }
+    writes++;
+    return 0;
+}
+
+static void on_done(uint8_t brightness, bool completed)
+{
+    done_calls++;
+    done_level = brightness;
+    done_completed = completed;
+}
+
+static int chained_calls;
+
+/* Fade back down as soon as the way up completes */
+static void on_done_chain(uint8_t brightness, bool completed)
+{
+    chained_calls++;
+    if (completed && brightness > 0) {
+        pwm_ramp_start(0, 50, on_done);
+    }
+}
+
+/* --- HELPERS --- */
+
+/* Act as the FSM worker for @p ms, polling every millisecond */
+static void run_for(uint32_t ms)
+{
+    int64_t end = k_uptime_get() + ms;
+
+    while (k_uptime_get() < end) {
+        fsm_sched_run_expired();
+        k_msleep(1);
+    }
+}
+
+/* Act as the FSM worker until the fade ends or @p max_ms passes */
+static void run_until_idle(uint32_t max_ms)
+{
+    int64_t end = k_uptime_get() + max_ms;
+
+    while (pwm_ramp_is_active() && k_uptime_get() < end) {
+        fsm_sched_run_expired();
+        k_msleep(1);
+    }
+}
+
+/* Largest level change between consecutive writes in [from, writes) */
+static int max_jump(int from)
+{
+    int jump = 0;
+
+    for (int i = from + 1; i < writes && i < MAX_WRITES; i++) {
+        jump = MAX(jump, abs((int)levels[i] - (int)levels[i - 1]));
+    }
+    return jump;
+}
+
+/* --- FIXTURE --- */
+
+static void before(void *fixture)
+{
+    pwm_ramp_set_brightness(0);
+    writes = 0;
+    done_calls = 0;
+    done_level = 0;
+    done_completed = false;
+    chained_calls = 0;
+}
+
+ZTEST_SUITE(pwm_ramp_suite, NULL, NULL, before, NULL, NULL);
+
+/* --- TESTS --- */
+
+ZTEST(pwm_ramp_suite, test_start_does_not_block)
+{
+    int64_t before_ms = k_uptime_get();
+
+    zassert_ok(pwm_ramp_start(255, 1000, on_done));
+    zassert_equal(k_uptime_get(), before_ms, "Start slept");
+    zassert_true(pwm_ramp_is_active(), "Fade should be running");
+    zassert_true(writes <= 1, "Fade ran ahead without the worker");
+    zassert_equal(done_calls, 0);
+
+    pwm_ramp_stop();
+}
+
+ZTEST(pwm_ramp_suite, test_completes_on_time)
+{
+    int64_t start = k_uptime_get();
+
+    zassert_ok(pwm_ramp_start(200, 200, on_done));
+    run_until_idle(400);
+
+    zassert_false(pwm_ramp_is_active());
+    zassert_equal(done_calls, 1, "Callback ran %d times", done_calls);
+    zassert_true(done_completed, "Fade should report completion");
+    zassert_equal(done_level, 200);
+    zassert_equal(pwm_ramp_get_brightness(), 200);
+
+    /* Monotonic, one step per write, target reached at the deadline */
+    zassert_true(max_jump(0) <= FADE_STEP, "Fade jumped by %d", max_jump(0));
+    zassert_equal(levels[writes - 1], 200);
+    zassert_within(stamps[writes - 1] - start, 200, TOLERANCE_MS,
+                   "Finished after %lld ms", stamps[writes - 1] - start);
+    for (int i = 1; i < writes; i++) {
+        zassert_true(levels[i] > levels[i - 1], "Not rising at write %d", i);
+    }
+}
+
+ZTEST(pwm_ramp_suite, test_stop_holds_level)
+{
+    zassert_ok(pwm_ramp_start(200, 200, on_done));
+    run_for(100);
+    pwm_ramp_stop();
+
+    uint8_t held = pwm_ramp_get_brightness();
+    int held_writes = writes;
+
+    zassert_within(held, 100, FADE_STEP + 5, "Halfway level %d", held);
+    zassert_equal(done_calls, 1);
+    zassert_false(done_completed, "Stopped fade must not report completion");
+    zassert_equal(done_level, held);
+
+    run_for(150);
+    zassert_equal(writes, held_writes, "Output changed after stop");
+    zassert_equal(pwm_ramp_get_brightness(), held);
+}
+
+ZTEST(pwm_ramp_suite, test_retarget_continues_without_jump)
+{
+    int64_t start = k_uptime_get();
+
+    zassert_ok(pwm_ramp_start(255, 255, on_done));
+    run_for(100);
+
+    uint8_t reached = pwm_ramp_get_brightness();
+    int mark = writes;
+
+    /* Turn around: back to 50 within 100 ms from wherever it got */
+    zassert_ok(pwm_ramp_retarget(50, 100));
+    zassert_equal(done_calls, 0, "Retarget must keep the fade alive");
+    run_until_idle(300);
+
+    zassert_true(reached > 50, "Fade did not get going (%d)", reached);
+    zassert_true(max_jump(mark - 1) <= FADE_STEP, "Retarget jumped by %d", max_jump(mark - 1));
+    zassert_equal(done_calls, 1);
+    zassert_true(done_completed, "Retargeted fade should complete");
+    zassert_equal(pwm_ramp_get_brightness(), 50);
+    zassert_within(stamps[writes - 1] - start, 200, TOLERANCE_MS,
+                   "Retargeted fade ended at %lld ms", stamps[writes - 1] - start);
+}
+
+ZTEST(pwm_ramp_suite, test_start_supersedes_running_fade)
+{
+    zassert_ok(pwm_ramp_start(255, 200, on_done));
+    run_for(50);
+
+    uint8_t reached = pwm_ramp_get_brightness();
+
+    zassert_ok(pwm_ramp_start(0, 50, on_done_chain));
+    zassert_equal(done_calls, 1, "Replaced fade not reported");
+    zassert_false(done_completed);
+    zassert_equal(done_level, reached, "Replaced fade reported the wrong level");
+
+    run_until_idle(200);
+    zassert_equal(chained_calls, 1);
+    zassert_equal(pwm_ramp_get_brightness(), 0);
+    zassert_equal(done_calls, 1, "Old callback ran again");
+}
+
+ZTEST(pwm_ramp_suite, test_callback_can_chain)
+{
+    zassert_ok(pwm_ramp_start(100, 50, on_done_chain));
+    run_until_idle(300);
+
+    /* Up completed, and its callback ran the way back down */
+    zassert_equal(chained_calls, 1);
+    zassert_equal(done_calls, 1, "Chained fade never finished");
+    zassert_true(done_completed);
+    zassert_equal(pwm_ramp_get_brightness(), 0);
+}
+
+ZTEST(pwm_ramp_suite, test_immediate_cases)
+{
+    /* Zero duration jumps */
+    zassert_ok(pwm_ramp_start(80, 0, on_done));
+    zassert_false(pwm_ramp_is_active());
+    zassert_equal(pwm_ramp_get_brightness(), 80);
+    zassert_equal(done_calls, 1);
+    zassert_true(done_completed);
+
+    /* Already at the target */
+    zassert_ok(pwm_ramp_start(80, 500, on_done));
+    zassert_false(pwm_ramp_is_active());
+    zassert_equal(done_calls, 2);
+    zassert_true(done_completed);
+
+    /* A direct set cancels a fade */
+    zassert_ok(pwm_ramp_start(200, 500, on_done));
+    run_for(20);
+    pwm_ramp_set_brightness(10);
+    zassert_false(pwm_ramp_is_active());
+    zassert_equal(done_calls, 3);
+    zassert_false(done_completed);
+    run_for(50);
+    zassert_equal(pwm_ramp_get_brightness(), 10, "Cancelled fade kept writing");
+}
+
+void test_main(void)
+{
+    ztest_run_test_suites(NULL, false, 1, 1);
+}
@@ -0,0 +1,254 @@
+/**
+ * @file main.c
+ * @brief Tests for the DMA ramp backend on the DMA emulator.
+ *
+ * The timer glue is faked: the compare register is a RAM sink and pacing
+ * is recorded. The emulator advances the destination on every beat, so
+ * the sink keeps each compare value the channel emitted, in order, where
+ * a real timer's CCR would only hold the latest one.
+ *
+ * As in tests/pwm_ramp, the test thread stands in for the FSM worker.
+ */
+
+#include <zephyr/ztest.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zephyr/device.h>
+#include <zephyr/drivers/pwm.h>
+#include "pwm_ramp.h"
+#include "ramp_table.h"
+#include "fsm_sched.h"
+
+#define TOLERANCE_MS (CONFIG_ZBEAM_FSM_SCHED_SLACK_MS + 1)
+
+/* 1 kHz PWM whose period is exactly the table's full scale */
+#define FAKE_PERIOD_NS PWM_MSEC(1)
+#define FAKE_CYCLES_PER_SEC ((uint64_t)RAMP_TABLE_MAX_DUTY * 1000)
+
+static uint16_t ccr_sink[RAMP_TABLE_SIZE + 1];
+static uint32_t pacing;
+static int pacing_err;    /* Returned by the pacing glue when set */
+static bool no_ccr;       /* Glue has no compare register */
+
+static int done_calls;
+static uint8_t done_level;
+static bool done_completed;
+
+/* --- FAKE TIMER --- */
+
+static int fake_set_cycles(const struct device *dev, uint32_t channel, uint32_t period_cycles,
+                           uint32_t pulse_cycles, pwm_flags_t flags)
+{
+    return 0;
+}
+
+static int fake_get_cycles_per_sec(const struct device *dev, uint32_t channel, uint64_t *cycles)
+{
+    *cycles = FAKE_CYCLES_PER_SEC;
+    return 0;
+}
+
+static const struct pwm_driver_api fake_pwm_api = {
+    .set_cycles = fake_set_cycles,
+    .get_cycles_per_sec = fake_get_cycles_per_sec,
+};
+
+DEVICE_DEFINE(fake_pwm, "fake_pwm", NULL, NULL, NULL, NULL, POST_KERNEL,
+              CONFIG_KERNEL_INIT_PRIORITY_DEVICE, &fake_pwm_api);
+
+static const struct pwm_dt_spec fake_spec = {
+    .dev = DEVICE_GET(fake_pwm),
+    .channel = 0,
+    .period = FAKE_PERIOD_NS,
+};
+
+volatile uint16_t *pwm_ramp_dma_compare_reg(void)
+{
+    return no_ccr ? NULL : ccr_sink;
+}
+
+int pwm_ramp_dma_set_pacing(uint32_t periods)
+{
+    if (pacing_err) {
+        return pacing_err;
+    }
+    pacing = periods;
+    return 0;
+}
+
+static void on_done(uint8_t brightness, bool completed)
+{
+    done_calls++;
+    done_level = brightness;
+    done_completed = completed;
+}
+
+/* --- HELPERS --- */
+
+/* Act as the FSM worker until the fade ends or @p max_ms passes */
+static void run_until_idle(uint32_t max_ms)
+{
+    int64_t end = k_uptime_get() + max_ms;
+
+    while (pwm_ramp_is_active() && k_uptime_get() < end) {
+        fsm_sched_run_expired();
+        k_msleep(1);
+    }
+}
+
+/* Check the sink against the table, @p stride entries per value */
+static void assert_stream(uint8_t from, uint8_t to, int stride)
+{
+    int span = abs((int)to - (int)from);
+    int dir = to > from ? 1 : -1;
+    int count = DIV_ROUND_UP(span, stride);
+
+    for (int i = 0; i < count; i++) {
+        int level = from + dir * MIN((i + 1) * stride, span);
+
+        zassert_equal(ccr_sink[i], pwm_ramp_table[level],
+                      "Value %d is %d, expected table[%d] = %d", i, ccr_sink[i], level,
+                      pwm_ramp_table[level]);
+    }
+    zassert_equal(ccr_sink[count], 0xffff, "Stream ran past the target");
+}
+
+/* --- FIXTURE --- */
+
+static void *setup(void)
+{
+    zassert_ok(pwm_ramp_init(&fake_spec));
+    return NULL;
+}
+
+static void before(void *fixture)
+{
+    pwm_ramp_set_brightness(0);
+    memset(ccr_sink, 0xff, sizeof(ccr_sink));
+    pacing = 0;
+    pacing_err = 0;
+    no_ccr = false;
+    done_calls = 0;
+    done_level = 0;
+    done_completed = false;
+}
+
+ZTEST_SUITE(pwm_ramp_dma_suite, NULL, setup, before, NULL, NULL);
+
+/* --- TESTS --- */
+
+ZTEST(pwm_ramp_dma_suite, test_full_ramp_matches_table)
+{
+    int64_t start = k_uptime_get();
+
+    /* One table entry per PWM period */
+    zassert_ok(pwm_ramp_start(255, 255, on_done));
+    zassert_true(pwm_ramp_is_active());
+    zassert_equal(pacing, 1);
+
+    run_until_idle(400);
+
+    assert_stream(0, 255, 1);
+    zassert_equal(done_calls, 1);
+    zassert_true(done_completed, "Fade should report completion");
+    zassert_equal(done_level, 255);
+    zassert_equal(pwm_ramp_get_brightness(), 255);
+    zassert_within(k_uptime_get() - start, 255, TOLERANCE_MS,
+                   "Collected after %lld ms", k_uptime_get() - start);
+}
+
+ZTEST(pwm_ramp_dma_suite, test_slow_fade_down_is_paced)
+{
+    pwm_ramp_set_brightness(200);
+    zassert_equal(ccr_sink[0], pwm_ramp_table[200], "Direct write missed the CCR");
+    memset(ccr_sink, 0xff, sizeof(ccr_sink));
+
+    /* 100 entries over 1000 periods: each held for 10 */
+    zassert_ok(pwm_ramp_start(100, 1000, on_done));
+    zassert_equal(pacing, 10);
+
+    run_until_idle(1200);
+
+    assert_stream(200, 100, 1);
+    zassert_true(done_completed);
+    zassert_equal(pwm_ramp_get_brightness(), 100);
+}
+
+ZTEST(pwm_ramp_dma_suite, test_short_fade_strides)
+{
+    /* 255 entries in 50 periods: every 6th entry, still ending on 255 */
+    zassert_ok(pwm_ramp_start(255, 50, on_done));
+    zassert_equal(pacing, 1);
+
+    run_until_idle(200);
+
+    assert_stream(0, 255, 6);
+    zassert_true(done_completed);
+    zassert_equal(pwm_ramp_get_brightness(), 255);
+}
+
+ZTEST(pwm_ramp_dma_suite, test_retarget_restreams_from_reached_level)
+{
+    zassert_ok(pwm_ramp_start(255, 1000, on_done));
+
+    /* Let the (unpaced) emulator drain the stream before turning round */
+    k_msleep(10);
+    memset(ccr_sink, 0xff, sizeof(ccr_sink));
+
+    zassert_ok(pwm_ramp_retarget(50, 205));
+    zassert_equal(done_calls, 0, "Retarget must keep the fade alive");
+    run_until_idle(400);
+
+    assert_stream(255, 50, 1);
+    zassert_equal(done_calls, 1);
+    zassert_true(done_completed);
+    zassert_equal(pwm_ramp_get_brightness(), 50);
+}
+
+ZTEST(pwm_ramp_dma_suite, test_stop_reports_stream_position)
+{
+    zassert_ok(pwm_ramp_start(255, 1000, on_done));
+    k_msleep(10);
+    pwm_ramp_stop();
+
+    /* The emulator is not paced, so the whole stream is already out */
+    zassert_false(pwm_ramp_is_active());
+    zassert_equal(done_calls, 1);
+    zassert_false(done_completed, "Stopped fade must not report completion");
+    zassert_equal(done_level, 255);
+    zassert_equal(pwm_ramp_get_brightness(), 255);
+}
+
+ZTEST(pwm_ramp_dma_suite, test_no_pacing_falls_back_to_steps)
+{
+    pacing_err = -ENOTSUP;
+    zassert_ok(pwm_ramp_start(255, 100, on_done));
+    zassert_true(pwm_ramp_is_active());
+
+    run_until_idle(300);
+
+    /* Stepped through direct writes, nothing streamed */
+    zassert_equal(ccr_sink[0], pwm_ramp_table[255]);
+    zassert_equal(ccr_sink[1], 0xffff, "DMA ran without pacing");
+    zassert_equal(done_calls, 1);
+    zassert_true(done_completed);
+    zassert_equal(pwm_ramp_get_brightness(), 255);
+}
+
+ZTEST(pwm_ramp_dma_suite, test_init_refuses_missing_ccr)
+{
+    no_ccr = true;
+    zassert_equal(pwm_ramp_init(&fake_spec), -ENOTSUP);
+
+    /* The earlier init is untouched */
+    pwm_ramp_set_brightness(10);
+    zassert_equal(ccr_sink[0], pwm_ramp_table[10]);
+
+    no_ccr = false;
+    zassert_ok(pwm_ramp_init(&fake_spec));
+}
+
+void test_main(void)
+{
+    ztest_run_test_suites(NULL, false, 1, 1);
+}
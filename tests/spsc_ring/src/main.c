@@ -0,0 +1,166 @@
+/**
+ * @file main.c
+ * @brief SPSC ring tests and post/get microbenchmark against k_msgq.
+ *
+ * Cycle counts come from k_cycle_get_32(). On qemu_riscv32 (icount) they
+ * track executed instructions; native_sim's clock does not advance while
+ * code runs, so there the benchmark only reports (near) zero.
+ */
+
+#include <zephyr/ztest.h>
+#include <zephyr/kernel.h>
+#include "spsc_ring.h"
+#include "zbeam_msg.h"
+
+#define RING_DEPTH   8
+#define BENCH_ROUNDS 1000
+#define STREAM_LEN   2000
+
+SPSC_RING_DEFINE(ring, RING_DEPTH);
+K_MSGQ_DEFINE(bench_msgq, sizeof(struct zbeam_msg), RING_DEPTH, 4);
+
+#define PRODUCER_STACK_SIZE 1024
+K_THREAD_STACK_DEFINE(producer_stack, PRODUCER_STACK_SIZE);
+static struct k_thread producer_thread;
+
+/* Sequence number carried in count (low) and severity (high) */
+static struct zbeam_msg seq_msg(uint16_t seq)
+{
+    return (struct zbeam_msg){
+        .type = MSG_INPUT_EDGE,
+        .count = seq & 0xFF,
+        .severity = seq >> 8,
+    };
+}
+
+static uint16_t msg_seq(const struct zbeam_msg *msg)
+{
+    return msg->count | (msg->severity << 8);
+}
+
+static void before(void *fixture)
+{
+    struct zbeam_msg msg;
+
+    while (spsc_ring_get(&ring, &msg) == 0) {
+    }
+    k_msgq_purge(&bench_msgq);
+}
+
+ZTEST_SUITE(spsc_ring_suite, NULL, NULL, before, NULL, NULL);
+
+ZTEST(spsc_ring_suite, test_fifo_and_full)
+{
+    struct zbeam_msg msg;
+
+    zassert_equal(spsc_ring_get(&ring, &msg), -ENOMSG, "Empty ring returned a message");
+
+    for (int i = 0; i < RING_DEPTH; i++) {
+        msg = seq_msg(i);
+        zassert_equal(spsc_ring_put(&ring, &msg), i + 1, "Put %d: wrong waiting count", i);
+    }
+    msg = seq_msg(RING_DEPTH);
+    zassert_equal(spsc_ring_put(&ring, &msg), -ENOMSG, "Full ring accepted a message");
+    zassert_equal(spsc_ring_count(&ring), RING_DEPTH);
+
+    for (int i = 0; i < RING_DEPTH; i++) {
+        zassert_ok(spsc_ring_get(&ring, &msg));
+        zassert_equal(msg_seq(&msg), i, "Out of order");
+    }
+    zassert_equal(spsc_ring_count(&ring), 0);
+}
+
+ZTEST(spsc_ring_suite, test_index_wrap)
+{
+    struct zbeam_msg msg;
+
+    /* Free-running indices about to overflow */
+    atomic_set(&ring.head, (atomic_val_t)(UINT32_MAX - 2));
+    atomic_set(&ring.tail, (atomic_val_t)(UINT32_MAX - 2));
+
+    for (int i = 0; i < 3 * RING_DEPTH; i++) {
+        msg = seq_msg(i);
+        zassert_equal(spsc_ring_put(&ring, &msg), 1, "Drained ring should report 1");
+        zassert_ok(spsc_ring_get(&ring, &msg));
+        zassert_equal(msg_seq(&msg), i, "Corrupted across the wrap");
+    }
+    zassert_equal(spsc_ring_count(&ring), 0);
+}
+
+static void producer_entry(void *p1, void *p2, void *p3)
+{
+    for (uint16_t seq = 0; seq < STREAM_LEN; seq++) {
+        struct zbeam_msg msg = seq_msg(seq);
+
+        while (spsc_ring_put(&ring, &msg) < 0) {
+            k_usleep(1);
+        }
+    }
+}
+
+ZTEST(spsc_ring_suite, test_concurrent_stream)
+{
+    struct zbeam_msg msg;
+    uint16_t expect = 0;
+
+    k_thread_create(&producer_thread, producer_stack, PRODUCER_STACK_SIZE,
+                    producer_entry, NULL, NULL, NULL,
+                    K_PRIO_PREEMPT(1), 0, K_NO_WAIT);
+
+    while (expect < STREAM_LEN) {
+        if (spsc_ring_get(&ring, &msg) != 0) {
+            k_usleep(1);
+            continue;
+        }
+        zassert_equal(msg_seq(&msg), expect, "Got %d, expected %d", msg_seq(&msg), expect);
+        expect++;
+    }
+
+    k_thread_join(&producer_thread, K_FOREVER);
+    zassert_equal(spsc_ring_count(&ring), 0, "Producer overran the stream");
+}
+
+ZTEST(spsc_ring_suite, test_benchmark_vs_msgq)
+{
+    struct zbeam_msg msg = seq_msg(1);
+    struct zbeam_msg out;
+    uint32_t start, ring_post, ring_get, q_post, q_get;
+
+    /* Batches of RING_DEPTH, as the worker drains a burst */
+    ring_post = ring_get = 0;
+    for (int r = 0; r < BENCH_ROUNDS / RING_DEPTH; r++) {
+        start = k_cycle_get_32();
+        for (int i = 0; i < RING_DEPTH; i++) {
+            spsc_ring_put(&ring, &msg);
+        }
+        ring_post += k_cycle_get_32() - start;
+
+        start = k_cycle_get_32();
+        for (int i = 0; i < RING_DEPTH; i++) {
+            spsc_ring_get(&ring, &out);
+        }
+        ring_get += k_cycle_get_32() - start;
+    }
+
+    q_post = q_get = 0;
+    for (int r = 0; r < BENCH_ROUNDS / RING_DEPTH; r++) {
+        start = k_cycle_get_32();
+        for (int i = 0; i < RING_DEPTH; i++) {
+            k_msgq_put(&bench_msgq, &msg, K_NO_WAIT);
+        }
+        q_post += k_cycle_get_32() - start;
+
+        start = k_cycle_get_32();
+        for (int i = 0; i < RING_DEPTH; i++) {
+            k_msgq_get(&bench_msgq, &out, K_NO_WAIT);
+        }
+        q_get += k_cycle_get_32() - start;
+    }
+
+    int ops = (BENCH_ROUNDS / RING_DEPTH) * RING_DEPTH;
+
+    TC_PRINT("Cycles per op over %d ops: ring post %u get %u, k_msgq post %u get %u\n",
+             ops, ring_post / ops, ring_get / ops, q_post / ops, q_get / ops);
+    zassert_true(ring_post <= q_post, "Ring post slower than k_msgq_put");
+    zassert_true(ring_get <= q_get, "Ring get slower than k_msgq_get");
+}
@@ -10,9 +10,12 @@
 #include "multi_tap_input.h"
 #include "fsm_engine.h"
 #include "zbeam_msg.h"
+#include "safety_monitor.h"
 
 /* --- MOCKS --- */
 
+enum safety_fault safety_get_status(void) { return SAFETY_OK; }
+
 /* --- HELPERS --- */
 
 /* Helper to simulate press */
@@ -57,11 +60,11 @@ static void before(void *fixture)
         multi_tap_configure(100, 200); /* Fast test timings */
         multi_tap_input_init();
         ui_init();
-        fsm_init(get_start_node());
+        fsm_init(&ui_fsm_table, get_start_node());
         init = true;
     }
     multi_tap_input_reset();
-    fsm_init(get_start_node()); /* Reset to OFF */
+    fsm_init(&ui_fsm_table, get_start_node()); /* Reset to OFF */
     k_sleep(K_MSEC(50));
 }
 
@@ -0,0 +1,167 @@
+/**
+ * @file main.c
+ * @brief Replay tests for the adaptive click-timeout estimator.
+ *
+ * Traces are inter-tap gaps recorded from real sequences, in ms. Each
+ * sequence lists the gaps between its taps and is closed by END, so a
+ * single click is just END. Every sequence in a trace fitted within the
+ * stock 500 ms click timeout, so any gap reaching the learned timeout is
+ * a misclassified (split) sequence.
+ */
+
+#include <zephyr/ztest.h>
+#include <string.h>
+#include "tap_cadence.h"
+
+#define END 0
+#define MIN_MS CONFIG_ZBEAM_ADAPTIVE_TAP_MIN_MS
+#define MAX_MS CONFIG_ZBEAM_CLICK_TIMEOUT_MS
+
+/* Quick thumb: 1C-4C commands at ~140 ms */
+static const uint16_t trace_fast[] = {
+    150, 135, END, END, 160, 142, 128, END, 145, END, END,
+    170, 155, END, 138, END, 125, 148, 161, 132, END, END,
+    152, END, 140, 133, END, END, 165, 150, END, 118, END, END,
+    149, 137, 144, END, 158, END, END, 131, END, 187, 143, END,
+    END, 129, 152, END,
+};
+
+/* Deliberate user: ~320 ms gaps */
+static const uint16_t trace_slow[] = {
+    320, END, END, 285, 340, END, END, 372, END, 298, 315, END,
+    END, END, 355, 281, END, END, 330, END, 305, 362, 347, END,
+    END, 290, END, END, 318, END,
+};
+
+/* Cadence slowing steadily (cold hands, gloves) */
+static const uint16_t trace_drift[] = {
+    140, 150, END, 135, END, END, 160, 145, 155, END, 150, END,
+    END, 170, 165, END, 180, END, 175, 190, END, 200, END, END,
+    210, 195, END, 220, END, 215, 230, END, END, 240, END,
+    235, 250, END, 245, END, 260, 255, END, END,
+};
+
+struct replay_result {
+    int sequences;
+    int splits;             /* Gaps the learned timeout cut short */
+    uint32_t wait_ms;       /* Dead time before each commit, learned */
+    uint32_t fixed_wait_ms; /* Same with the configured timeout */
+};
+
+static struct tap_cadence tc;
+
+/* Mirror multi_tap_input: learn every gap, including ones cut short */
+static void replay(const uint16_t *trace, size_t len, struct replay_result *res)
+{
+    memset(res, 0, sizeof(*res));
+
+    for (size_t i = 0; i < len; i++) {
+        uint32_t timeout = tap_cadence_timeout(&tc, MIN_MS, MAX_MS);
+
+        if (trace[i] == END) {
+            res->sequences++;
+            res->wait_ms += timeout;
+            res->fixed_wait_ms += MAX_MS;
+            continue;
+        }
+        if (trace[i] >= timeout) {
+            res->splits++;
+        }
+        tap_cadence_sample(&tc, trace[i]);
+    }
+}
+
+static void before(void *fixture)
+{
+    tap_cadence_init(&tc);
+}
+
+ZTEST_SUITE(tap_cadence_suite, NULL, NULL, before, NULL, NULL);
+
+ZTEST(tap_cadence_suite, test_untrained_uses_configured)
+{
+    zassert_equal(tap_cadence_timeout(&tc, MIN_MS, MAX_MS), MAX_MS);
+
+    for (int i = 0; i < TAP_CADENCE_MIN_SAMPLES - 1; i++) {
+        tap_cadence_sample(&tc, 100);
+    }
+    zassert_equal(tap_cadence_timeout(&tc, MIN_MS, MAX_MS), MAX_MS,
+                  "Learned timeout used before enough samples");
+}
+
+ZTEST(tap_cadence_suite, test_bounds)
+{
+    for (int i = 0; i < 32; i++) {
+        tap_cadence_sample(&tc, 60);
+    }
+    zassert_equal(tap_cadence_timeout(&tc, MIN_MS, MAX_MS), MIN_MS, "Floor not applied");
+    zassert_equal(tap_cadence_timeout(&tc, 400, 300), 400, "Floor must win over ceiling");
+
+    for (int i = 0; i < 32; i++) {
+        tap_cadence_sample(&tc, 60000);
+    }
+    zassert_equal(tap_cadence_timeout(&tc, MIN_MS, MAX_MS), MAX_MS, "Ceiling not applied");
+}
+
+ZTEST(tap_cadence_suite, test_fast_user_waits_less)
+{
+    struct replay_result res;
+
+    replay(trace_fast, ARRAY_SIZE(trace_fast), &res);
+    printk("Fast: %d sequences, wait %u ms (fixed %u ms)\n",
+           res.sequences, res.wait_ms, res.fixed_wait_ms);
+
+    zassert_equal(res.splits, 0, "%d sequences misclassified", res.splits);
+    zassert_true(res.wait_ms * 4 < res.fixed_wait_ms * 3, "Less than 25%% saved");
+    zassert_true(tap_cadence_timeout(&tc, MIN_MS, MAX_MS) < 300, "Did not converge");
+}
+
+ZTEST(tap_cadence_suite, test_slow_user_keeps_timeout)
+{
+    struct replay_result res;
+
+    replay(trace_slow, ARRAY_SIZE(trace_slow), &res);
+
+    zassert_equal(res.splits, 0, "%d sequences misclassified", res.splits);
+    zassert_true(res.wait_ms <= res.fixed_wait_ms);
+    zassert_true(tap_cadence_timeout(&tc, MIN_MS, MAX_MS) > 400, "Slow gaps need a long timeout");
+}
+
+ZTEST(tap_cadence_suite, test_drifting_cadence)
+{
+    struct replay_result res;
+
+    replay(trace_drift, ARRAY_SIZE(trace_drift), &res);
+
+    zassert_equal(res.splits, 0, "%d sequences misclassified", res.splits);
+    zassert_true(res.wait_ms < res.fixed_wait_ms);
+}
+
+ZTEST(tap_cadence_suite, test_recovers_from_cadence_change)
+{
+    struct replay_result res;
+
+    /* Trained on a fast user, then handed to a slow one */
+    replay(trace_fast, ARRAY_SIZE(trace_fast), &res);
+    replay(trace_slow, ARRAY_SIZE(trace_slow), &res);
+
+    zassert_true(res.splits <= 1, "%d sequences misclassified", res.splits);
+    zassert_true(tap_cadence_timeout(&tc, MIN_MS, MAX_MS) > 400, "Timeout did not grow back");
+}
+
+ZTEST(tap_cadence_suite, test_pack_restore)
+{
+    struct tap_cadence copy;
+    struct replay_result res;
+    uint8_t mean, dev;
+
+    replay(trace_fast, ARRAY_SIZE(trace_fast), &res);
+    tap_cadence_pack(&tc, &mean, &dev);
+
+    tap_cadence_init(&copy);
+    tap_cadence_restore(&copy, mean, dev);
+
+    /* Each packed value loses under TAP_CADENCE_PACK_MS: at most 5 steps */
+    zassert_within(tap_cadence_timeout(&copy, MIN_MS, MAX_MS),
+                   tap_cadence_timeout(&tc, MIN_MS, MAX_MS), 5 * TAP_CADENCE_PACK_MS);
+}
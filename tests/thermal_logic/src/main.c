@@ -12,7 +12,8 @@ ZTEST(thermal_logic_suite, test_thermal_init)
 {
     thermal_init();
     /* After init, no throttle applied */
-    zassert_equal(thermal_apply_throttle(255), 255, "No throttle expected after init");
+    zassert_equal(thermal_apply_throttle(BRIGHTNESS_MAX), BRIGHTNESS_MAX,
+                  "No throttle expected after init");
     zassert_equal(thermal_get_temp_mc(), 25000, "Initial temp should be 25C");
 }
 
@@ -39,8 +40,8 @@ ZTEST(thermal_logic_suite, test_thermal_throttle_kicks_in)
     }
     
     /* Throttle should now be active */
-    uint8_t throttled = thermal_apply_throttle(255);
-    zassert_true(throttled < 255, "Throttle should reduce brightness");
+    brightness_t throttled = thermal_apply_throttle(BRIGHTNESS_MAX);
+    zassert_true(throttled < BRIGHTNESS_MAX, "Throttle should reduce brightness");
 }
 
 ZTEST(thermal_logic_suite, test_thermal_cooling)
@@ -0,0 +1,337 @@
+/**
+ * @file main.c
+ * @brief Turn-on latency tests for the key-down preview and momentary fast
+ *        path, plus the encoder brightness path.
+ *
+ * Key edges are injected through the input subsystem and travel the real
+ * path (input callback -> FSM worker -> multi-tap -> engine -> UI). The
+ * output stage is mocked to timestamp the first lit write.
+ */
+
+#include <zephyr/ztest.h>
+#include <zephyr/input/input.h>
+#include <zephyr/kernel.h>
+#include "ui_actions.h"
+#include "channel_manager.h"
+#include "multi_tap_input.h"
+#include "fsm_engine.h"
+#include "fsm_worker.h"
+#include "safety_monitor.h"
+
+#define MAX_TURN_ON_US 10000
+
+/* --- MOCKS --- */
+
+static volatile uint8_t last_level;
+static volatile uint32_t lit_cycles;    /* First non-zero write since reset */
+static volatile int dark_writes;        /* Zero writes after lighting up */
+static volatile int writes;
+static volatile int batt_reads;
+static enum safety_fault fault;
+
+void channel_apply_mix(brightness_t master_level)
+{
+    writes++;
+    if (master_level && !lit_cycles) {
+        lit_cycles = k_cycle_get_32();
+    } else if (!master_level && lit_cycles) {
+        dark_writes++;
+    }
+    last_level = BRIGHTNESS_LEVEL(master_level);
+}
+
+void channel_init(void) { }
+void channel_cycle_mode(void) { }
+bool channel_budget_enabled(void) { return false; }
+void channel_set_supply_mv(uint16_t mv) { }
+void pm_init(void) { }
+void pm_suspend(void) { }
+void pm_resume(void) { }
+void aux_init(void) { }
+void aux_cycle_mode(void) { }
+void batt_init(void) { }
+uint16_t batt_read_voltage_mv(void) { batt_reads++; return 4000; }
+void batt_calculate_blinks(uint16_t mv, uint8_t *major, uint8_t *minor) { *major = 4; *minor = 0; }
+void batt_calibrate_voltage(uint16_t actual_mv) { }
+void thermal_init(void) { }
+void thermal_update(uint8_t current_brightness) { }
+int32_t thermal_get_temp_mc(void) { return 25000; }
+void thermal_calibrate_current_temp(int32_t known_current_c) { }
+void thermal_set_limit(uint8_t limit_c) { }
+enum safety_fault safety_get_status(void) { return fault; }
+
+/* --- HELPERS --- */
+
+static void press_button(void)
+{
+    input_report_key(NULL, INPUT_KEY_0, 1, true, K_NO_WAIT);
+}
+
+static void release_button(void)
+{
+    input_report_key(NULL, INPUT_KEY_0, 0, true, K_NO_WAIT);
+}
+
+static void tap_click(void)
+{
+    press_button();
+    k_sleep(K_MSEC(50));
+    release_button();
+    k_sleep(K_MSEC(50));
+}
+
+static bool in_node_with(void (*action)(void))
+{
+    const struct fsm_node *node = fsm_get_current_node();
+
+    return node && node->action_routine == action;
+}
+
+/* --- FIXTURE --- */
+
+static void *setup(void)
+{
+    multi_tap_input_init();
+    multi_tap_set_press_hook(fsm_preview_press);
+    multi_tap_set_edge_hook(fsm_momentary_edge);
+    ui_init();
+    return NULL;
+}
+
+static void before(void *fixture)
+{
+    multi_tap_input_reset();
+    fsm_init(&ui_fsm_table, get_start_node()); /* OFF */
+    k_sleep(K_MSEC(50));
+    lit_cycles = 0;
+    dark_writes = 0;
+    fault = SAFETY_OK;
+}
+
+ZTEST_SUITE(ui_latency_suite, NULL, setup, before, NULL, NULL);
+
+/* --- TESTS --- */
+
+ZTEST(ui_latency_suite, test_turn_on_at_key_down)
+{
+    uint32_t pressed = k_cycle_get_32();
+
+    press_button();
+    k_sleep(K_MSEC(20));
+
+    zassert_not_equal(lit_cycles, 0, "Emitter not lit while the button is down");
+    uint32_t latency_us = k_cyc_to_us_floor32(lit_cycles - pressed);
+    printk("Key-down to light: %u us\n", latency_us);
+    zassert_true(latency_us < MAX_TURN_ON_US, "Turn-on took %u us", latency_us);
+    zassert_true(in_node_with(action_off), "Sequence must still be unresolved");
+
+    /* 1C resolves to ON at the same level: no dark gap */
+    release_button();
+    k_sleep(K_MSEC(CONFIG_ZBEAM_CLICK_TIMEOUT_MS + 100));
+    zassert_true(in_node_with(action_on), "1C should reach ON");
+    zassert_equal(last_level, ui_get_current_pwm(), "ON level differs from preview");
+    zassert_equal(dark_writes, 0, "Emitter blinked off before ON");
+}
+
+ZTEST(ui_latency_suite, test_unmapped_sequence_reverts)
+{
+    /* 3H is not mapped on OFF: the preview must be undone */
+    tap_click();
+    tap_click();
+    press_button();
+    k_sleep(K_MSEC(CONFIG_ZBEAM_HOLD_DURATION_MS + 100));
+
+    zassert_not_equal(lit_cycles, 0, "Preview should have lit the emitter");
+    zassert_equal(last_level, 0, "Unmapped sequence left the emitter on");
+    zassert_true(in_node_with(action_off), "Should stay in OFF");
+
+    release_button();
+    k_sleep(K_MSEC(50));
+}
+
+ZTEST(ui_latency_suite, test_hold_hands_over_to_ramp)
+{
+    /* 1H from OFF: preview at key-down, then moon and ramp take over */
+    press_button();
+    k_sleep(K_MSEC(20));
+    zassert_not_equal(lit_cycles, 0, "Emitter not lit at key-down");
+
+    k_sleep(K_MSEC(CONFIG_ZBEAM_HOLD_DURATION_MS + 50));
+    zassert_true(in_node_with(action_ramp), "1H should enter RAMP");
+    zassert_not_equal(last_level, 0, "Ramp should keep the emitter on");
+
+    release_button();
+    k_sleep(K_MSEC(50));
+}
+
+ZTEST(ui_latency_suite, test_detent_keeps_preview)
+{
+    /* A detent while the main button is down does not resolve its sequence */
+    press_button();
+    k_sleep(K_MSEC(20));
+    zassert_not_equal(lit_cycles, 0, "Emitter not lit at key-down");
+
+    input_report_rel(NULL, INPUT_REL_WHEEL, 1, true, K_NO_WAIT);
+    k_sleep(K_MSEC(20));
+    zassert_not_equal(last_level, 0, "Detent reverted the preview");
+    zassert_equal(dark_writes, 0, "Emitter flickered off mid-press");
+
+    release_button();
+    k_sleep(K_MSEC(CONFIG_ZBEAM_CLICK_TIMEOUT_MS + 100));
+    zassert_true(in_node_with(action_on), "1C should reach ON");
+    zassert_equal(dark_writes, 0, "Emitter blinked off before ON");
+}
+
+ZTEST(ui_latency_suite, test_no_preview_outside_off)
+{
+    /* Turn on, then a press in ON must not change the output early */
+    tap_click();
+    k_sleep(K_MSEC(CONFIG_ZBEAM_CLICK_TIMEOUT_MS + 100));
+    zassert_true(in_node_with(action_on), "1C should reach ON");
+
+    uint8_t level = last_level;
+
+    dark_writes = 0;
+    press_button();
+    k_sleep(K_MSEC(20));
+    zassert_equal(last_level, level, "Key-down in ON changed the output");
+    zassert_equal(dark_writes, 0, "Key-down in ON turned the emitter off");
+
+    release_button();
+    k_sleep(K_MSEC(CONFIG_ZBEAM_CLICK_TIMEOUT_MS + 100));
+    zassert_true(in_node_with(action_off), "1C from ON should reach OFF");
+}
+
+ZTEST(ui_latency_suite, test_preview_after_emergency_off)
+{
+    struct zbeam_msg msg = {.type = MSG_SAFETY_SHUTDOWN, .severity = 255};
+
+    zassert_ok(fsm_worker_post_msg(&msg));
+    k_sleep(K_MSEC(50));
+    zassert_true(in_node_with(action_off), "Emergency off should land in OFF");
+
+    /* The fault has cleared: the next 1C previews as usual */
+    lit_cycles = 0;
+    press_button();
+    k_sleep(K_MSEC(20));
+    zassert_not_equal(lit_cycles, 0, "No preview after an emergency off");
+
+    release_button();
+    k_sleep(K_MSEC(CONFIG_ZBEAM_CLICK_TIMEOUT_MS + 100));
+    zassert_true(in_node_with(action_on), "1C should reach ON");
+}
+
+ZTEST(ui_latency_suite, test_no_preview_during_fault)
+{
+    fault = SAFETY_FAULT_OVERTEMP;
+    press_button();
+    k_sleep(K_MSEC(20));
+    zassert_equal(lit_cycles, 0, "Preview lit the emitter with a live fault");
+
+    release_button();
+    k_sleep(K_MSEC(CONFIG_ZBEAM_CLICK_TIMEOUT_MS + 100));
+}
+
+ZTEST(ui_latency_suite, test_lockout_momentary_fast_path)
+{
+    /* 4C from OFF locks out; the last release lands before the node exists */
+    for (int i = 0; i < 4; i++) {
+        tap_click();
+    }
+    k_sleep(K_MSEC(CONFIG_ZBEAM_CLICK_TIMEOUT_MS + 100));
+    zassert_true(in_node_with(action_lockout), "4C should reach LOCKOUT");
+    zassert_equal(last_level, 0, "Lockout must be dark");
+
+    /* The key-down is written from the input callback, not the worker */
+    uint32_t pressed = k_cycle_get_32();
+
+    lit_cycles = 0;
+    press_button();
+    k_sleep(K_MSEC(5));
+    zassert_not_equal(lit_cycles, 0, "Emitter not lit while held in lockout");
+    uint32_t latency_us = k_cyc_to_us_floor32(lit_cycles - pressed);
+    printk("Lockout key-down to light: %u us\n", latency_us);
+    zassert_true(latency_us < MAX_TURN_ON_US, "Momentary took %u us", latency_us);
+
+    /* Holding past the hold threshold keeps the same level */
+    uint8_t level = last_level;
+
+    k_sleep(K_MSEC(CONFIG_ZBEAM_HOLD_DURATION_MS + 50));
+    zassert_equal(last_level, level, "Hold changed the momentary level");
+
+    release_button();
+    k_sleep(K_MSEC(5));
+    zassert_equal(last_level, 0, "Emitter still lit after release");
+    zassert_true(in_node_with(action_lockout), "1H must not leave LOCKOUT");
+}
+
+ZTEST(ui_latency_suite, test_lockout_from_on_stays_asleep)
+{
+    tap_click();
+    k_sleep(K_MSEC(CONFIG_ZBEAM_CLICK_TIMEOUT_MS + 100));
+    zassert_true(in_node_with(action_on), "1C should reach ON");
+
+    /* 4C from ON locks out: the thermal tick must not relight ON */
+    for (int i = 0; i < 4; i++) {
+        tap_click();
+    }
+    k_sleep(K_MSEC(CONFIG_ZBEAM_CLICK_TIMEOUT_MS + 100));
+    zassert_true(in_node_with(action_lockout), "4C from ON should reach LOCKOUT");
+    zassert_equal(last_level, 0, "Lockout must be dark");
+
+    int settled = writes;
+
+    /* Two thermal periods */
+    k_sleep(K_MSEC(1100));
+    zassert_equal(writes, settled, "%d output writes in lockout", writes - settled);
+    zassert_equal(last_level, 0, "Thermal tick relit the emitter");
+}
+
+ZTEST(ui_latency_suite, test_thermal_tick_without_budget)
+{
+    tap_click();
+    k_sleep(K_MSEC(CONFIG_ZBEAM_CLICK_TIMEOUT_MS + 100));
+    zassert_true(in_node_with(action_on), "1C should reach ON");
+
+    /* No emitter currents: the tick has no use for a battery sample */
+    batt_reads = 0;
+    k_sleep(K_MSEC(1100));
+    zassert_equal(batt_reads, 0, "%d ADC reads from the thermal tick", batt_reads);
+
+    tap_click();
+    k_sleep(K_MSEC(CONFIG_ZBEAM_CLICK_TIMEOUT_MS + 100));
+}
+
+ZTEST(ui_latency_suite, test_encoder_feeds_brightness)
+{
+    tap_click();
+    k_sleep(K_MSEC(CONFIG_ZBEAM_CLICK_TIMEOUT_MS + 100));
+    zassert_true(in_node_with(action_on), "1C should reach ON");
+
+    int level = ui_get_current_pwm();
+    int expect = MIN(level + 2 * CONFIG_ZBEAM_ENCODER_STEP, CONFIG_ZBEAM_BRIGHTNESS_CEILING);
+
+    input_report_rel(NULL, INPUT_REL_WHEEL, 1, true, K_NO_WAIT);
+    input_report_rel(NULL, INPUT_REL_WHEEL, 1, true, K_NO_WAIT);
+    k_sleep(K_MSEC(20));
+    zassert_equal(last_level, expect, "Two detents up: %d, expected %d", last_level, expect);
+
+    /* A big spin down stops at the floor */
+    input_report_rel(NULL, INPUT_REL_WHEEL, -100, true, K_NO_WAIT);
+    k_sleep(K_MSEC(20));
+    zassert_equal(last_level, CONFIG_ZBEAM_BRIGHTNESS_FLOOR, "Should clamp to the floor");
+    zassert_true(in_node_with(action_on), "Encoder must not leave ON");
+
+    /* Nothing mapped in OFF */
+    tap_click();
+    k_sleep(K_MSEC(CONFIG_ZBEAM_CLICK_TIMEOUT_MS + 100));
+    zassert_true(in_node_with(action_off), "1C from ON should reach OFF");
+    input_report_rel(NULL, INPUT_REL_WHEEL, 3, true, K_NO_WAIT);
+    k_sleep(K_MSEC(20));
+    zassert_equal(last_level, 0, "Encoder lit the emitter in OFF");
+}
+
+void test_main(void)
+{
+    ztest_run_test_suites(NULL, false, 1, 1);
+}